@@ -10,7 +10,8 @@ goto :skip_show_usage
 :show_usage
     echo Usage: %~n0%~x0 [--no-tests] [--debug] [^<cmake-generation-args^>...]
     echo  --debug Compile using Debug configuration (without optimizations) instead of Release.
-    echo  --no-tests Skip unit tests (Although no tests for AIBox plugin now)
+    echo  --no-tests Do not build and run the AIBox_ut unit tests, the AIBox_bench benchmarks and
+    echo      the allocation gate.
     goto :exit
 :skip_show_usage
 
@@ -28,7 +29,7 @@ if [%1] == [--no-tests] (
     shift
     set NO_TESTS=1
 ) else (
-    set NO_TESTS=1
+    set NO_TESTS=0
 )
 
 if [%1] == [--debug] (
@@ -39,6 +40,7 @@ if [%1] == [--debug] (
 )
 
 set GENERATOR_OPTIONS=-GNinja -DCMAKE_BUILD_TYPE=%BUILD_TYPE% -DCMAKE_C_COMPILER=cl.exe -DCMAKE_CXX_COMPILER=cl.exe
+if [%NO_TESTS%] == [0] set GENERATOR_OPTIONS=%GENERATOR_OPTIONS% -DaiboxWithTests=YES -DaiboxWithBench=YES
 
 echo on
     rmdir /S /Q "%BUILD_DIR%" 2>NUL
@@ -46,11 +48,20 @@ echo on
 
 call :build_AIBox %SOURCE_DIR% %1 %2 %3 %4 %5 %6 %7 %8 %9 || goto :exit
 
-if [%NO_TESTS%] == [1] echo NOTE: Unit tests were not run (AIBox plugin has no tests). & goto :skip_tests
+if [%NO_TESTS%] == [1] echo NOTE: Unit tests and benchmarks were not built and run. & goto :skip_tests
 echo on
-    cd "%BUILD_DIR%/unit_tests" || @goto :exit
+    cd "%BUILD_DIR%/%PLUGIN_NAME%" || @goto :exit
     ctest --output-on-failure -C %BUILD_TYPE% || @goto :exit
 @echo off
+
+:: The allocations per message gate needs a build with the allocation tracking.
+echo on
+    mkdir "%BUILD_DIR%\%PLUGIN_NAME%_allocations" || @goto :exit
+    cd "%BUILD_DIR%\%PLUGIN_NAME%_allocations" || @goto :exit
+    cmake "%SOURCE_DIR%" %GENERATOR_OPTIONS% -DaiboxAllocationTracking=YES %1 %2 %3 %4 %5 %6 %7 %8 %9 || @goto :exit
+    cmake --build . --target AIBox_bench || @goto :exit
+    ctest --output-on-failure -C %BUILD_TYPE% -R "^AIBox_allocations$" || @goto :exit
+@echo off
 :skip_tests
 
 echo:
@@ -10,7 +10,8 @@ if [[ $# > 0 && ($1 == "/?" || $1 == "-h" || $1 == "--help") ]]
 then
     echo "Usage: $(basename "$0") [--no-tests] [--debug] [<cmake-generation-args>...]"
     echo " --debug Compile using Debug configuration (without optimizations) instead of Release."
-    echo " --no-tests Skip unit tests (Although no tests for AIBox plugin now)"
+    echo " --no-tests Do not build and run the AIBox_ut unit tests, the AIBox_bench benchmarks and"
+    echo "     the allocation gate."
     exit
 fi
 
@@ -24,7 +25,7 @@ then
     shift
     NO_TESTS=1
 else
-    NO_TESTS=1
+    NO_TESTS=0
 fi
 
 if [[ $# > 0 && $1 == "--debug" ]]
@@ -61,6 +62,11 @@ case "$(uname -s)" in #< Check if running in Windows from Cygwin/MinGW.
         ;;
 esac
 
+if [[ $NO_TESTS == 0 ]]
+then
+    GEN_OPTIONS+=( -DaiboxWithTests=YES -DaiboxWithBench=YES )
+fi
+
 (set -x #< Log each command.
     rm -rf "$BUILD_DIR/"
 )
@@ -91,12 +97,25 @@ echo ""
 
 if [[ $NO_TESTS == 1 ]]
 then
-    echo "NOTE: Unit tests were not run (AIBox plugin has no tests)."
+    echo "NOTE: Unit tests and benchmarks were not built and run."
 else
     (set -x #< Log each command.
-        cd "$BUILD_DIR/unit_tests"
+        cd "$BUILD_DIR/$PLUGIN"
         ctest --output-on-failure -C $BUILD_TYPE
     )
+
+    # The allocations per message gate needs a build with the allocation tracking.
+    (set -x #< Log each command.
+        mkdir -p "$BUILD_DIR/${PLUGIN}_allocations"
+        cd "$BUILD_DIR/${PLUGIN}_allocations"
+
+        cmake "$SOURCE_DIR" `# allow empty array #` ${GEN_OPTIONS[@]+"${GEN_OPTIONS[@]}"} \
+            -DaiboxAllocationTracking=YES "$@"
+        cmake --build . --target AIBox_bench \
+            `# allow empty array #` ${BUILD_OPTIONS[@]+"${BUILD_OPTIONS[@]}"}
+        ctest --output-on-failure -C $BUILD_TYPE -R "^AIBox_allocations$"
+    )
+    echo "NOTE: For the measurements, run: $BUILD_DIR/$PLUGIN/AIBox_bench --benchmark"
 fi
 echo ""
 
@@ -11,7 +11,10 @@
 #include <memory>
 #include <map>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <cstring>
+#include <cmath>
 
 namespace nx {
 namespace kit {
@@ -58,6 +61,340 @@ std::ostream*& stream()
     return stream;
 }
 
+namespace {
+
+/** Serializes writing to stream(), so that the lines from different threads do not interleave. */
+std::mutex& streamMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+void writeToStream(const std::string& text)
+{
+    const std::lock_guard<std::mutex> lock(streamMutex());
+    *stream() << text << std::flush;
+}
+
+/**
+ * Lines printed by a single thread, passed to the writer thread without locks: the printing
+ * thread is the only producer, and the writer thread is the only consumer.
+ */
+class LineRing
+{
+public:
+    bool tryPush(std::string* line)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == kCapacity)
+            return false;
+        m_slots[tail % kCapacity].swap(*line);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(std::string* line)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        line->swap(m_slots[head % kCapacity]);
+        m_slots[head % kCapacity].clear();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+    }
+
+    bool isHalfFull() const
+    {
+        return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_relaxed)
+            >= kCapacity / 2;
+    }
+
+private:
+    static constexpr size_t kCapacity = 1024;
+
+    std::string m_slots[kCapacity];
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
+};
+
+class AsyncWriter
+{
+public:
+    static AsyncWriter& instance()
+    {
+        static AsyncWriter writer;
+        return writer;
+    }
+
+    ~AsyncWriter()
+    {
+        setEnabled(false);
+        isDestroyed.store(true, std::memory_order_release);
+    }
+
+    bool isEnabled() const { return m_isEnabled.load(std::memory_order_acquire); }
+
+    void setEnabled(bool enabled)
+    {
+        const std::lock_guard<std::mutex> enableLock(m_enableMutex);
+        if (enabled == m_isEnabled)
+            return;
+
+        if (enabled)
+        {
+            m_isStopped = false;
+            m_thread = std::thread([this]() { run(); });
+            m_isEnabled = true;
+            return;
+        }
+
+        m_isEnabled = false;
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopped = true;
+        }
+        m_wakeUp.notify_one();
+        m_thread.join();
+        drain();
+    }
+
+    /** @return False if the line could not be queued, then it is to be written synchronously. */
+    bool push(std::string* line)
+    {
+        // Owned by the thread and by the writer; the writer forgets it when the thread exits.
+        static thread_local std::shared_ptr<LineRing> ring;
+        if (!ring)
+        {
+            ring = std::make_shared<LineRing>();
+            const std::lock_guard<std::mutex> lock(m_ringsMutex);
+            m_rings.push_back(ring);
+        }
+
+        if (!ring->tryPush(line))
+        {
+            // Write the queued lines first, so that the lines of the thread keep their order.
+            drain();
+            return false;
+        }
+        if (ring->isHalfFull())
+            m_wakeUp.notify_one();
+        return true;
+    }
+
+    void drain()
+    {
+        const std::lock_guard<std::mutex> drainLock(m_drainMutex);
+
+        std::vector<std::shared_ptr<LineRing>> rings;
+        {
+            const std::lock_guard<std::mutex> lock(m_ringsMutex);
+            rings = m_rings;
+        }
+
+        std::string text;
+        std::string line;
+        for (const auto& ring: rings)
+        {
+            while (ring->tryPop(&line))
+                text += line;
+        }
+        if (!text.empty())
+            writeToStream(text);
+
+        // The rings of the exited threads are owned only by this vector and the local copy.
+        const std::lock_guard<std::mutex> lock(m_ringsMutex);
+        m_rings.erase(
+            std::remove_if(m_rings.begin(), m_rings.end(),
+                [](const std::shared_ptr<LineRing>& ring)
+                {
+                    return ring.use_count() == 2 && ring->isEmpty();
+                }),
+            m_rings.end());
+    }
+
+    /** Read by the printing threads, which may run during the static deinitialization. */
+    static std::atomic<bool> isDestroyed;
+
+private:
+    AsyncWriter() = default;
+
+    void run()
+    {
+        static constexpr std::chrono::milliseconds kWriteInterval(20);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_isStopped)
+        {
+            m_wakeUp.wait_for(lock, kWriteInterval);
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+private:
+    std::mutex m_enableMutex;
+    std::atomic<bool> m_isEnabled{false};
+
+    std::mutex m_ringsMutex;
+    std::vector<std::shared_ptr<LineRing>> m_rings;
+
+    std::mutex m_drainMutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_isStopped = false;
+    std::thread m_thread;
+};
+
+std::atomic<bool> AsyncWriter::isDestroyed{false};
+
+std::atomic<int>& rateLimit()
+{
+    static std::atomic<int> maxLinesPerSecond{0};
+    return maxLinesPerSecond;
+}
+
+void writeLine(std::string* line)
+{
+    // Lines printed during the static deinitialization are written synchronously.
+    if (!AsyncWriter::isDestroyed.load(std::memory_order_acquire))
+    {
+        AsyncWriter& writer = AsyncWriter::instance();
+        if (writer.isEnabled() && writer.push(line))
+            return;
+    }
+    writeToStream(*line);
+}
+
+/** Line being collected by NX_PRINT; nested if an NX_PRINT argument prints too. */
+struct PendingLine
+{
+    std::ostringstream stream;
+    int droppedBefore = 0; /**< Lines dropped by the rate limit, to be reported first. */
+    const detail::CallSite* callSite = nullptr;
+};
+
+struct PendingLines
+{
+    std::vector<std::unique_ptr<PendingLine>> lines; /**< Reused to avoid allocations. */
+    size_t depth = 0;
+};
+
+PendingLines& pendingLines()
+{
+    static thread_local PendingLines pendingLines;
+    return pendingLines;
+}
+
+int64_t steadyClockMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @return Whether the call site is allowed to print now; if so, outDroppedBefore receives the
+ *     number of the lines dropped since the previous printed one.
+ */
+bool acquireRateLimit(detail::CallSite* callSite, int* outDroppedBefore)
+{
+    *outDroppedBefore = 0;
+    const int maxLinesPerSecond = rateLimit().load(std::memory_order_relaxed);
+    if (maxLinesPerSecond <= 0)
+        return true;
+
+    const int64_t nowMs = steadyClockMs();
+    int64_t windowStartMs = callSite->windowStartMs.load(std::memory_order_relaxed);
+    if (nowMs - windowStartMs >= 1000
+        && callSite->windowStartMs.compare_exchange_strong(windowStartMs, nowMs))
+    {
+        callSite->linesInWindow.store(0, std::memory_order_relaxed);
+        *outDroppedBefore = callSite->droppedLines.exchange(0);
+    }
+
+    if (callSite->linesInWindow.fetch_add(1, std::memory_order_relaxed) >= maxLinesPerSecond)
+    {
+        callSite->droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void setAsyncOutput(bool enabled)
+{
+    AsyncWriter::instance().setEnabled(enabled);
+}
+
+void flushOutput()
+{
+    AsyncWriter::instance().drain();
+}
+
+void setRateLimit(int maxLinesPerSecond)
+{
+    rateLimit().store(maxLinesPerSecond, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+bool beginLine(CallSite* callSite)
+{
+    int droppedBefore = 0;
+    if (!acquireRateLimit(callSite, &droppedBefore))
+        return false;
+
+    PendingLines& pending = pendingLines();
+    if (pending.depth == pending.lines.size())
+        pending.lines.emplace_back(new PendingLine);
+    PendingLine& line = *pending.lines[pending.depth++];
+
+    line.stream.str(std::string());
+    line.stream.clear();
+    line.callSite = callSite;
+    line.droppedBefore = droppedBefore;
+    return true;
+}
+
+std::ostream* lineStream()
+{
+    PendingLines& pending = pendingLines();
+    if (pending.depth == 0)
+        return stream();
+    return &pending.lines[pending.depth - 1]->stream;
+}
+
+void finishLine()
+{
+    PendingLines& pending = pendingLines();
+    if (pending.depth == 0)
+        return;
+    PendingLine& line = *pending.lines[--pending.depth];
+
+    if (line.droppedBefore > 0)
+    {
+        std::string summary = printPrefix(line.callSite->file) + format(
+            "%d lines dropped by the rate limit at line %d\n",
+            line.droppedBefore, line.callSite->line);
+        writeLine(&summary);
+    }
+
+    // Empty if NX_DEBUG_STREAM is redefined and the line went elsewhere.
+    std::string text = line.stream.str();
+    if (!text.empty())
+        writeLine(&text);
+}
+
+} // namespace detail
+
 namespace detail {
 
 std::string printPrefix(const char* file)
@@ -352,6 +689,326 @@ void Fps::mark(const char* markStr /*= nullptr */)
 
 } // namespace detail
 
+//-------------------------------------------------------------------------------------------------
+// Profile
+
+static int highestBit(uint64_t value)
+{
+    #if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+    #else
+        int result = 0;
+        while (value >>= 1)
+            ++result;
+        return result;
+    #endif
+}
+
+int LogLinearHistogram::bucketOf(uint64_t value)
+{
+    if (value < (uint64_t) kSubBuckets)
+        return (int) value;
+    const int exponent = highestBit(value);
+    const int shift = exponent - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + (int) ((value >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t LogLinearHistogram::bucketLowerBound(int bucket)
+{
+    if (bucket < kSubBuckets)
+        return (uint64_t) bucket;
+    const int shift = bucket / kSubBuckets - 1;
+    return (uint64_t) (kSubBuckets + bucket % kSubBuckets) << shift;
+}
+
+double LogLinearHistogram::bucketValue(int bucket)
+{
+    if (bucket < kSubBuckets)
+        return bucket;
+    const int shift = bucket / kSubBuckets - 1;
+    return (double) bucketLowerBound(bucket) + (double) ((uint64_t) 1 << shift) / 2;
+}
+
+int LogLinearHistogram::percentileBucket(const uint64_t* counts, double fraction)
+{
+    const uint64_t total = std::accumulate(counts, counts + kBucketCount, (uint64_t) 0);
+    if (total == 0)
+        return -1;
+
+    const uint64_t rank = std::max((uint64_t) std::ceil(fraction * (double) total), (uint64_t) 1);
+    uint64_t accumulated = 0;
+    for (int i = 0; i < kBucketCount; ++i)
+    {
+        accumulated += counts[i];
+        if (accumulated >= rank)
+            return i;
+    }
+    return kBucketCount - 1;
+}
+
+namespace {
+
+/**
+ * Node of the zone tree of a thread. The statistics are written only by the owning thread, so
+ * they are updated with plain loads and stores of the atomics, which are read by the reporter.
+ */
+struct ProfileNode
+{
+    ProfileNode(const char* name, ProfileNode* parent): name(name), parent(parent) {}
+
+    const char* const name;
+    ProfileNode* const parent;
+
+    /** Modified only by the owning thread, under ThreadProfile::mutex. */
+    std::vector<ProfileNode*> children;
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::atomic<uint64_t> buckets[LogLinearHistogram::kBucketCount] = {};
+
+    void add(uint64_t durationNs)
+    {
+        increment(&count, 1);
+        increment(&totalNs, durationNs);
+        if (durationNs > maxNs.load(std::memory_order_relaxed))
+            maxNs.store(durationNs, std::memory_order_relaxed);
+        increment(&buckets[LogLinearHistogram::bucketOf(durationNs)], 1);
+    }
+
+    void reset()
+    {
+        count.store(0, std::memory_order_relaxed);
+        totalNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+        for (auto& bucket: buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static void increment(std::atomic<uint64_t>* value, uint64_t delta)
+    {
+        value->store(value->load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+};
+
+struct ThreadProfile
+{
+    std::mutex mutex; /**< Guards the tree structure against the reporter. */
+    std::deque<ProfileNode> nodes; /**< Does not move the nodes on growth. */
+    ProfileNode* current = nullptr;
+
+    ThreadProfile()
+    {
+        nodes.emplace_back("", nullptr);
+        current = &nodes.front();
+    }
+};
+
+int64_t steadyClockNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Zones of all threads with the same chain of names. */
+struct MergedZone
+{
+    std::string name;
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(LogLinearHistogram::kBucketCount);
+    std::vector<std::unique_ptr<MergedZone>> children; /**< In the order of appearance. */
+
+    void merge(const ProfileNode& node)
+    {
+        count += node.count.load(std::memory_order_relaxed);
+        totalNs += node.totalNs.load(std::memory_order_relaxed);
+        maxNs = std::max(maxNs, node.maxNs.load(std::memory_order_relaxed));
+        for (int i = 0; i < LogLinearHistogram::kBucketCount; ++i)
+            buckets[i] += node.buckets[i].load(std::memory_order_relaxed);
+
+        for (const ProfileNode* childNode: node.children)
+            child(childNode->name)->merge(*childNode);
+    }
+
+    void merge(const MergedZone& zone)
+    {
+        count += zone.count;
+        totalNs += zone.totalNs;
+        maxNs = std::max(maxNs, zone.maxNs);
+        for (int i = 0; i < LogLinearHistogram::kBucketCount; ++i)
+            buckets[i] += zone.buckets[i];
+
+        for (const auto& zoneChild: zone.children)
+            child(zoneChild->name)->merge(*zoneChild);
+    }
+
+    double percentileNs(double fraction) const
+    {
+        const int bucket = LogLinearHistogram::percentileBucket(buckets.data(), fraction);
+        return (bucket < 0) ? 0.0 : LogLinearHistogram::bucketValue(bucket);
+    }
+
+    void print(std::string* report, int depth) const
+    {
+        *report += format("%-40s %10llu %12.3f %10.1f %10.1f %10.1f %10.1f\n",
+            (std::string(depth * 4, ' ') + name).c_str(),
+            (unsigned long long) count,
+            totalNs / 1e6,
+            count ? (totalNs / 1e3 / (double) count) : 0.0,
+            percentileNs(0.5) / 1e3,
+            percentileNs(0.99) / 1e3,
+            maxNs / 1e3);
+        for (const auto& zone: children)
+            zone->print(report, depth + 1);
+    }
+
+private:
+    /** @return The child with the given name, added if there is none yet. */
+    MergedZone* child(const std::string& childName)
+    {
+        for (const auto& zone: children)
+        {
+            if (zone->name == childName)
+                return zone.get();
+        }
+        children.emplace_back(new MergedZone);
+        children.back()->name = childName;
+        return children.back().get();
+    }
+};
+
+struct ProfileRegistry
+{
+    std::mutex mutex;
+
+    /** Profiles of the running threads, owned by the threads themselves. */
+    std::vector<ThreadProfile*> threads;
+
+    /**
+     * Statistics of the exited threads, merged here so that they are still reported, while the
+     * memory stays bounded by the number of distinct zones rather than the number of threads.
+     */
+    MergedZone retired;
+};
+
+ProfileRegistry& profileRegistry()
+{
+    static ProfileRegistry registry;
+    return registry;
+}
+
+/** Registers the profile of its thread, and retires it when the thread exits. */
+class ThreadProfileOwner
+{
+public:
+    ThreadProfileOwner()
+    {
+        ProfileRegistry& registry = profileRegistry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(&m_profile);
+    }
+
+    ~ThreadProfileOwner()
+    {
+        ProfileRegistry& registry = profileRegistry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.erase(
+            std::find(registry.threads.begin(), registry.threads.end(), &m_profile));
+        registry.retired.merge(m_profile.nodes.front());
+    }
+
+    ThreadProfile& profile() { return m_profile; }
+
+private:
+    ThreadProfile m_profile;
+};
+
+ThreadProfile& threadProfile()
+{
+    static thread_local ThreadProfileOwner owner;
+    return owner.profile();
+}
+
+} // namespace
+
+std::string profileReport()
+{
+    MergedZone root;
+    {
+        // Held throughout, so that a thread exiting meanwhile is counted exactly once.
+        ProfileRegistry& registry = profileRegistry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        root.merge(registry.retired);
+        for (ThreadProfile* const thread: registry.threads)
+        {
+            const std::lock_guard<std::mutex> threadLock(thread->mutex);
+            root.merge(thread->nodes.front());
+        }
+    }
+
+    std::string report = format("%-40s %10s %12s %10s %10s %10s %10s\n",
+        "zone", "count", "total ms", "mean us", "p50 us", "p99 us", "max us");
+    for (const auto& zone: root.children)
+        zone->print(&report, /*depth*/ 0);
+    return report;
+}
+
+void resetProfile()
+{
+    ProfileRegistry& registry = profileRegistry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired = MergedZone();
+    for (ThreadProfile* const thread: registry.threads)
+    {
+        const std::lock_guard<std::mutex> threadLock(thread->mutex);
+        for (auto& node: thread->nodes)
+            node.reset();
+    }
+}
+
+namespace detail {
+
+void ProfileZone::enter(const char* name)
+{
+    ThreadProfile& profile = threadProfile();
+    ProfileNode* const parent = profile.current;
+
+    ProfileNode* node = nullptr;
+    for (ProfileNode* child: parent->children)
+    {
+        // Usually the same literal, so the pointers are compared first.
+        if (child->name == name || strcmp(child->name, name) == 0)
+        {
+            node = child;
+            break;
+        }
+    }
+    if (!node)
+    {
+        const std::lock_guard<std::mutex> lock(profile.mutex);
+        profile.nodes.emplace_back(name, parent);
+        node = &profile.nodes.back();
+        parent->children.push_back(node);
+    }
+
+    profile.current = node;
+    m_node = node;
+    m_startTimeNs = steadyClockNs();
+}
+
+void ProfileZone::leave()
+{
+    const int64_t durationNs = steadyClockNs() - m_startTimeNs;
+    ProfileNode* const node = static_cast<ProfileNode*>(m_node);
+    node->add((uint64_t) std::max<int64_t>(durationNs, 0));
+    threadProfile().current = node->parent;
+}
+
+} // namespace detail
+
 } // namespace debug
 } // namespace kit
 } // namespace nx
@@ -9,6 +9,7 @@
  * This unit can be compiled in the context of any C++ project.
  */
 
+#include <atomic>
 #include <iostream>
 #include <stdint.h>
 #include <functional>
@@ -67,8 +68,12 @@ NX_KIT_API std::string srcFileBaseNameWithoutExt(const std::string& file);
 #endif
 
 #if !defined(NX_DEBUG_STREAM)
-    /** Redefine if needed; used for all output by other macros. */
-    #define NX_DEBUG_STREAM *::nx::kit::debug::stream()
+    /**
+     * Redefine if needed; used for all output by other macros. By default, collects the line
+     * printed by NX_PRINT, which is then written to stream() - see setAsyncOutput() and
+     * setRateLimit().
+     */
+    #define NX_DEBUG_STREAM *::nx::kit::debug::detail::lineStream()
 #endif
 
 #if !defined(NX_DEBUG_ENDL)
@@ -82,16 +87,47 @@ NX_KIT_API std::string srcFileBaseNameWithoutExt(const std::string& file);
  */
 NX_KIT_API std::ostream*& stream();
 
+/**
+ * Makes the lines printed via the default NX_DEBUG_STREAM be written to stream() by a background
+ * thread, so that the printing threads do not wait for the output. A thread printing faster than
+ * the lines are written falls back to writing them itself, so no line is lost. Disabling writes
+ * the pending lines before returning. Initially disabled.
+ */
+NX_KIT_API void setAsyncOutput(bool enabled);
+
+/** Waits until the lines printed so far are written to stream(). */
+NX_KIT_API void flushOutput();
+
+/**
+ * Limits the number of lines each NX_PRINT call site may print via the default NX_DEBUG_STREAM
+ * per second; the number of the dropped lines is printed when the call site prints again.
+ * @param maxLinesPerSecond 0 means unlimited, which is the initial value.
+ */
+NX_KIT_API void setRateLimit(int maxLinesPerSecond);
+
 #if !defined(NX_PRINT)
     /**
      * Print the args to NX_DEBUG_STREAM, starting with NX_PRINT_PREFIX and ending with
-     * NX_DEBUG_ENDL. Redefine if needed.
+     * NX_DEBUG_ENDL. The args are not evaluated if the line is dropped by the rate limit.
+     * Redefine if needed.
      */
     #define NX_PRINT /* << args... */ \
-        /* Allocate a temp value, which prints endl in its destructor, in the "<<" expression. */ \
-        ( []() { struct Endl { ~Endl() { NX_DEBUG_STREAM NX_DEBUG_ENDL; } }; \
-            return std::make_shared<Endl>(); }() ) /*operator,*/, \
-        NX_DEBUG_STREAM << NX_PRINT_PREFIX
+        for (/* Executed either once or never, depending on the rate limit of the call site. */ \
+            ::nx::kit::debug::detail::PrintLine NX_KIT_DEBUG_DETAIL_CONCAT(nxPrint_, __LINE__)( \
+                []() \
+                { \
+                    static ::nx::kit::debug::detail::CallSite callSite(__FILE__, __LINE__); \
+                    return &callSite; \
+                }()); \
+            NX_KIT_DEBUG_DETAIL_CONCAT(nxPrint_, __LINE__).isOpen(); \
+            (void) (NX_DEBUG_STREAM NX_DEBUG_ENDL), \
+                NX_KIT_DEBUG_DETAIL_CONCAT(nxPrint_, __LINE__).close() \
+        ) NX_DEBUG_STREAM << NX_PRINT_PREFIX
+#endif
+
+#if !defined(NX_DEBUG_OUTPUT_COMPILED)
+    /** Redefine to 0 to compile NX_OUTPUT out, regardless of NX_DEBUG_ENABLE_OUTPUT. */
+    #define NX_DEBUG_OUTPUT_COMPILED 1
 #endif
 
 /**
@@ -100,7 +136,8 @@ NX_KIT_API std::ostream*& stream();
 #define NX_OUTPUT /* << args... */ \
     for (/* Executed either once or never; `for` instead of `if` gives no warnings. */ \
         int NX_KIT_DEBUG_DETAIL_CONCAT(nxOutput_, __line__) = 0; \
-        NX_KIT_DEBUG_DETAIL_CONCAT(nxOutput_, __line__) != 1 && (NX_DEBUG_ENABLE_OUTPUT); \
+        NX_KIT_DEBUG_DETAIL_CONCAT(nxOutput_, __line__) != 1 \
+            && (NX_DEBUG_OUTPUT_COMPILED) && (NX_DEBUG_ENABLE_OUTPUT); \
         ++NX_KIT_DEBUG_DETAIL_CONCAT(nxOutput_, __line__) \
     ) NX_PRINT
 
@@ -240,6 +277,63 @@ NX_KIT_API std::string hexDumpLine(const char* bytes, int size, int bytesPerLine
     } \
 } while (0)
 
+//-------------------------------------------------------------------------------------------------
+// Profile
+
+#if !defined(NX_DEBUG_ENABLE_PROFILE)
+    /** Redefine if needed. */
+    #define NX_DEBUG_ENABLE_PROFILE NX_DEBUG_INI enableProfile
+#endif
+
+/**
+ * Measures the time from this point to the end of the enclosing scope as a profiler zone; does
+ * nothing if !NX_DEBUG_ENABLE_PROFILE. A zone entered while another zone of the same thread is
+ * open is nested into it. The statistics are collected per thread without locking, and are
+ * aggregated per the chain of the zone names by profileReport().
+ * @param NAME String literal.
+ */
+#define NX_PROFILE_ZONE(NAME) \
+    ::nx::kit::debug::detail::ProfileZone NX_KIT_DEBUG_DETAIL_CONCAT(nxProfileZone_, __LINE__)( \
+        (NX_DEBUG_ENABLE_PROFILE) ? (NAME) : nullptr)
+
+/**
+ * @return Table of the NX_PROFILE_ZONE statistics of all threads, as a tree of the zones, with
+ *     the count, the total time, and the mean, median, 99th percentile and max durations.
+ */
+NX_KIT_API std::string profileReport();
+
+/** Forgets the NX_PROFILE_ZONE statistics collected so far. */
+NX_KIT_API void resetProfile();
+
+/**
+ * Bucket math of the profiler histograms, for the code keeping histograms of its own:
+ * log-linear buckets, kSubBuckets per power of two, so that the relative error of a percentile
+ * is within 1 / kSubBuckets at any scale. The values below kSubBuckets have a bucket each.
+ */
+class NX_KIT_API LogLinearHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static int bucketOf(uint64_t value);
+
+    /** @return The least value of the bucket. */
+    static uint64_t bucketLowerBound(int bucket);
+
+    /** @return The middle of the range of the values of the bucket. */
+    static double bucketValue(int bucket);
+
+    /**
+     * Finds the bucket of a percentile by the nearest-rank method.
+     * @param counts Number of the values in each of the kBucketCount buckets.
+     * @param fraction Percentile as a fraction of 1; the rank is at least 1.
+     * @return The bucket holding the percentile, or -1 if there are no values.
+     */
+    static int percentileBucket(const uint64_t* counts, double fraction);
+};
+
 //-------------------------------------------------------------------------------------------------
 // Implementation
 
@@ -285,6 +379,59 @@ inline bool doAssert(
 /** @param file Supply __FILE__. */
 NX_KIT_API std::string printPrefix(const char* file);
 
+/** State of the rate limiting of an NX_PRINT call site. */
+struct CallSite
+{
+    CallSite(const char* file, int line): file(file), line(line) {}
+
+    const char* const file;
+    const int line;
+    std::atomic<int64_t> windowStartMs{0};
+    std::atomic<int> linesInWindow{0};
+    std::atomic<int> droppedLines{0};
+};
+
+/**
+ * Starts collecting a line printed via the default NX_DEBUG_STREAM, unless the rate limit of the
+ * call site drops it; the lines may be nested if an NX_PRINT argument prints too.
+ * @return False if the line is dropped; then finishLine() must not be called for it.
+ */
+NX_KIT_API bool beginLine(CallSite* callSite);
+
+/** @return The stream collecting the current line; stream() if there is no current line. */
+NX_KIT_API std::ostream* lineStream();
+
+/** Writes the collected line to stream(), either immediately or asynchronously. */
+NX_KIT_API void finishLine();
+
+/** Line printed by NX_PRINT, from its beginning to the end of its args. */
+class PrintLine
+{
+public:
+    explicit PrintLine(CallSite* callSite): m_isOpen(beginLine(callSite)) {}
+
+    /** Finishes the line if an arg has thrown. */
+    ~PrintLine()
+    {
+        if (m_isOpen)
+            finishLine();
+    }
+
+    PrintLine(const PrintLine&) = delete;
+    PrintLine& operator=(const PrintLine&) = delete;
+
+    bool isOpen() const { return m_isOpen; }
+
+    void close()
+    {
+        m_isOpen = false;
+        finishLine();
+    }
+
+private:
+    bool m_isOpen;
+};
+
 class NX_KIT_API Timer
 {
 public:
@@ -310,6 +457,31 @@ private:
     Impl* const d;
 };
 
+class NX_KIT_API ProfileZone
+{
+public:
+    /** @param name If null, the zone is disabled. */
+    explicit ProfileZone(const char* name)
+    {
+        if (name)
+            enter(name);
+    }
+
+    ~ProfileZone()
+    {
+        if (m_node)
+            leave();
+    }
+
+private:
+    void enter(const char* name);
+    void leave();
+
+private:
+    void* m_node = nullptr;
+    int64_t m_startTimeNs = 0;
+};
+
 NX_KIT_API void printHexDump(
     PrintFunc printFunc, const char* caption, const char* bytes, int size);
 
@@ -0,0 +1,117 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "mutex.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include "utils.h"
+
+namespace nx {
+namespace kit {
+
+namespace {
+
+struct LockRegistry
+{
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<detail::LockStats>> stats;
+};
+
+LockRegistry& lockRegistry()
+{
+    // Never destroyed: the static Mutexes may be locked during the static deinitialization.
+    static LockRegistry* const registry = new LockRegistry();
+    return *registry;
+}
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> isLockProfilingEnabledFlag{false};
+
+} // namespace detail
+
+void setLockProfilingEnabled(bool enabled)
+{
+    detail::isLockProfilingEnabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<LockProfile> lockProfile()
+{
+    LockRegistry& registry = lockRegistry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::vector<LockProfile> result;
+    for (const auto& entry: registry.stats)
+    {
+        const detail::LockStats& stats = *entry.second;
+        LockProfile profile;
+        profile.name = entry.first;
+        profile.acquisitionCount = stats.acquisitionCount.load(std::memory_order_relaxed);
+        profile.contentionCount = stats.contentionCount.load(std::memory_order_relaxed);
+        profile.waitUs = stats.waitNs.load(std::memory_order_relaxed) / 1000;
+        profile.maxWaitUs = stats.maxWaitNs.load(std::memory_order_relaxed) / 1000;
+        profile.holdUs = stats.holdNs.load(std::memory_order_relaxed) / 1000;
+        profile.maxHoldUs = stats.maxHoldNs.load(std::memory_order_relaxed) / 1000;
+        result.push_back(profile);
+    }
+    return result;
+}
+
+std::string lockProfileReport()
+{
+    std::vector<LockProfile> profiles = lockProfile();
+    std::stable_sort(profiles.begin(), profiles.end(),
+        [](const LockProfile& a, const LockProfile& b) { return a.waitUs > b.waitUs; });
+
+    std::string report = utils::format("%-48s %10s %10s %10s %10s %10s %10s\n",
+        "lock", "count", "contended", "wait ms", "max wait", "hold ms", "max hold");
+    for (const LockProfile& profile: profiles)
+    {
+        report += utils::format("%-48s %10lld %10lld %10.1f %10lld %10.1f %10lld\n",
+            profile.name.c_str(),
+            (long long) profile.acquisitionCount,
+            (long long) profile.contentionCount,
+            (double) profile.waitUs / 1000,
+            (long long) profile.maxWaitUs,
+            (double) profile.holdUs / 1000,
+            (long long) profile.maxHoldUs);
+    }
+    return report;
+}
+
+void resetLockProfile()
+{
+    LockRegistry& registry = lockRegistry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& entry: registry.stats)
+    {
+        detail::LockStats& stats = *entry.second;
+        stats.acquisitionCount = 0;
+        stats.contentionCount = 0;
+        stats.waitNs = 0;
+        stats.maxWaitNs = 0;
+        stats.holdNs = 0;
+        stats.maxHoldNs = 0;
+    }
+}
+
+namespace detail {
+
+LockStats* lockStats(const char* name)
+{
+    LockRegistry& registry = lockRegistry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    std::unique_ptr<LockStats>& stats = registry.stats[name];
+    if (!stats)
+        stats.reset(new LockStats());
+    return stats.get();
+}
+
+} // namespace detail
+
+} // namespace kit
+} // namespace nx
@@ -0,0 +1,201 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+/**@file
+ * Mutex with contention profiling: a drop-in replacement of std::mutex which records how often
+ * each named lock is taken, how often and how long the threads wait for it, and how long it is
+ * held.
+ *
+ * The profiling code can be excluded at build time with -DNX_KIT_LOCK_PROFILING=0; otherwise, it
+ * is switched at run time by setLockProfilingEnabled(), and is initially disabled.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if !defined(NX_KIT_API)
+    #define NX_KIT_API
+#endif
+
+#if !defined(NX_KIT_LOCK_PROFILING)
+    #define NX_KIT_LOCK_PROFILING 1
+#endif
+
+namespace nx {
+namespace kit {
+
+namespace detail {
+
+/** Read inline by each Mutex::lock(), to avoid a call into the library per lock. */
+extern NX_KIT_API std::atomic<bool> isLockProfilingEnabledFlag;
+
+} // namespace detail
+
+/** Affects the locks taken after the call; a lock being held keeps its mode until unlocked. */
+NX_KIT_API void setLockProfilingEnabled(bool enabled);
+
+inline bool isLockProfilingEnabled()
+{
+    return detail::isLockProfilingEnabledFlag.load(std::memory_order_relaxed);
+}
+
+/** Statistics of all the Mutexes with the same name. */
+struct LockProfile
+{
+    std::string name;
+    int64_t acquisitionCount = 0;
+    int64_t contentionCount = 0; //< Acquisitions which had to wait for another thread.
+    int64_t waitUs = 0; //< Total over the acquisitions.
+    int64_t maxWaitUs = 0;
+    int64_t holdUs = 0; //< Total over the acquisitions.
+    int64_t maxHoldUs = 0;
+};
+
+/** @return Statistics of every name a Mutex has been created with, ordered by the name. */
+NX_KIT_API std::vector<LockProfile> lockProfile();
+
+/** @return Table of lockProfile(), the most waited for locks first. */
+NX_KIT_API std::string lockProfileReport();
+
+/** Forgets the statistics collected so far. */
+NX_KIT_API void resetLockProfile();
+
+//-------------------------------------------------------------------------------------------------
+// Implementation
+
+namespace detail {
+
+struct LockStats
+{
+    std::atomic<int64_t> acquisitionCount{0};
+    std::atomic<int64_t> contentionCount{0};
+    std::atomic<int64_t> waitNs{0};
+    std::atomic<int64_t> maxWaitNs{0};
+    std::atomic<int64_t> holdNs{0};
+    std::atomic<int64_t> maxHoldNs{0};
+};
+
+/** @return Statistics shared by all the Mutexes with this name; never destroyed. */
+NX_KIT_API LockStats* lockStats(const char* name);
+
+inline void updateMax(std::atomic<int64_t>* max, int64_t value)
+{
+    int64_t current = max->load(std::memory_order_relaxed);
+    while (value > current
+        && !max->compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+} // namespace detail
+
+/**
+ * Satisfies Lockable, so it works with std::lock_guard and std::unique_lock; with a condition
+ * variable, use std::condition_variable_any. When the profiling is disabled, the overhead is a
+ * flag check per lock() and unlock(); when enabled, an uncontended lock() additionally costs a
+ * clock reading and a few relaxed atomic increments.
+ */
+class Mutex
+{
+public:
+    /** @param name String literal, e.g. "ClassName::m_mutex". */
+    explicit Mutex(const char* name)
+        #if NX_KIT_LOCK_PROFILING
+            : m_stats(detail::lockStats(name))
+        #endif
+    {
+        (void) name;
+    }
+
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    void lock()
+    {
+        #if NX_KIT_LOCK_PROFILING
+            if (isLockProfilingEnabled())
+            {
+                lockProfiled();
+                return;
+            }
+        #endif
+        m_mutex.lock();
+        #if NX_KIT_LOCK_PROFILING
+            m_isProfiled = false;
+        #endif
+    }
+
+    bool try_lock()
+    {
+        if (!m_mutex.try_lock())
+            return false;
+        #if NX_KIT_LOCK_PROFILING
+            m_isProfiled = isLockProfilingEnabled();
+            if (m_isProfiled)
+            {
+                m_lockedAt = Clock::now();
+                m_stats->acquisitionCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        #endif
+        return true;
+    }
+
+    void unlock()
+    {
+        #if NX_KIT_LOCK_PROFILING
+            // Decided by lock(): the profiling may have been switched while the lock was held.
+            if (m_isProfiled)
+            {
+                const int64_t holdNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - m_lockedAt).count();
+                m_stats->holdNs.fetch_add(holdNs, std::memory_order_relaxed);
+                detail::updateMax(&m_stats->maxHoldNs, holdNs);
+            }
+        #endif
+        m_mutex.unlock();
+    }
+
+private:
+    #if NX_KIT_LOCK_PROFILING
+        using Clock = std::chrono::steady_clock;
+
+        void lockProfiled()
+        {
+            m_isProfiled = true;
+            if (m_mutex.try_lock())
+            {
+                m_lockedAt = Clock::now();
+            }
+            else
+            {
+                const Clock::time_point waitStart = Clock::now();
+                m_mutex.lock();
+                m_lockedAt = Clock::now();
+                const int64_t waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    m_lockedAt - waitStart).count();
+                m_stats->contentionCount.fetch_add(1, std::memory_order_relaxed);
+                m_stats->waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+                detail::updateMax(&m_stats->maxWaitNs, waitNs);
+            }
+            m_stats->acquisitionCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    #endif
+
+private:
+    std::mutex m_mutex;
+    #if NX_KIT_LOCK_PROFILING
+        detail::LockStats* const m_stats;
+
+        /** Accessed only by the owner: set in lock(), read in unlock(). */
+        bool m_isProfiled = false;
+        Clock::time_point m_lockedAt;
+    #endif
+};
+
+} // namespace kit
+} // namespace nx
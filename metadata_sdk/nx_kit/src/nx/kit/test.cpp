@@ -2,6 +2,7 @@
 
 #include "test.h"
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <cstdio>
@@ -12,6 +13,7 @@
 #include <vector>
 #include <fstream>
 #include <memory>
+#include <stdexcept>
 
 #if defined(_WIN32)
     #include <direct.h> //< For mkdir().
@@ -167,11 +169,40 @@ int regTest(const Test& test)
     return 0; //< Return value is not used.
 }
 
+static std::vector<Benchmark>& allBenchmarks()
+{
+    static std::vector<Benchmark> allBenchmarks;
+    return allBenchmarks;
+}
+
+int regBenchmark(const Benchmark& benchmark)
+{
+    allBenchmarks().push_back(benchmark);
+
+    if (verbose)
+    {
+        std::cerr << "Suite [" + suiteId() + "]: Added benchmark #" << allBenchmarks().size()
+            << ": " << benchmark.benchmarkCaseDotName << std::endl;
+    }
+
+    return 0; //< Return value is not used.
+}
+
+void doNotOptimizeAddress(const volatile void* address)
+{
+    static const volatile void* volatile sink = nullptr;
+    sink = address;
+    (void) sink;
+}
+
 struct ParsedCmdLineArgs
 {
     bool showHelp = false;
     std::string explicitBaseTempDir;
     bool stopOnFirstFailure = false;
+    bool runBenchmarks = false;
+    bool smokeBenchmarks = false;
+    std::string benchmarkJsonFile;
 };
 
 static const ParsedCmdLineArgs& parsedCmdLineArgs()
@@ -204,6 +235,7 @@ static const ParsedCmdLineArgs& parsedCmdLineArgs()
 
         const std::string tmpOption = "--tmp";
         const std::string tmpOptionEq = "--tmp=";
+        const std::string benchmarkJsonOptionEq = "--benchmark-json=";
         if (arg(i) == tmpOption)
         {
             parsedArgs->explicitBaseTempDir = arg(++i);
@@ -218,6 +250,25 @@ static const ParsedCmdLineArgs& parsedCmdLineArgs()
         {
             parsedArgs->stopOnFirstFailure = true;
         }
+        else if (arg(i) == "--benchmark")
+        {
+            parsedArgs->runBenchmarks = true;
+        }
+        else if (arg(i) == "--benchmark-smoke")
+        {
+            parsedArgs->runBenchmarks = true;
+            parsedArgs->smokeBenchmarks = true;
+        }
+        else if (arg(i).compare(0, benchmarkJsonOptionEq.size(), benchmarkJsonOptionEq) == 0)
+        {
+            parsedArgs->runBenchmarks = true;
+            parsedArgs->benchmarkJsonFile = arg(i).substr(benchmarkJsonOptionEq.size());
+            if (parsedArgs->benchmarkJsonFile.empty())
+            {
+                fatalError(
+                    "Invalid command line args: no file for --benchmark-json; run with --help.");
+            }
+        }
         else
         {
             fatalError("Unknown command line arg %s; run with --help.",
@@ -458,6 +509,15 @@ Usage:
 
   --tmp[=]<temp-dir>
     Use <temp-dir> for temp files instead of a random dir in the system temp dir.
+
+  --benchmark
+    Run the benchmarks after the tests.
+
+  --benchmark-json=<file>
+    Run the benchmarks, and write their results to <file> as JSON, e.g. to compare runs.
+
+  --benchmark-smoke
+    Run each benchmark for a single iteration, only to check that it works.
 )" + specificArgsSection;
 }
 
@@ -536,17 +596,9 @@ static bool runTest(Test& test, int testNumber)
     return success;
 }
 
-int runAllTests(const char *testSuiteName, const char* specificArgsHelp)
+/** @return Number of failed tests. */
+static int runTests(const std::string& fullSuiteName)
 {
-    if (parsedCmdLineArgs().showHelp)
-    {
-        printHelp(nx::kit::utils::getProcessCmdLineArgs()[0], specificArgsHelp);
-        exit(0);
-    }
-
-    const std::string fullSuiteName =
-        std::string("suite ") + testSuiteName + " [" + suiteId() + "]";
-
     std::cerr << std::endl
         << "Running " << allTests().size() << " test(s) from " << fullSuiteName << std::endl;
 
@@ -584,6 +636,231 @@ int runAllTests(const char *testSuiteName, const char* specificArgsHelp)
     return 0;
 }
 
+//-------------------------------------------------------------------------------------------------
+// Benchmarks.
+
+struct BenchmarkResult
+{
+    std::string name;
+    int64_t iterations = 0; //< Per sample.
+    double minNs = 0; //< Per iteration, as the rest of the times.
+    double medianNs = 0;
+    double p99Ns = 0;
+    double maxNs = 0;
+    double meanNs = 0;
+    std::vector<double> samplesNs;
+};
+
+static int64_t runBenchmarkIterations(Benchmark& benchmark, int64_t iterations)
+{
+    BenchmarkState state(iterations);
+    benchmark.benchmarkFunc(state);
+    // The time per iteration would be wrong if the loop has not run all the iterations.
+    if (state.keepRunning())
+        throw std::logic_error("The benchmark body has not completed the keepRunning() loop.");
+    return state.elapsedNs();
+}
+
+/** @return Iteration count for which a sample takes at least kMinSampleNs. */
+static int64_t calibrateIterations(Benchmark& benchmark)
+{
+    static const int64_t kMinSampleNs = 2 * 1000 * 1000;
+    static const int64_t kMaxIterations = (int64_t) 1 << 30;
+
+    runBenchmarkIterations(benchmark, /*iterations*/ 1); //< Warm-up: caches, lazy init.
+
+    int64_t iterations = 1;
+    for (;;)
+    {
+        const int64_t elapsedNs = runBenchmarkIterations(benchmark, iterations);
+        if (elapsedNs >= kMinSampleNs || iterations >= kMaxIterations)
+            return iterations;
+
+        // Aim a bit above the minimum, but grow by at least 2x and at most 100x per round.
+        int64_t nextIterations = iterations * 100;
+        if (elapsedNs > 0)
+        {
+            nextIterations = std::min(nextIterations,
+                (int64_t) ((double) iterations * kMinSampleNs * 1.4 / (double) elapsedNs));
+        }
+        iterations = std::min(kMaxIterations, std::max(nextIterations, iterations * 2));
+    }
+}
+
+static void runBenchmark(Benchmark& benchmark, BenchmarkResult* result)
+{
+    // Enough for the p99 to differ from the max; the samples are short to keep the total time.
+    static const int kSampleCount = 100;
+
+    const bool smoke = parsedCmdLineArgs().smokeBenchmarks;
+    result->iterations = smoke ? 1 : calibrateIterations(benchmark);
+    const int sampleCount = smoke ? 1 : kSampleCount;
+
+    for (int i = 0; i < sampleCount; ++i)
+    {
+        const int64_t elapsedNs = runBenchmarkIterations(benchmark, result->iterations);
+        result->samplesNs.push_back((double) elapsedNs / (double) result->iterations);
+    }
+
+    std::vector<double> sorted = result->samplesNs;
+    std::sort(sorted.begin(), sorted.end());
+    const auto percentile = // Nearest-rank method.
+        [&sorted](int percent)
+        {
+            const size_t rank = (sorted.size() * percent + 99) / 100;
+            return sorted[rank == 0 ? 0 : rank - 1];
+        };
+    result->minNs = sorted.front();
+    result->medianNs = percentile(50);
+    result->p99Ns = percentile(99);
+    result->maxNs = sorted.back();
+    double sum = 0;
+    for (const double sampleNs: sorted)
+        sum += sampleNs;
+    result->meanNs = sum / (double) sorted.size();
+}
+
+static std::string formatNs(double ns)
+{
+    if (ns < 1000)
+        return nx::kit::utils::format("%.1f ns", ns);
+    if (ns < 1000 * 1000)
+        return nx::kit::utils::format("%.2f us", ns / 1000);
+    return nx::kit::utils::format("%.2f ms", ns / (1000 * 1000));
+}
+
+/** Formatted by hand, because the framework must not depend on nx/kit/json.h. */
+static void writeBenchmarkJson(
+    const std::string& filename,
+    const char* testSuiteName,
+    const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream s(filename);
+    if (!s)
+        fatalError("Unable to create benchmark results file: %s", filename.c_str());
+
+    s << "{\n";
+    s << "    \"suite\": " << nx::kit::utils::toString(testSuiteName) << ",\n";
+    s << "    \"benchmarks\": [";
+    for (int i = 0; i < (int) results.size(); ++i)
+    {
+        const BenchmarkResult& r = results[i];
+        s << (i == 0 ? "\n" : ",\n");
+        s << "        {\n";
+        s << "            \"name\": " << nx::kit::utils::toString(r.name) << ",\n";
+        s << "            \"iterations\": " << r.iterations << ",\n";
+        s << "            \"samples\": " << r.samplesNs.size() << ",\n";
+        s << nx::kit::utils::format("            \"minNs\": %.3f,\n", r.minNs);
+        s << nx::kit::utils::format("            \"medianNs\": %.3f,\n", r.medianNs);
+        s << nx::kit::utils::format("            \"p99Ns\": %.3f,\n", r.p99Ns);
+        s << nx::kit::utils::format("            \"maxNs\": %.3f,\n", r.maxNs);
+        s << nx::kit::utils::format("            \"meanNs\": %.3f\n", r.meanNs);
+        s << "        }";
+    }
+    s << (results.empty() ? "]\n" : "\n    ]\n");
+    s << "}\n";
+
+    if (!s)
+        fatalError("Unable to write benchmark results file: %s", filename.c_str());
+    printNote("Benchmark results written to: %s", filename.c_str());
+}
+
+/** @return Number of failed benchmarks. */
+static int runBenchmarks(const char* testSuiteName, const std::string& fullSuiteName)
+{
+    std::cerr << std::endl
+        << "Running " << allBenchmarks().size() << " benchmark(s) from " << fullSuiteName
+        << std::endl;
+
+    std::vector<BenchmarkResult> results;
+    int failedCount = 0;
+    for (int i = 1; i <= (int) allBenchmarks().size(); ++i)
+    {
+        Benchmark& benchmark = allBenchmarks()[i - 1];
+        printSectionHeader("Benchmark #%d: %s", i, benchmark.benchmarkCaseDotName);
+
+        BenchmarkResult result;
+        result.name = benchmark.benchmarkCaseDotName;
+        try
+        {
+            runBenchmark(benchmark, &result);
+        }
+        catch (const TestFailure& e)
+        {
+            std::cerr << std::endl
+                << "Benchmark #" << i << " FAILED at line " << e.line << ", file " << e.file
+                << std::endl << std::endl << e.message << std::endl;
+            ++failedCount;
+            continue;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << std::endl
+                << "Benchmark #" << i << " FAILED with the exception:\n"
+                "    " << e.what() << std::endl;
+            ++failedCount;
+            continue;
+        }
+
+        std::cerr << std::endl
+            << "    min " << formatNs(result.minNs)
+            << ", median " << formatNs(result.medianNs)
+            << ", p99 " << formatNs(result.p99Ns)
+            << ", max " << formatNs(result.maxNs)
+            << "; " << result.samplesNs.size() << " sample(s) x "
+            << result.iterations << " iteration(s)" << std::endl;
+        results.push_back(std::move(result));
+    }
+
+    if (!parsedCmdLineArgs().benchmarkJsonFile.empty())
+        writeBenchmarkJson(parsedCmdLineArgs().benchmarkJsonFile, testSuiteName, results);
+
+    if (failedCount > 0)
+    {
+        printSectionHeader("%d of %lu benchmark(s) FAILED in %s. See messages above.",
+            failedCount, (unsigned long) allBenchmarks().size(), fullSuiteName.c_str());
+    }
+    else
+    {
+        printSectionHeader("SUCCESS: All %lu benchmark(s) completed in %s.",
+            (unsigned long) allBenchmarks().size(), fullSuiteName.c_str());
+    }
+    return failedCount;
+}
+
+int runAllTests(const char *testSuiteName, const char* specificArgsHelp)
+{
+    if (parsedCmdLineArgs().showHelp)
+    {
+        printHelp(nx::kit::utils::getProcessCmdLineArgs()[0], specificArgsHelp);
+        exit(0);
+    }
+
+    const std::string fullSuiteName =
+        std::string("suite ") + testSuiteName + " [" + suiteId() + "]";
+
+    int failedCount = 0;
+
+    // A suite of benchmarks only does not need to report that it has no tests.
+    if (!allTests().empty() || allBenchmarks().empty())
+        failedCount += runTests(fullSuiteName);
+
+    if (!allBenchmarks().empty())
+    {
+        if (parsedCmdLineArgs().runBenchmarks)
+        {
+            failedCount += runBenchmarks(testSuiteName, fullSuiteName);
+        }
+        else
+        {
+            printNote("Skipped %lu benchmark(s); run with --benchmark to run them.",
+                (unsigned long) allBenchmarks().size());
+        }
+    }
+
+    return failedCount;
+}
+
 void createFile(const std::string& filename, const std::string& content)
 {
     std::ofstream s(filename);
@@ -6,6 +6,7 @@
  * Rudimentary standalone unit testing framework designed to mimic Google Test to a certain degree.
  */
 
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <sstream>
@@ -53,6 +54,38 @@ extern bool NX_KIT_API verbose; //< Use to control additional output of the unit
     static void disabled_test_##TEST_CASE##_##TEST_NAME() /* The function will be unused. */
     // Function body follows the DISABLED_TEST macro.
 
+/**
+ * Defines a benchmark: a function which runs the measured code in a loop while
+ * `state.keepRunning()` returns true. The code before the loop is not measured. Benchmarks are
+ * run after all tests, and only if requested via the `--benchmark` command line option.
+ *
+ * Each benchmark is warmed up, then its iteration count is calibrated until a sample takes at
+ * least 2 ms: each round grows the count towards 1.4 times what the last round's time suggests
+ * for 2 ms, but by at least 2x and at most 100x, up to 2^30 iterations. Then 100 samples are
+ * taken, so that the p99 is not merely the max; the min, median, p99 and max time per iteration
+ * is reported.
+ *
+ * Usage:
+ * ```
+ *     BENCHMARK(MySuite, myBenchmark)
+ *     {
+ *         const std::string text = "42";
+ *         while (state.keepRunning())
+ *             nx::kit::test::doNotOptimize(std::stoi(text));
+ *     }
+ * ```
+ */
+#define BENCHMARK(BENCHMARK_CASE, BENCHMARK_NAME) \
+    static void benchmark_##BENCHMARK_CASE##_##BENCHMARK_NAME( \
+        ::nx::kit::test::BenchmarkState& state); \
+    int unusedBenchmark_##BENCHMARK_CASE##_##BENCHMARK_NAME /* Not `static const`. */ = \
+        ::nx::kit::test::detail::regBenchmark( \
+            {#BENCHMARK_CASE "." #BENCHMARK_NAME, \
+                benchmark_##BENCHMARK_CASE##_##BENCHMARK_NAME}); \
+    static void benchmark_##BENCHMARK_CASE##_##BENCHMARK_NAME( \
+        ::nx::kit::test::BenchmarkState& state)
+    // Function body follows the BENCHMARK macro.
+
 #define ASSERT_TRUE(CONDITION) \
     ::nx::kit::test::detail::assertBool(true, !!(CONDITION), #CONDITION, __FILE__, __LINE__)
 
@@ -135,6 +168,80 @@ NX_KIT_API int runAllTests(const char *testSuiteName, const char* specificArgsHe
 /** Allows zero bytes in the content. */
 NX_KIT_API void createFile(const std::string& filename, const std::string& content);
 
+/**
+ * Passed to the BENCHMARK() body; measures the time of the iterations of its loop.
+ */
+class BenchmarkState
+{
+public:
+    explicit BenchmarkState(int64_t iterations):
+        m_iterations(iterations), m_remainingIterations(iterations)
+    {
+    }
+
+    /** Starts the time measurement on the first call, and stops it on the last one. */
+    bool keepRunning()
+    {
+        if (m_remainingIterations == m_iterations)
+            resumeTiming();
+        if (m_remainingIterations > 0)
+        {
+            --m_remainingIterations;
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+
+    /** Excludes the time until resumeTiming() from the measurement, e.g. to prepare the data. */
+    void pauseTiming()
+    {
+        if (!m_isTiming)
+            return;
+        m_elapsed += std::chrono::steady_clock::now() - m_timingStart;
+        m_isTiming = false;
+    }
+
+    void resumeTiming()
+    {
+        if (m_isTiming)
+            return;
+        m_timingStart = std::chrono::steady_clock::now();
+        m_isTiming = true;
+    }
+
+    int64_t iterations() const { return m_iterations; }
+
+    /** Valid after keepRunning() has returned false. */
+    int64_t elapsedNs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(m_elapsed).count();
+    }
+
+private:
+    const int64_t m_iterations;
+    int64_t m_remainingIterations;
+    bool m_isTiming = false;
+    std::chrono::steady_clock::time_point m_timingStart;
+    std::chrono::steady_clock::duration m_elapsed{0};
+};
+
+namespace detail { NX_KIT_API void doNotOptimizeAddress(const volatile void* address); }
+
+/**
+ * Makes the compiler assume that the value is used, so that the computation of a benchmarked
+ * result which is otherwise discarded is not optimized away.
+ */
+template<typename T>
+void doNotOptimize(const T& value)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        __asm__ __volatile__("" : : "r,m"(value) : "memory");
+    #else
+        detail::doNotOptimizeAddress(&value);
+    #endif
+}
+
 //-------------------------------------------------------------------------------------------------
 // Implementation
 
@@ -157,6 +264,16 @@ struct Test
 
 NX_KIT_API int regTest(const Test& test);
 
+typedef std::function<void(BenchmarkState& state)> BenchmarkFunc;
+
+struct Benchmark
+{
+    const char* const benchmarkCaseDotName;
+    const BenchmarkFunc benchmarkFunc;
+};
+
+NX_KIT_API int regBenchmark(const Benchmark& benchmark);
+
 NX_KIT_API void failEq(
     const std::string& expectedValue, const char* expectedExpr,
     const std::string& actualValue, const char* actualExpr,
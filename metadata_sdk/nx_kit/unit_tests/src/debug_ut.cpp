@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #include <nx/kit/test.h>
 #include <nx/kit/debug.h>
@@ -77,11 +79,189 @@ TEST(debug, overrideStreamPreproc)
 
     // Restore default stream.
     #undef NX_DEBUG_STREAM
-    #define NX_DEBUG_STREAM *stream()
+    #define NX_DEBUG_STREAM *detail::lineStream()
 
     ASSERT_EQ("[debug_ut] TEST\n", stringStream.str());
 }
 
+TEST(debug, asyncOutput)
+{
+    std::ostringstream stringStream;
+
+    std::ostream* const oldStream = stream();
+    stream() = &stringStream;
+    setAsyncOutput(true);
+
+    NX_PRINT << "TEST 1";
+    std::thread([]() { NX_PRINT << "TEST 2"; }).join();
+    flushOutput();
+    const std::string output = stringStream.str();
+
+    setAsyncOutput(false);
+    stream() = oldStream;
+    ASSERT_TRUE(output.find("[debug_ut] TEST 1\n") != std::string::npos);
+    ASSERT_TRUE(output.find("[debug_ut] TEST 2\n") != std::string::npos);
+}
+
+TEST(debug, asyncOutputOverflow)
+{
+    std::ostringstream stringStream;
+
+    std::ostream* const oldStream = stream();
+    stream() = &stringStream;
+    setAsyncOutput(true);
+
+    // More lines than the queue of a thread holds: none is lost, and the order is kept.
+    static constexpr int kLineCount = 5000;
+    for (int i = 0; i < kLineCount; ++i)
+        NX_PRINT << "LINE " << i;
+    flushOutput();
+    const std::string output = stringStream.str();
+
+    setAsyncOutput(false);
+    stream() = oldStream;
+    size_t position = 0;
+    for (int i = 0; i < kLineCount; ++i)
+    {
+        const std::string line = "[debug_ut] LINE " + std::to_string(i) + "\n";
+        position = output.find(line, position);
+        ASSERT_TRUE(position != std::string::npos);
+        position += line.size();
+    }
+}
+
+TEST(debug, rateLimit)
+{
+    std::ostringstream stringStream;
+
+    std::ostream* const oldStream = stream();
+    stream() = &stringStream;
+    setRateLimit(2);
+
+    int sideEffectCount = 0;
+    for (int i = 0; i < 5; ++i)
+        NX_PRINT << "TEST " << i << " " << ++sideEffectCount;
+    NX_PRINT << "OTHER"; //< Another call site has its own limit.
+
+    setRateLimit(0);
+    stream() = oldStream;
+    ASSERT_EQ(2, sideEffectCount); //< The args of the dropped lines are not evaluated.
+    ASSERT_EQ("[debug_ut] TEST 0 1\n[debug_ut] TEST 1 2\n[debug_ut] OTHER\n", stringStream.str());
+}
+
+TEST(debug, profile)
+{
+    static constexpr struct
+    {
+        const bool enableProfile = true;
+    } ini{};
+
+    resetProfile();
+    for (int i = 0; i < 3; ++i)
+    {
+        NX_PROFILE_ZONE("outer");
+        for (int j = 0; j < 2; ++j)
+        {
+            NX_PROFILE_ZONE("inner");
+        }
+    }
+    std::thread([]() { NX_PROFILE_ZONE("outer"); }).join(); //< Merged with this thread's zone.
+
+    const std::string report = profileReport();
+    NX_PRINT << "Profile:\n" << report;
+
+    // The zones, nested via indentation, are followed by their counts.
+    const std::string outer = "\nouter ";
+    const std::string inner = "\n    inner ";
+    ASSERT_TRUE(report.find(outer) != std::string::npos);
+    ASSERT_TRUE(report.find(inner) > report.find(outer));
+    ASSERT_EQ(4, std::stoi(report.substr(report.find(outer) + outer.size())));
+    ASSERT_EQ(6, std::stoi(report.substr(report.find(inner) + inner.size())));
+}
+
+TEST(debug, profileOfExitedThreads)
+{
+    static constexpr struct
+    {
+        const bool enableProfile = true;
+    } ini{};
+
+    resetProfile();
+    for (int i = 0; i < 100; ++i)
+        std::thread([]() { NX_PROFILE_ZONE("exited"); }).join();
+
+    // Kept after the threads have exited, merged into a single zone.
+    const std::string zone = "\nexited ";
+    const std::string report = profileReport();
+    ASSERT_TRUE(report.find(zone) != std::string::npos);
+    ASSERT_EQ(100, std::stoi(report.substr(report.find(zone) + zone.size())));
+    ASSERT_TRUE(report.find(zone, report.find(zone) + 1) == std::string::npos);
+
+    // Forgotten along with the zones of the running threads.
+    resetProfile();
+    ASSERT_TRUE(profileReport().find(zone) == std::string::npos);
+}
+
+TEST(debug, disabledProfile)
+{
+    static constexpr struct
+    {
+        const bool enableProfile = false;
+    } ini{};
+
+    resetProfile();
+    {
+        NX_PROFILE_ZONE("disabled");
+    }
+    ASSERT_TRUE(profileReport().find("disabled") == std::string::npos);
+}
+
+static uint64_t lowerBoundOf(uint64_t value)
+{
+    return LogLinearHistogram::bucketLowerBound(LogLinearHistogram::bucketOf(value));
+}
+
+TEST(debug, logLinearHistogramBuckets)
+{
+    // Exact below 16, then eight buckets per power of two.
+    for (uint64_t value = 0; value < 16; ++value)
+        ASSERT_EQ(value, lowerBoundOf(value));
+    ASSERT_EQ(16U, lowerBoundOf(17));
+    ASSERT_EQ(18U, lowerBoundOf(18));
+    ASSERT_EQ(30U, lowerBoundOf(31));
+    ASSERT_EQ(960U, lowerBoundOf(1023));
+    ASSERT_EQ(1024U, lowerBoundOf(1024));
+    ASSERT_EQ(1024U, lowerBoundOf(1151));
+    ASSERT_EQ(1152U, lowerBoundOf(1152));
+    ASSERT_EQ(1088.0, LogLinearHistogram::bucketValue(LogLinearHistogram::bucketOf(1024)));
+
+    ASSERT_EQ(LogLinearHistogram::kBucketCount - 1, LogLinearHistogram::bucketOf(UINT64_MAX));
+    ASSERT_EQ((uint64_t) 15 << 60, lowerBoundOf(UINT64_MAX));
+}
+
+TEST(debug, logLinearHistogramPercentiles)
+{
+    std::vector<uint64_t> counts(LogLinearHistogram::kBucketCount);
+    ASSERT_EQ(-1, LogLinearHistogram::percentileBucket(counts.data(), 0.5));
+
+    for (uint64_t value = 1; value <= 100; ++value)
+        ++counts[LogLinearHistogram::bucketOf(value * 1000)];
+
+    // Nearest rank, rounded down to the bucket bound: within 1/8 below the exact value.
+    const auto isNear =
+        [&counts](double fraction, uint64_t exact)
+        {
+            const uint64_t actual = LogLinearHistogram::bucketLowerBound(
+                LogLinearHistogram::percentileBucket(counts.data(), fraction));
+            return actual <= exact && actual * 8 >= exact * 7;
+        };
+    ASSERT_TRUE(isNear(0.5, 50000));
+    ASSERT_TRUE(isNear(0.9, 90000));
+    ASSERT_TRUE(isNear(0.99, 99000));
+    ASSERT_TRUE(isNear(1, 100000));
+    ASSERT_TRUE(isNear(0, 1000)); //< The rank is at least 1.
+}
+
 // TODO: Rework unit tests to check the captured actual output.
 
 TEST(debug, assertSuccess)
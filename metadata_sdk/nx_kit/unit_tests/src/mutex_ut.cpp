@@ -0,0 +1,162 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+#include <nx/kit/test.h>
+#include <nx/kit/mutex.h>
+
+namespace nx {
+namespace kit {
+namespace test {
+
+static LockProfile findLockProfile(const std::string& name)
+{
+    for (const LockProfile& profile: lockProfile())
+    {
+        if (profile.name == name)
+            return profile;
+    }
+    return LockProfile();
+}
+
+/** Enables the profiling for the lifetime of the object. */
+class LockProfilingEnabler
+{
+public:
+    LockProfilingEnabler(): m_wasEnabled(isLockProfilingEnabled())
+    {
+        setLockProfilingEnabled(true);
+    }
+
+    ~LockProfilingEnabler() { setLockProfilingEnabled(m_wasEnabled); }
+
+private:
+    const bool m_wasEnabled;
+};
+
+TEST(mutex, acquisitions)
+{
+    const LockProfilingEnabler enabler;
+    resetLockProfile();
+
+    Mutex mutex("mutex_ut.acquisitions");
+    for (int i = 0; i < 3; ++i)
+        std::lock_guard<Mutex> lock(mutex);
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.unlock();
+
+    // Shares the statistics with the first one.
+    Mutex sameNameMutex("mutex_ut.acquisitions");
+    std::unique_lock<Mutex> lock(sameNameMutex);
+    lock.unlock();
+
+    const LockProfile profile = findLockProfile("mutex_ut.acquisitions");
+    ASSERT_EQ(5, profile.acquisitionCount);
+    ASSERT_EQ(0, profile.contentionCount);
+    ASSERT_EQ(0, profile.waitUs);
+}
+
+TEST(mutex, contention)
+{
+    const LockProfilingEnabler enabler;
+    resetLockProfile();
+
+    Mutex mutex("mutex_ut.contention");
+    std::atomic<bool> isWaiting{false};
+    mutex.lock();
+    std::thread thread(
+        [&]()
+        {
+            isWaiting = true;
+            std::lock_guard<Mutex> lock(mutex);
+        });
+    while (!isWaiting)
+        std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    mutex.unlock();
+    thread.join();
+
+    const LockProfile profile = findLockProfile("mutex_ut.contention");
+    ASSERT_EQ(2, profile.acquisitionCount);
+    ASSERT_EQ(1, profile.contentionCount);
+    ASSERT_TRUE(profile.maxWaitUs >= 10000);
+    ASSERT_TRUE(profile.maxHoldUs >= 10000);
+    ASSERT_TRUE(profile.holdUs >= profile.maxHoldUs);
+
+    const std::string report = lockProfileReport();
+    std::cerr << "Lock profile:\n" << report;
+    ASSERT_TRUE(report.find("mutex_ut.contention") != std::string::npos);
+}
+
+TEST(mutex, disabledProfiling)
+{
+    const bool wasEnabled = isLockProfilingEnabled();
+    setLockProfilingEnabled(false);
+
+    Mutex mutex("mutex_ut.disabledProfiling");
+    {
+        std::lock_guard<Mutex> lock(mutex);
+
+        // Switching while the lock is held does not record a bogus hold time.
+        setLockProfilingEnabled(true);
+    }
+    setLockProfilingEnabled(false);
+    std::lock_guard<Mutex> lock(mutex);
+
+    const LockProfile profile = findLockProfile("mutex_ut.disabledProfiling");
+    ASSERT_EQ(0, profile.acquisitionCount);
+    ASSERT_EQ(0, profile.holdUs);
+
+    setLockProfilingEnabled(wasEnabled);
+}
+
+TEST(mutex, profilingDisabledWhileLocked)
+{
+    const bool wasEnabled = isLockProfilingEnabled();
+    setLockProfilingEnabled(true);
+
+    Mutex mutex("mutex_ut.profilingDisabledWhileLocked");
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        // The acquisition has been profiled, so its hold time is recorded as well.
+        setLockProfilingEnabled(false);
+    }
+
+    const LockProfile profile = findLockProfile("mutex_ut.profilingDisabledWhileLocked");
+    ASSERT_EQ(1, profile.acquisitionCount);
+    ASSERT_TRUE(profile.holdUs >= 10000);
+
+    setLockProfilingEnabled(wasEnabled);
+}
+
+TEST(mutex, conditionVariable)
+{
+    const LockProfilingEnabler enabler;
+
+    Mutex mutex("mutex_ut.conditionVariable");
+    std::condition_variable_any condition;
+    bool isReady = false;
+    std::thread thread(
+        [&]()
+        {
+            std::lock_guard<Mutex> lock(mutex);
+            isReady = true;
+            condition.notify_one();
+        });
+    {
+        std::unique_lock<Mutex> lock(mutex);
+        condition.wait(lock, [&]() { return isReady; });
+    }
+    thread.join();
+
+    ASSERT_TRUE(findLockProfile("mutex_ut.conditionVariable").acquisitionCount >= 2);
+}
+
+} // namespace test
+} // namespace kit
+} // namespace nx
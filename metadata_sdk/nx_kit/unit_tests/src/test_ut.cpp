@@ -83,6 +83,49 @@ TEST(test, assertStreqWithNulChars)
     assertStreqFails(__LINE__, strWithNulInside, "a\0B");
 }
 
+TEST(test, benchmarkState)
+{
+    BenchmarkState state(/*iterations*/ 3);
+    ASSERT_EQ(3, (int) state.iterations());
+
+    int iterationCount = 0;
+    while (state.keepRunning())
+    {
+        ++iterationCount;
+        doNotOptimize(iterationCount);
+    }
+    ASSERT_EQ(3, iterationCount);
+    ASSERT_TRUE(state.elapsedNs() >= 0);
+
+    // Further calls do not restart the loop.
+    ASSERT_FALSE(state.keepRunning());
+}
+
+TEST(test, benchmarkStatePauseTiming)
+{
+    BenchmarkState state(/*iterations*/ 1);
+    while (state.keepRunning())
+    {
+        state.pauseTiming();
+        const auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20))
+        {
+        }
+        state.resumeTiming();
+    }
+
+    // The paused time is excluded from the measurement.
+    ASSERT_TRUE(state.elapsedNs() < 20 * 1000 * 1000);
+}
+
+/** Run via `--benchmark`; serves as an example. */
+BENCHMARK(test, stringToInt)
+{
+    const std::string text = "42";
+    while (state.keepRunning())
+        doNotOptimize(std::stoi(text));
+}
+
 TEST(utils, universalString)
 {
     using detail::UniversalString;
@@ -0,0 +1,337 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+/**@file
+ * Benchmarks of the AIBox plugin hot paths, from the camera bytes to the metadata packet. Run with
+ * `--benchmark`, and with `--benchmark-json=<file>` to keep the results for comparing the runs.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <asio.hpp>
+
+#include <nx/kit/test.h>
+#include <nx/sdk/analytics/helpers/pooled_object_metadata.h>
+#include <nx/sdk/helpers/media_stream_statistics.h>
+#include <nx/sdk/helpers/uuid_helper.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/allocation_tracker.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/device_agent_manifest.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metadata_packet_builder.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/plugin.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/track_change_detector.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/track_table.h>
+#include <nx/vms_server_plugins/analytics/AIBox/net/http_framing.h>
+#include <nx/vms_server_plugins/analytics/AIBox/net/net_utils.h>
+
+#include "camera_simulator.h"
+#include "fake_host.h"
+
+using namespace nx::kit::test;
+using namespace nx::sdk;
+using namespace nx::sdk::analytics;
+using namespace nx::vms_server_plugins::analytics::AIBox;
+
+namespace {
+
+static constexpr int kTargetCount = 10;
+
+/** A PEA trajectory message as sent by the camera, with kTargetCount targets. */
+std::string makePeaXml()
+{
+    std::string xml =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<config version=\"1.7\" xmlns=\"http://www.ipc.com/ver10\">\n"
+        "    <smartType>PEA</smartType>\n"
+        "    <subscribeOption>FEATURE_RESULT</subscribeOption>\n"
+        "    <currentTime>1700000000123</currentTime>\n"
+        "    <mac>58:5b:69:00:00:01</mac>\n"
+        "    <deviceName>IPC</deviceName>\n"
+        "    <traject type=\"list\" count=\"" + std::to_string(kTargetCount) + "\">\n";
+    for (int i = 0; i < kTargetCount; ++i)
+    {
+        xml +=
+            "        <item>\n"
+            "            <targetId>" + std::to_string(1000 + i) + "</targetId>\n"
+            "            <targetType>" + (i % 2 == 0 ? "person" : "car") + "</targetType>\n"
+            "            <rect>\n"
+            "                <x1>" + std::to_string(100 * i) + "</x1>\n"
+            "                <y1>" + std::to_string(200 + 50 * i) + "</y1>\n"
+            "                <x2>" + std::to_string(100 * i + 800) + "</x2>\n"
+            "                <y2>" + std::to_string(1200 + 50 * i) + "</y2>\n"
+            "            </rect>\n"
+            "        </item>\n";
+    }
+    xml +=
+        "    </traject>\n"
+        "</config>\n";
+    return xml;
+}
+
+/** The camera pushes each message as an HTTP request on the subscription connection. */
+std::string makeHttpMessage(const std::string& body)
+{
+    return "POST /SendAlarmData HTTP/1.1\r\n"
+        "Host: 192.168.1.100:80\r\n"
+        "Content-Type: application/xml; charset=\"UTF-8\"\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n" + body;
+}
+
+/** Frames a message which has arrived as a whole, the way TcpClient does. */
+std::string frameMessage(asio::streambuf* buffer)
+{
+    const HttpMessageHeader header = readHttpMessageHeader(buffer);
+    return readHttpMessageBody(buffer, header.contentLength);
+}
+
+/** Sends every track in each packet, as the full refresh does. */
+TrackChangeDetector makeFullRefreshDetector()
+{
+    TrackChangeDetector changeDetector;
+    changeDetector.setMinBoxChange(0.01F);
+    changeDetector.setFullRefreshIntervalUs(1);
+    return changeDetector;
+}
+
+/** The way the packets were built before ObjectMetadataPacket::addItems(), for comparison. */
+int buildPacketItemByItem(TrackTable* trackTable, int64_t timestampUs, ObjectMetadataPool* pool)
+{
+    const auto metadataPacket = pool->makeObjectMetadataPacket();
+    metadataPacket->setTimestampUs(timestampUs);
+    metadataPacket->setDurationUs(40000);
+    trackTable->forEach(
+        [&](TrackTable::Track* track)
+        {
+            const Rect& box = track->newestSample().box;
+            const auto objectMetadata = pool->makeObjectMetadata();
+            objectMetadata->setTypeId(*track->typeId);
+            objectMetadata->setTrackId(track->trackId);
+            objectMetadata->setBoundingBox(box);
+            metadataPacket->addItem(objectMetadata.get());
+            trackTable->setEmitted(track, timestampUs, box);
+        });
+    return metadataPacket->count();
+}
+
+/** Fills the table with kTargetCount tracks. */
+void addTracks(TrackTable* trackTable)
+{
+    for (int i = 0; i < kTargetCount; ++i)
+    {
+        trackTable->update(
+            1000 + i,
+            i % 2 == 0 ? &kStringHuman : &kStringMotorVehicle,
+            UuidHelper::randomUuid(),
+            /*timestampUs*/ 1000,
+            Rect(0.01F * i, 0.02F * i, 0.1F, 0.2F));
+    }
+}
+
+} // namespace
+
+BENCHMARK(framing, httpMessage)
+{
+    const std::string message = makeHttpMessage(makePeaXml());
+    asio::streambuf buffer;
+    while (state.keepRunning())
+    {
+        std::ostream(&buffer) << message;
+        doNotOptimize(frameMessage(&buffer));
+    }
+}
+
+BENCHMARK(framing, preprocessXmlData)
+{
+    const std::string xml = "\xEF\xBB\xBF\r\n" + makePeaXml();
+    while (state.keepRunning())
+        doNotOptimize(preprocessXmlData(xml));
+}
+
+BENCHMARK(xml, parsePeaTrajectory)
+{
+    const std::string xml = makePeaXml();
+    while (state.keepRunning())
+    {
+        const PEAResult result = parsePEATrajectoryData(xml);
+        ASSERT_EQ(kTargetCount, (int) result.trajects.size());
+        doNotOptimize(result);
+    }
+}
+
+BENCHMARK(uuid, randomUuid)
+{
+    while (state.keepRunning())
+        doNotOptimize(UuidHelper::randomUuid());
+}
+
+BENCHMARK(uuid, toStdString)
+{
+    const Uuid uuid = UuidHelper::randomUuid();
+    while (state.keepRunning())
+        doNotOptimize(UuidHelper::toStdString(uuid));
+}
+
+BENCHMARK(uuid, toChars)
+{
+    const Uuid uuid = UuidHelper::randomUuid();
+    char buffer[UuidHelper::kMaxStringSize];
+    while (state.keepRunning())
+    {
+        doNotOptimize(UuidHelper::toChars(uuid, buffer));
+        doNotOptimize(buffer[0]);
+    }
+}
+
+BENCHMARK(uuid, fromStdString)
+{
+    const std::string text = UuidHelper::toStdString(UuidHelper::randomUuid());
+    while (state.keepRunning())
+        doNotOptimize(UuidHelper::fromStdString(text));
+}
+
+BENCHMARK(packet, build)
+{
+    TrackTable trackTable;
+    addTracks(&trackTable);
+    TrackChangeDetector changeDetector = makeFullRefreshDetector();
+    MetadataPacketBuilder packetBuilder;
+
+    int64_t timestampUs = 1000;
+    while (state.keepRunning())
+    {
+        timestampUs += 40000;
+        doNotOptimize(packetBuilder.buildPendingPacket(
+            &trackTable, &changeDetector, timestampUs, /*durationUs*/ 40000));
+    }
+}
+
+BENCHMARK(packet, buildItemByItem)
+{
+    TrackTable trackTable;
+    addTracks(&trackTable);
+    ObjectMetadataPool pool;
+
+    int64_t timestampUs = 1000;
+    while (state.keepRunning())
+    {
+        timestampUs += 40000;
+        doNotOptimize(buildPacketItemByItem(&trackTable, timestampUs, &pool));
+    }
+}
+
+BENCHMARK(stream, mediaStreamStatistics)
+{
+    MediaStreamStatistics statistics;
+    int64_t timestampUs = 0;
+    while (state.keepRunning())
+    {
+        timestampUs += 40000;
+        statistics.onData(std::chrono::microseconds(timestampUs), 20000, false);
+    }
+    doNotOptimize(statistics.getFrameRate());
+}
+
+// Registered only in the builds with aiboxAllocationTracking, as the AIBox_allocations CTest
+// entry, so that the gate is never reported as passed without having been run.
+#if defined(AIBOX_ALLOCATION_TRACKING)
+
+/**
+ * Feeds the video to the DeviceAgent, as the Server does, until the plugin has received the given
+ * number of camera messages since the last AllocationTracker::reset().
+ * @return False on timeout.
+ */
+static bool waitForMessages(bench::FakeHost* host, bench::FakeDevice* device, int messageCount)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (AllocationTracker::messageCount() < messageCount)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        host->pushVideoFrame(device, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+/**
+ * Runs a DeviceAgent subscribed to a simulated camera, i.e. the real TcpClient, Subscriber and
+ * DeviceAgent code, and fails if a stage of the message pipeline allocates more per message than
+ * its budget; the budgets are to be lowered as the allocations are eliminated.
+ */
+TEST(allocations, perMessage)
+{
+    struct Budget
+    {
+        const char* tag;
+        double maxAllocationsPerMessage;
+    };
+    static const Budget kBudgets[] = {
+        {"framing", 5},
+        {"parse", 16},
+        {"filter", 0},
+        {"uuid", 0},
+        {"packet build", 0},
+    };
+
+    bench::CameraSimulator::Params simulatorParams;
+    simulatorParams.messagesPerSecond = 200;
+    simulatorParams.targetCount = kTargetCount;
+    bench::CameraSimulator simulator(simulatorParams);
+    std::string error;
+    if (!simulator.start(&error))
+        std::cerr << "ERROR: " << error << "\n";
+    ASSERT_TRUE(error.empty());
+
+    const std::string homeDir = bench::makeHomeDir("AIBox_bench");
+    static constexpr int kMessageCount = 500;
+    bool isReceived = false;
+    {
+        bench::FakeHost host(homeDir);
+        using nx::vms_server_plugins::analytics::AIBox::Plugin; //< Not the SDK helper.
+        if (!host.load(Ptr<nx::sdk::IPlugin>(new Plugin())))
+            std::cerr << "ERROR: " << host.error() << "\n";
+        bench::FakeDevice* const device = host.addDevice(bench::simulatedCameraParams(0));
+        if (!device)
+            std::cerr << "ERROR: " << host.error() << "\n";
+
+        // The first messages create the tracks, and fill the metadata pools.
+        AllocationTracker::reset();
+        if (device && waitForMessages(&host, device, 10))
+        {
+            AllocationTracker::reset();
+            isReceived = waitForMessages(&host, device, kMessageCount);
+        }
+        host.removeDevices();
+    }
+    simulator.stop();
+    bench::removeHomeDir(homeDir);
+    ASSERT_TRUE(isReceived);
+
+    // The messages may keep arriving while the counts are collected.
+    const int64_t messageCount = AllocationTracker::messageCount();
+    ASSERT_TRUE(messageCount >= kMessageCount);
+    for (const AllocationTracker::TagCounts& counts: AllocationTracker::counts())
+    {
+        const double allocationsPerMessage = (double) counts.allocationCount / messageCount;
+        std::cerr << "Allocations per message in " << counts.tag << ": "
+            << allocationsPerMessage << ", "
+            << (double) counts.byteCount / messageCount << " bytes\n";
+        for (const Budget& budget: kBudgets)
+        {
+            if (counts.tag == budget.tag)
+                ASSERT_TRUE(allocationsPerMessage <= budget.maxAllocationsPerMessage);
+        }
+    }
+}
+
+#endif // defined(AIBOX_ALLOCATION_TRACKING)
+
+int main()
+{
+    return nx::kit::test::runAllTests("AIBox_bench");
+}
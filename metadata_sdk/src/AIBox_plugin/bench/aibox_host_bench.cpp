@@ -0,0 +1,298 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+/**@file
+ * End-to-end benchmark of the AIBox plugin library in one process: the simulated cameras push the
+ * PEA messages over the loopback, and the fake Server receives the metadata packets. Measures the
+ * latency from the camera sending a message to the Server receiving the packet made of it, and
+ * the CPU time the Plugin spends per camera.
+ *
+ * Usage: AIBox_host_bench [--cameras=16] [--seconds=10] [--rate=10] [--targets=5] [--fps=25]
+ *     [--port=8080] [--plugin=<libAIBox_plugin.so>] [--json=<file>]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/utils.h>
+
+#include "camera_simulator.h"
+#include "fake_host.h"
+
+using namespace nx::vms_server_plugins::analytics::AIBox::bench;
+
+namespace {
+
+struct Options
+{
+    int cameras = 16;
+    int seconds = 10;
+    int rate = 10; //< Messages per second per camera.
+    int targets = 5;
+    int fps = 25;
+    int port = 8080;
+    std::string plugin = AIBOX_PLUGIN_LIBRARY_PATH;
+    std::string json;
+};
+
+bool parseOptions(int argc, const char* argv[], Options* options)
+{
+    const std::map<std::string, int*> intOptions = {
+        {"--cameras", &options->cameras},
+        {"--seconds", &options->seconds},
+        {"--rate", &options->rate},
+        {"--targets", &options->targets},
+        {"--fps", &options->fps},
+        {"--port", &options->port},
+    };
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const size_t equalsPos = arg.find('=');
+        const std::string name = arg.substr(0, equalsPos);
+        const std::string value = equalsPos == std::string::npos ? "" : arg.substr(equalsPos + 1);
+        if (value.empty())
+        {
+            std::cerr << "Invalid option " << arg << "; see the usage in " << __FILE__ << std::endl;
+            return false;
+        }
+        if (name == "--plugin")
+            options->plugin = value;
+        else if (name == "--json")
+            options->json = value;
+        else if (intOptions.count(name) && nx::kit::utils::fromString(value, intOptions.at(name)))
+            continue;
+        else
+        {
+            std::cerr << "Invalid option " << arg << "; see the usage in " << __FILE__ << std::endl;
+            return false;
+        }
+    }
+    return options->cameras > 0 && options->seconds > 0 && options->rate > 0 && options->fps > 0;
+}
+
+struct Stats
+{
+    int64_t count = 0;
+    double min = 0;
+    double median = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+Stats makeStats(std::vector<double> values)
+{
+    Stats stats;
+    if (values.empty())
+        return stats;
+    std::sort(values.begin(), values.end());
+    const auto percentile = // Nearest-rank method.
+        [&values](int percent)
+        {
+            const size_t rank = (values.size() * percent + 99) / 100;
+            return values[rank == 0 ? 0 : rank - 1];
+        };
+    stats.count = (int64_t) values.size();
+    stats.min = values.front();
+    stats.median = percentile(50);
+    stats.p99 = percentile(99);
+    stats.max = values.back();
+    return stats;
+}
+
+/**
+ * Matches the received packets with the messages they were made of, via the sequence slot encoded
+ * in the boxes: the message is the latest one with this slot sent before the packet has arrived.
+ * Only the first packet of each message counts.
+ */
+void collectLatencies(
+    const std::vector<ReceivedPacket>& packets,
+    const std::vector<int64_t>& sendTimesUs,
+    int64_t windowStartUs,
+    std::vector<double>* outLatenciesUs)
+{
+    std::set<int64_t> matchedSequences;
+    for (const ReceivedPacket& packet: packets)
+    {
+        if (packet.itemCount == 0)
+            continue;
+        const auto sentBefore = std::upper_bound(
+            sendTimesUs.begin(), sendTimesUs.end(), packet.arrivalUs);
+        const int64_t lastSequence = (int64_t) (sentBefore - sendTimesUs.begin()) - 1;
+        if (lastSequence < 0)
+            continue;
+        const int slotCount = CameraSimulator::kSequenceSlotCount;
+        const int64_t slot = CameraSimulator::sequenceSlot(packet.firstBox);
+        const int64_t sequence =
+            lastSequence - (((lastSequence - slot) % slotCount) + slotCount) % slotCount;
+        if (sequence < 0 || sendTimesUs[sequence] < windowStartUs)
+            continue;
+        if (matchedSequences.insert(sequence).second)
+            outLatenciesUs->push_back((double) (packet.arrivalUs - sendTimesUs[sequence]));
+    }
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options))
+        return 2;
+
+    CameraSimulator::Params simulatorParams;
+    simulatorParams.cameraCount = options.cameras;
+    simulatorParams.port = options.port;
+    simulatorParams.messagesPerSecond = options.rate;
+    simulatorParams.targetCount = options.targets;
+    CameraSimulator simulator(simulatorParams);
+    std::string error;
+    if (!simulator.start(&error))
+    {
+        std::cerr << "ERROR: " << error << std::endl;
+        return 1;
+    }
+
+    const std::string homeDir = makeHomeDir("AIBox_host_bench");
+    int result = 1;
+    {
+        FakeHost host(homeDir);
+        if (!host.load(options.plugin))
+        {
+            std::cerr << "ERROR: " << host.error() << std::endl;
+            return 1;
+        }
+
+        const int64_t startupStartUs = steadyClockUs();
+        for (int i = 0; i < options.cameras; ++i)
+        {
+            if (!host.addDevice(simulatedCameraParams(i)))
+            {
+                std::cerr << "ERROR: " << host.error() << std::endl;
+                return 1;
+            }
+        }
+
+        // The Server feeds the video of all cameras from its own threads; one is enough here.
+        std::atomic<bool> stopFeeding{false};
+        std::thread feeder(
+            [&]()
+            {
+                const auto period = std::chrono::microseconds(1000000 / options.fps);
+                auto nextFrame = std::chrono::steady_clock::now();
+                while (!stopFeeding)
+                {
+                    const int64_t timestampUs =
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+                    for (const auto& device: host.devices())
+                        host.pushVideoFrame(device.get(), timestampUs);
+                    nextFrame += period;
+                    std::this_thread::sleep_until(nextFrame);
+                }
+            });
+
+        // The connections are admitted at a limited rate; see SubscriptionRegistry.
+        const auto startupDeadline = std::chrono::steady_clock::now()
+            + std::chrono::seconds(30 + options.cameras / 5);
+        while (simulator.subscribedCameraCount() < options.cameras
+            && std::chrono::steady_clock::now() < startupDeadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        const int subscribedCameraCount = simulator.subscribedCameraCount();
+        const double startupS = (double) (steadyClockUs() - startupStartUs) / 1000000;
+
+        for (const auto& device: host.devices())
+            device->handler->takePackets();
+        const int64_t windowStartUs = steadyClockUs();
+        const int64_t processCpuStartUs = processCpuUs();
+        const int64_t harnessCpuStartUs = simulator.cpuUs() + threadCpuUs(feeder);
+
+        std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+
+        const int64_t windowUs = steadyClockUs() - windowStartUs;
+        const int64_t processCpuUsedUs = processCpuUs() - processCpuStartUs;
+        const int64_t harnessCpuUsedUs =
+            simulator.cpuUs() + threadCpuUs(feeder) - harnessCpuStartUs;
+        stopFeeding = true;
+        feeder.join();
+
+        std::vector<double> latenciesUs;
+        int64_t sentCount = 0;
+        int64_t packetCount = 0;
+        for (const auto& device: host.devices())
+        {
+            const std::vector<ReceivedPacket> packets = device->handler->takePackets();
+            const std::vector<int64_t> sendTimesUs = simulator.sendTimesUs(device->index);
+            packetCount += (int64_t) packets.size();
+            sentCount += sendTimesUs.end() - std::lower_bound(
+                sendTimesUs.begin(), sendTimesUs.end(), windowStartUs);
+            collectLatencies(packets, sendTimesUs, windowStartUs, &latenciesUs);
+        }
+        const Stats latency = makeStats(latenciesUs);
+
+        // The simulator and the feeder threads are the Server's and the cameras' share.
+        const bool hasCpu = processCpuStartUs >= 0 && harnessCpuStartUs >= 0;
+        const double pluginCpuPercentPerCamera = hasCpu
+            ? 100.0 * (double) (processCpuUsedUs - harnessCpuUsedUs)
+                / (double) windowUs / options.cameras
+            : -1;
+
+        std::cout << nx::kit::utils::format(
+            "Cameras: %d of %d subscribed in %.1f s\n"
+            "Messages sent: %lld, received as packets: %lld (%lld packets in total)\n"
+            "Latency, camera to Server: min %.0f us, median %.0f us, p99 %.0f us, max %.0f us\n",
+            subscribedCameraCount, options.cameras, startupS,
+            (long long) sentCount, (long long) latency.count, (long long) packetCount,
+            latency.min, latency.median, latency.p99, latency.max);
+        if (hasCpu)
+        {
+            std::cout << nx::kit::utils::format(
+                "Plugin CPU per camera: %.3f%% of a core\n", pluginCpuPercentPerCamera);
+        }
+
+        if (!options.json.empty())
+        {
+            std::ofstream json(options.json);
+            json << nx::kit::utils::format(R"json({
+    "suite": "AIBox_host_bench",
+    "cameras": %d,
+    "subscribedCameras": %d,
+    "seconds": %d,
+    "messagesPerSecond": %d,
+    "targets": %d,
+    "startupS": %.3f,
+    "messagesSent": %lld,
+    "messagesReceived": %lld,
+    "packets": %lld,
+    "latencyMinUs": %.0f,
+    "latencyMedianUs": %.0f,
+    "latencyP99Us": %.0f,
+    "latencyMaxUs": %.0f,
+    "pluginCpuPercentPerCamera": %.4f
+}
+)json",
+                options.cameras, subscribedCameraCount, options.seconds, options.rate,
+                options.targets, startupS, (long long) sentCount, (long long) latency.count,
+                (long long) packetCount, latency.min, latency.median, latency.p99, latency.max,
+                pluginCpuPercentPerCamera);
+        }
+
+        // The Plugin unsubscribes while the cameras are still there.
+        host.removeDevices();
+
+        result = (subscribedCameraCount == options.cameras && latency.count > 0) ? 0 : 1;
+    }
+    simulator.stop();
+
+    removeHomeDir(homeDir);
+    return result;
+}
@@ -0,0 +1,337 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "camera_simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+
+#include <nx/kit/utils.h>
+
+#include "fake_host.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace bench {
+
+struct CameraSimulator::Connection
+{
+    explicit Connection(asio::io_context& ioContext, Camera* camera):
+        socket(ioContext), camera(camera)
+    {
+    }
+
+    asio::ip::tcp::socket socket;
+    Camera* const camera;
+    asio::streambuf buffer;
+    std::deque<std::string> writeQueue;
+    bool isSubscribed = false;
+};
+
+struct CameraSimulator::Camera
+{
+    Camera(asio::io_context& ioContext, int index):
+        index(index), acceptor(ioContext), timer(ioContext)
+    {
+    }
+
+    const int index;
+    asio::ip::tcp::acceptor acceptor;
+    asio::steady_timer timer;
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<int64_t> sendTimesUs;
+    int subscribedConnectionCount = 0;
+};
+
+CameraSimulator::CameraSimulator(const Params& params): m_params(params)
+{
+}
+
+CameraSimulator::~CameraSimulator()
+{
+    stop();
+}
+
+std::string CameraSimulator::address(int cameraIndex)
+{
+    return nx::kit::utils::format("127.0.%d.%d", 1 + cameraIndex / 254, 1 + cameraIndex % 254);
+}
+
+std::string CameraSimulator::mac(int cameraIndex)
+{
+    return nx::kit::utils::format("02:00:00:%02x:%02x:%02x",
+        (cameraIndex >> 16) & 0xFF, (cameraIndex >> 8) & 0xFF, cameraIndex & 0xFF);
+}
+
+int CameraSimulator::sequenceSlot(const nx::sdk::analytics::Rect& box)
+{
+    return (int) std::lround(box.x * 10000 / kBoxStep);
+}
+
+bool CameraSimulator::start(std::string* outError)
+{
+    for (int i = 0; i < m_params.cameraCount; ++i)
+    {
+        auto camera = std::make_unique<Camera>(m_ioContext, i);
+        const asio::ip::tcp::endpoint endpoint(
+            asio::ip::make_address(address(i)), (unsigned short) m_params.port);
+        asio::error_code error;
+        camera->acceptor.open(endpoint.protocol(), error);
+        if (!error)
+            camera->acceptor.set_option(asio::socket_base::reuse_address(true), error);
+        if (!error)
+            camera->acceptor.bind(endpoint, error);
+        if (!error)
+            camera->acceptor.listen(asio::socket_base::max_listen_connections, error);
+        if (error)
+        {
+            *outError = "Unable to listen on " + address(i) + ":" + std::to_string(m_params.port)
+                + ": " + error.message();
+            return false;
+        }
+        m_cameras.push_back(std::move(camera));
+    }
+
+    for (const auto& camera: m_cameras)
+    {
+        accept(camera.get());
+        scheduleMessage(camera.get());
+    }
+    m_thread = std::thread([this]() { m_ioContext.run(); });
+    return true;
+}
+
+void CameraSimulator::stop()
+{
+    if (!m_thread.joinable())
+        return;
+    m_ioContext.stop();
+    m_thread.join();
+}
+
+int CameraSimulator::subscribedCameraCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for (const auto& camera: m_cameras)
+    {
+        if (camera->subscribedConnectionCount > 0)
+            ++count;
+    }
+    return count;
+}
+
+std::vector<int64_t> CameraSimulator::sendTimesUs(int cameraIndex) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cameras[cameraIndex]->sendTimesUs;
+}
+
+int64_t CameraSimulator::cpuUs()
+{
+    return m_thread.joinable() ? threadCpuUs(m_thread) : -1;
+}
+
+void CameraSimulator::accept(Camera* camera)
+{
+    auto connection = std::make_shared<Connection>(m_ioContext, camera);
+    camera->acceptor.async_accept(connection->socket,
+        [this, camera, connection](const asio::error_code& error)
+        {
+            if (error)
+                return;
+            connection->socket.set_option(asio::ip::tcp::no_delay(true));
+            camera->connections.push_back(connection);
+            readRequest(connection);
+            accept(camera);
+        });
+}
+
+void CameraSimulator::readRequest(const std::shared_ptr<Connection>& connection)
+{
+    asio::async_read_until(connection->socket, connection->buffer, "\r\n\r\n",
+        [this, connection](const asio::error_code& error, size_t /*bytesTransferred*/)
+        {
+            Camera* const camera = connection->camera;
+            if (error)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (connection->isSubscribed)
+                    --camera->subscribedConnectionCount;
+                connection->isSubscribed = false;
+                camera->connections.erase(std::remove(
+                    camera->connections.begin(), camera->connections.end(), connection),
+                    camera->connections.end());
+                return;
+            }
+
+            std::istream stream(&connection->buffer);
+            std::string firstLine;
+            std::getline(stream, firstLine);
+            size_t contentLength = 0;
+            std::string line;
+            while (std::getline(stream, line) && line != "\r")
+            {
+                static const std::string kContentLength = "Content-Length:";
+                if (line.compare(0, kContentLength.size(), kContentLength) == 0)
+                    contentLength = std::stoul(line.substr(kContentLength.size()));
+            }
+
+            // The request body is not needed, only skipped.
+            const size_t bufferedSize = std::min(contentLength, connection->buffer.size());
+            connection->buffer.consume(bufferedSize);
+            asio::async_read(connection->socket, connection->buffer,
+                asio::transfer_exactly(contentLength - bufferedSize),
+                [this, connection, firstLine](const asio::error_code& error, size_t bytes)
+                {
+                    if (error)
+                        return;
+                    connection->buffer.consume(bytes);
+                    handleRequest(connection, firstLine);
+                    readRequest(connection);
+                });
+        });
+}
+
+void CameraSimulator::handleRequest(
+    const std::shared_ptr<Connection>& connection, const std::string& firstLine)
+{
+    const std::string body =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<config version=\"1.7\" xmlns=\"http://www.ipc.com/ver10\" status=\"success\">\n"
+        "    <serverAddress><![CDATA[http://" + address(connection->camera->index)
+            + "/]]></serverAddress>\n"
+        "</config>\n";
+    send(connection,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/xml; charset=\"UTF-8\"\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n" + body);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const bool isSubscribed = firstLine.find("/SetSubscribe") != std::string::npos;
+    const bool isUnsubscribed = firstLine.find("/SetUnSubscribe") != std::string::npos;
+    if (isSubscribed && !connection->isSubscribed)
+        ++connection->camera->subscribedConnectionCount;
+    else if (isUnsubscribed && connection->isSubscribed)
+        --connection->camera->subscribedConnectionCount;
+    if (isSubscribed || isUnsubscribed)
+        connection->isSubscribed = isSubscribed;
+}
+
+void CameraSimulator::send(const std::shared_ptr<Connection>& connection, std::string data)
+{
+    connection->writeQueue.push_back(std::move(data));
+    if (connection->writeQueue.size() == 1)
+        writeNext(connection);
+}
+
+void CameraSimulator::writeNext(const std::shared_ptr<Connection>& connection)
+{
+    asio::async_write(connection->socket, asio::buffer(connection->writeQueue.front()),
+        [this, connection](const asio::error_code& error, size_t /*bytesTransferred*/)
+        {
+            if (error)
+                return;
+            connection->writeQueue.pop_front();
+            if (!connection->writeQueue.empty())
+                writeNext(connection);
+        });
+}
+
+void CameraSimulator::scheduleMessage(Camera* camera)
+{
+    // The cameras are spread evenly over the message period, as the real ones are not in sync.
+    const auto period =
+        std::chrono::microseconds(1000000 / std::max(1, m_params.messagesPerSecond));
+    if (camera->timer.expiry() == asio::steady_timer::time_point())
+        camera->timer.expires_after(period * camera->index / std::max(1, m_params.cameraCount));
+    else
+        camera->timer.expires_at(camera->timer.expiry() + period);
+    camera->timer.async_wait(
+        [this, camera](const asio::error_code& error)
+        {
+            if (error)
+                return;
+            sendMessage(camera);
+            scheduleMessage(camera);
+        });
+}
+
+void CameraSimulator::sendMessage(Camera* camera)
+{
+    std::vector<std::shared_ptr<Connection>> subscribedConnections;
+    for (const auto& connection: camera->connections)
+    {
+        if (connection->isSubscribed)
+            subscribedConnections.push_back(connection);
+    }
+
+    if (subscribedConnections.empty())
+        return;
+
+    int64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sequence = (int64_t) camera->sendTimesUs.size();
+        camera->sendTimesUs.push_back(steadyClockUs());
+    }
+    const std::string body = makeMessage(camera->index, sequence);
+    const std::string message =
+        "POST /SendAlarmData HTTP/1.1\r\n"
+        "Host: " + address(camera->index) + "\r\n"
+        "Content-Type: application/xml; charset=\"UTF-8\"\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n" + body;
+    for (const auto& connection: subscribedConnections)
+        send(connection, message);
+}
+
+std::string CameraSimulator::makeMessage(int cameraIndex, int64_t sequence) const
+{
+    const int targetCount = std::min(m_params.targetCount, kMaxTargetCount);
+    const int x1 = (int) (sequence % kSequenceSlotCount) * kBoxStep;
+
+    // The camera clock is the same as the Server one, as if both were synchronized via NTP.
+    const int64_t systemClockMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::string xml =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<config version=\"1.7\" xmlns=\"http://www.ipc.com/ver10\">\n"
+        "    <smartType>PEA</smartType>\n"
+        "    <subscribeOption>FEATURE_RESULT</subscribeOption>\n"
+        "    <currentTime>" + std::to_string(systemClockMs) + "</currentTime>\n"
+        "    <mac>" + mac(cameraIndex) + "</mac>\n"
+        "    <deviceName>IPC</deviceName>\n"
+        "    <traject type=\"list\" count=\"" + std::to_string(targetCount) + "\">\n";
+    for (int i = 0; i < targetCount; ++i)
+    {
+        xml +=
+            "        <item>\n"
+            "            <targetId>" + std::to_string(1000 + i) + "</targetId>\n"
+            "            <targetType>" + (i % 2 == 0 ? "person" : "car") + "</targetType>\n"
+            "            <rect>\n"
+            "                <x1>" + std::to_string(x1) + "</x1>\n"
+            "                <y1>" + std::to_string(800 * i) + "</y1>\n"
+            "                <x2>" + std::to_string(x1 + 1000) + "</x2>\n"
+            "                <y2>" + std::to_string(800 * i + 700) + "</y2>\n"
+            "            </rect>\n"
+            "        </item>\n";
+    }
+    xml +=
+        "    </traject>\n"
+        "</config>\n";
+    return xml;
+}
+
+} // namespace bench
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,100 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <nx/sdk/analytics/rect.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace bench {
+
+/**
+ * Local stand-in for the cameras: each camera listens on its own loopback address, accepts the
+ * subscription of the Plugin, and then pushes the PEA trajectory messages at the given rate.
+ *
+ * The sequence number of each message is encoded in the x coordinate of all its boxes, so that
+ * the metadata packet received by the Server can be matched with the message it came from; see
+ * sequenceSlot().
+ */
+class CameraSimulator
+{
+public:
+    struct Params
+    {
+        int cameraCount = 1;
+        int port = 8080; //< The Plugin connects to this port.
+        int messagesPerSecond = 10;
+        int targetCount = 5; //< At most kMaxTargetCount.
+    };
+
+    static constexpr int kMaxTargetCount = 10;
+
+    /** Boxes move by this many units of the 10000x10000 grid per message. */
+    static constexpr int kBoxStep = 25;
+
+    /** The sequence numbers are recoverable from the boxes modulo this. */
+    static constexpr int kSequenceSlotCount = 300;
+
+public:
+    explicit CameraSimulator(const Params& params);
+    ~CameraSimulator();
+
+    /** @return False on error, e.g. if an address cannot be listened on. */
+    bool start(std::string* outError);
+
+    void stop();
+
+    /** Loopback address of the camera: 127.0.x.y. */
+    static std::string address(int cameraIndex);
+
+    static std::string mac(int cameraIndex);
+
+    /** @return Sequence number of the message modulo kSequenceSlotCount. */
+    static int sequenceSlot(const nx::sdk::analytics::Rect& box);
+
+    /** @return Number of the cameras having at least one subscribed connection. */
+    int subscribedCameraCount() const;
+
+    /** @return Moments (steady clock) of sending the messages, indexed by sequence number. */
+    std::vector<int64_t> sendTimesUs(int cameraIndex) const;
+
+    /** @return CPU time consumed by the simulator thread, or -1 if not supported. */
+    int64_t cpuUs();
+
+private:
+    struct Connection;
+    struct Camera;
+
+    void accept(Camera* camera);
+    void readRequest(const std::shared_ptr<Connection>& connection);
+    void handleRequest(const std::shared_ptr<Connection>& connection, const std::string& firstLine);
+    void send(const std::shared_ptr<Connection>& connection, std::string data);
+    void writeNext(const std::shared_ptr<Connection>& connection);
+    void scheduleMessage(Camera* camera);
+    void sendMessage(Camera* camera);
+    std::string makeMessage(int cameraIndex, int64_t sequence) const;
+
+private:
+    const Params m_params;
+    asio::io_context m_ioContext;
+    std::vector<std::unique_ptr<Camera>> m_cameras;
+    mutable std::mutex m_mutex; //< Guards the Camera state read by the other threads.
+    std::thread m_thread;
+};
+
+} // namespace bench
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
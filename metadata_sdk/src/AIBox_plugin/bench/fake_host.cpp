@@ -0,0 +1,446 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "fake_host.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#if defined(__GNUC__) && __GNUC__ < 9
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#else
+#include <filesystem>
+namespace fs = std::filesystem;
+#endif
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+    #include <pthread.h>
+    #include <time.h>
+#endif
+
+#include <nx/sdk/analytics/helpers/engine_info.h>
+#include <nx/sdk/analytics/helpers/metadata_types.h>
+#include <nx/sdk/analytics/i_compressed_video_packet.h>
+#include <nx/sdk/analytics/i_object_metadata_packet.h>
+#include <nx/sdk/helpers/device_info.h>
+#include <nx/sdk/helpers/error.h>
+#include <nx/sdk/helpers/string.h>
+#include <nx/sdk/helpers/string_map.h>
+#include <nx/sdk/i_plugin.h>
+
+#include "camera_simulator.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace bench {
+
+using namespace nx::sdk;
+using namespace nx::sdk::analytics;
+
+namespace {
+
+/** Carries only the timestamp: the Plugin does not look into the video. */
+class CompressedVideoPacket: public RefCountable<ICompressedVideoPacket>
+{
+public:
+    explicit CompressedVideoPacket(int64_t timestampUs): m_timestampUs(timestampUs) {}
+
+    virtual int64_t timestampUs() const override { return m_timestampUs; }
+    virtual const char* codec() const override { return "h264"; }
+    virtual const char* data() const override { return nullptr; }
+    virtual int dataSize() const override { return 0; }
+    virtual MediaFlags flags() const override { return MediaFlags::keyFrame; }
+    virtual int width() const override { return 1920; }
+    virtual int height() const override { return 1080; }
+
+protected:
+    virtual const IMediaContext* getContext() const override { return nullptr; }
+    virtual IList<IMetadataPacket>* getMetadataList() const override { return nullptr; }
+
+private:
+    const int64_t m_timestampUs;
+};
+
+std::string errorMessage(const Error& error)
+{
+    const Ptr<const IString> message(error.errorMessage());
+    return message ? message->str() : "error " + std::to_string((int) error.errorCode());
+}
+
+/** Releases the response, which the Host does not need. */
+template<typename Value>
+bool checkResult(const Result<Value*>& result, std::string* outError)
+{
+    const Ptr<Value> value(result.value());
+    if (result.isOk())
+        return true;
+    *outError = errorMessage(result.error());
+    return false;
+}
+
+bool checkResult(const Result<void>& result, std::string* outError)
+{
+    if (result.isOk())
+        return true;
+    *outError = errorMessage(result.error());
+    return false;
+}
+
+} // namespace
+
+int64_t steadyClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__linux__)
+
+static int64_t cpuClockUs(clockid_t clock)
+{
+    timespec time{};
+    if (clock_gettime(clock, &time) != 0)
+        return -1;
+    return (int64_t) time.tv_sec * 1000000 + time.tv_nsec / 1000;
+}
+
+int64_t processCpuUs()
+{
+    return cpuClockUs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+int64_t threadCpuUs(std::thread& thread)
+{
+    clockid_t clock;
+    if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0)
+        return -1;
+    return cpuClockUs(clock);
+}
+
+#else
+
+int64_t processCpuUs()
+{
+    return -1;
+}
+
+int64_t threadCpuUs(std::thread& /*thread*/)
+{
+    return -1;
+}
+
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// UtilityProvider
+
+int64_t UtilityProvider::vmsSystemTimeSinceEpochMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char* UtilityProvider::serverId() const
+{
+    return "{00000000-0000-0000-0000-000000000001}";
+}
+
+IString* UtilityProvider::cloudSystemId() const
+{
+    return new String();
+}
+
+IString* UtilityProvider::cloudAuthKey() const
+{
+    return new String();
+}
+
+const IString* UtilityProvider::getHomeDir() const
+{
+    return new String(m_homeDir);
+}
+
+const IString* UtilityProvider::getServerSdkVersion() const
+{
+    return new String("bench");
+}
+
+void UtilityProvider::doSendHttpRequest(
+    HttpDomainName /*requestDomainName*/,
+    const char* /*url*/,
+    const char* /*httpMethod*/,
+    const char* /*mimeType*/,
+    const char* /*requestBody*/,
+    IHttpRequestCompletionHandler* callback) const
+{
+    if (callback)
+        callback->execute(error(ErrorCode::notImplemented, "No Server in the benchmark"));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Handlers
+
+void DeviceAgentHandler::handleMetadata(IMetadataPacket* metadataPacket)
+{
+    ReceivedPacket packet;
+    packet.arrivalUs = steadyClockUs();
+    packet.timestampUs = metadataPacket->timestampUs();
+    if (const auto objectMetadataPacket = metadataPacket->queryInterface<IObjectMetadataPacket>())
+    {
+        packet.itemCount = objectMetadataPacket->count();
+        if (packet.itemCount > 0)
+            packet.firstBox = objectMetadataPacket->at(0)->boundingBox();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_packets.push_back(packet);
+}
+
+void DeviceAgentHandler::handlePluginDiagnosticEvent(IPluginDiagnosticEvent* event)
+{
+    std::cerr << "DeviceAgent diagnostic event: " << event->caption() << ": "
+        << event->description() << std::endl;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_diagnosticEventCount;
+}
+
+void DeviceAgentHandler::pushManifest(const IString* /*manifest*/)
+{
+}
+
+std::vector<ReceivedPacket> DeviceAgentHandler::takePackets()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<ReceivedPacket> packets;
+    packets.swap(m_packets);
+    return packets;
+}
+
+int DeviceAgentHandler::diagnosticEventCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_diagnosticEventCount;
+}
+
+void EngineHandler::handlePluginDiagnosticEvent(IPluginDiagnosticEvent* event)
+{
+    std::cerr << "Engine diagnostic event: " << event->caption() << ": "
+        << event->description() << std::endl;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Simulated cameras
+
+std::string makeHomeDir(const std::string& name)
+{
+    const fs::path dir = fs::temp_directory_path()
+        / (name + "_" + std::to_string(steadyClockUs()));
+    fs::create_directories(dir);
+    std::ofstream manifest((dir / "bench_manifest.json").string());
+    manifest << R"json({
+    "supportedCameraVendors": ["AIBoxBench"],
+    "supportedCameraModels": ["SimulatedCamera"]
+})json";
+    return dir.string();
+}
+
+void removeHomeDir(const std::string& homeDir)
+{
+    std::error_code error;
+    fs::remove_all(homeDir, error);
+}
+
+FakeHost::DeviceParams simulatedCameraParams(int cameraIndex)
+{
+    FakeHost::DeviceParams params;
+    params.id = "camera" + std::to_string(cameraIndex);
+    params.vendor = "AIBoxBench";
+    params.model = "SimulatedCamera";
+    params.url = "http://" + CameraSimulator::address(cameraIndex) + "/";
+    params.sharedId = CameraSimulator::mac(cameraIndex);
+    params.login = "admin";
+    params.password = "admin";
+    params.settings = {
+        {"objectTypeIdToGenerate.nx.base.Person", "true"},
+        {"objectTypeIdToGenerate.nx.base.Car", "true"},
+        {"minBoxChange", "0"},
+    };
+    params.neededObjectTypeIds = {"nx.base.Person", "nx.base.Car"};
+    return params;
+}
+
+//-------------------------------------------------------------------------------------------------
+// FakeHost
+
+FakeHost::FakeHost(std::string homeDir): m_homeDir(std::move(homeDir))
+{
+}
+
+FakeHost::~FakeHost()
+{
+    removeDevices();
+    m_engine.reset();
+    m_plugin.reset();
+
+    // The library is not unloaded, as the Server never does it either.
+}
+
+bool FakeHost::fail(const std::string& error)
+{
+    m_error = error;
+    return false;
+}
+
+bool FakeHost::load(const std::string& libraryPath)
+{
+    #if defined(_WIN32)
+        const HMODULE library = LoadLibraryA(libraryPath.c_str());
+        if (!library)
+            return fail("Unable to load " + libraryPath);
+        const auto symbol = [library](const char* name) { return GetProcAddress(library, name); };
+    #else
+        void* const library = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!library)
+            return fail(std::string("Unable to load ") + libraryPath + ": " + dlerror());
+        const auto symbol = [library](const char* name) { return dlsym(library, name); };
+    #endif
+    m_library = (void*) library;
+
+    // The Server prefers the multi-plugin entry point, and uses the first Plugin of the library.
+    nx::sdk::IPlugin* pluginPtr = nullptr;
+    if (const auto multiEntryPoint = (nx::sdk::IPlugin::MultiEntryPointFunc)
+        symbol(nx::sdk::IPlugin::kMultiEntryPointFuncName))
+    {
+        pluginPtr = multiEntryPoint(/*instanceIndex*/ 0);
+    }
+    else if (const auto entryPoint = (nx::sdk::IPlugin::EntryPointFunc)
+        symbol(nx::sdk::IPlugin::kEntryPointFuncName))
+    {
+        pluginPtr = entryPoint();
+    }
+    else
+    {
+        return fail("No Plugin entry point in " + libraryPath);
+    }
+    const Ptr<nx::sdk::IPlugin> plugin(pluginPtr);
+    if (!plugin)
+        return fail("The entry point has returned no Plugin");
+    return load(plugin);
+}
+
+bool FakeHost::load(Ptr<nx::sdk::IPlugin> plugin)
+{
+    m_plugin = plugin->queryInterface<nx::sdk::analytics::IPlugin>();
+    if (!m_plugin)
+        return fail("The Plugin is not an Analytics Plugin");
+
+    m_utilityProvider = makePtr<UtilityProvider>(m_homeDir);
+    m_plugin->setUtilityProvider(m_utilityProvider.get());
+
+    const Result<IEngine*> engineResult = m_plugin->createEngine();
+    if (!engineResult.isOk())
+        return fail("Unable to create the Engine: " + errorMessage(engineResult.error()));
+    m_engine = Ptr<IEngine>(engineResult.value());
+
+    m_engineHandler = makePtr<EngineHandler>();
+    m_engine->setHandler(m_engineHandler.get());
+
+    const auto engineInfo = makePtr<EngineInfo>();
+    engineInfo->setId("{00000000-0000-0000-0000-000000000002}");
+    engineInfo->setName("AIBox");
+    m_engine->setEngineInfo(engineInfo.get());
+
+    std::string error;
+    if (!checkResult(m_engine->setSettings(makePtr<StringMap>().get()), &error))
+        return fail("Unable to set the Engine settings: " + error);
+    return true;
+}
+
+FakeDevice* FakeHost::addDevice(const DeviceParams& params)
+{
+    const auto deviceInfo = makePtr<DeviceInfo>();
+    deviceInfo->setId(params.id);
+    deviceInfo->setVendor(params.vendor);
+    deviceInfo->setModel(params.model);
+    deviceInfo->setName(params.id);
+    deviceInfo->setUrl(params.url);
+    deviceInfo->setSharedId(params.sharedId);
+    deviceInfo->setLogin(params.login);
+    deviceInfo->setPassword(params.password);
+
+    if (!m_engine->isCompatible(deviceInfo.get()))
+    {
+        fail("The Engine does not support " + params.vendor + " " + params.model);
+        return nullptr;
+    }
+
+    const Result<IDeviceAgent*> deviceAgentResult = m_engine->obtainDeviceAgent(deviceInfo.get());
+    if (!deviceAgentResult.isOk())
+    {
+        fail("Unable to obtain the DeviceAgent: " + errorMessage(deviceAgentResult.error()));
+        return nullptr;
+    }
+    const Ptr<IDeviceAgent> deviceAgent(deviceAgentResult.value());
+
+    auto device = std::make_unique<FakeDevice>();
+    device->index = (int) m_devices.size();
+    device->deviceAgent = deviceAgent->queryInterface<IConsumingDeviceAgent>();
+    if (!device->deviceAgent)
+    {
+        fail("The DeviceAgent does not consume the video");
+        return nullptr;
+    }
+    device->handler = makePtr<DeviceAgentHandler>();
+    device->deviceAgent->setHandler(device->handler.get());
+
+    // The same order of calls as in the Server.
+    std::string error;
+    const auto settings = makePtr<StringMap>(StringMap::Map(
+        params.settings.begin(), params.settings.end()));
+    if (!checkResult(device->deviceAgent->setSettings(settings.get()), &error))
+    {
+        fail("Unable to set the DeviceAgent settings: " + error);
+        return nullptr;
+    }
+    const auto neededMetadataTypes = makePtr<MetadataTypes>();
+    for (const std::string& objectTypeId: params.neededObjectTypeIds)
+        neededMetadataTypes->addObjectTypeId(objectTypeId);
+    if (!checkResult(
+        device->deviceAgent->setNeededMetadataTypes(neededMetadataTypes.get()), &error))
+    {
+        fail("Unable to set the needed metadata types: " + error);
+        return nullptr;
+    }
+
+    m_devices.push_back(std::move(device));
+    return m_devices.back().get();
+}
+
+void FakeHost::pushVideoFrame(FakeDevice* device, int64_t timestampUs)
+{
+    const auto packet = makePtr<CompressedVideoPacket>(timestampUs);
+    std::string error;
+    if (!checkResult(device->deviceAgent->pushDataPacket(packet.get()), &error))
+    {
+        std::cerr << "Device #" << device->index << " rejected a video frame: " << error
+            << std::endl;
+    }
+}
+
+void FakeHost::removeDevices()
+{
+    for (const auto& device: m_devices)
+        device->deviceAgent->finalize();
+    m_devices.clear();
+}
+
+} // namespace bench
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,178 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nx/sdk/analytics/i_consuming_device_agent.h>
+#include <nx/sdk/analytics/i_device_agent.h>
+#include <nx/sdk/analytics/i_engine.h>
+#include <nx/sdk/analytics/i_plugin.h>
+#include <nx/sdk/analytics/rect.h>
+#include <nx/sdk/helpers/ref_countable.h>
+#include <nx/sdk/i_plugin.h>
+#include <nx/sdk/i_utility_provider.h>
+#include <nx/sdk/ptr.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace bench {
+
+int64_t steadyClockUs();
+
+/** @return CPU time consumed by the process, or -1 if not supported on this platform. */
+int64_t processCpuUs();
+
+/** @return CPU time consumed by the thread, or -1 if not supported on this platform. */
+int64_t threadCpuUs(std::thread& thread);
+
+/** Answers the Plugin's questions about the Server; only the home dir is meaningful. */
+class UtilityProvider: public nx::sdk::RefCountable<nx::sdk::IUtilityProvider>
+{
+public:
+    explicit UtilityProvider(std::string homeDir): m_homeDir(std::move(homeDir)) {}
+
+    virtual int64_t vmsSystemTimeSinceEpochMs() const override;
+    virtual const char* serverId() const override;
+    virtual nx::sdk::IString* cloudSystemId() const override;
+    virtual nx::sdk::IString* cloudAuthKey() const override;
+
+protected:
+    virtual const nx::sdk::IString* getHomeDir() const override;
+    virtual const nx::sdk::IString* getServerSdkVersion() const override;
+    virtual void doSendHttpRequest(
+        HttpDomainName requestDomainName,
+        const char* url,
+        const char* httpMethod,
+        const char* mimeType,
+        const char* requestBody,
+        IHttpRequestCompletionHandler* callback) const override;
+
+private:
+    const std::string m_homeDir;
+};
+
+/** Metadata packet as received by the Server, with the moment it has arrived. */
+struct ReceivedPacket
+{
+    int64_t timestampUs = 0;
+    int64_t arrivalUs = 0; //< steadyClockUs().
+    int itemCount = 0;
+    nx::sdk::analytics::Rect firstBox; //< Box of the first object, if any.
+};
+
+/** Records every metadata packet which the DeviceAgent pushes. */
+class DeviceAgentHandler: public nx::sdk::RefCountable<nx::sdk::analytics::IDeviceAgent::IHandler>
+{
+public:
+    virtual void handleMetadata(nx::sdk::analytics::IMetadataPacket* metadataPacket) override;
+    virtual void handlePluginDiagnosticEvent(nx::sdk::IPluginDiagnosticEvent* event) override;
+    virtual void pushManifest(const nx::sdk::IString* manifest) override;
+
+    /** @return The packets received since the previous call, in the order of arrival. */
+    std::vector<ReceivedPacket> takePackets();
+
+    int diagnosticEventCount() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<ReceivedPacket> m_packets;
+    int m_diagnosticEventCount = 0;
+};
+
+class EngineHandler: public nx::sdk::RefCountable<nx::sdk::analytics::IEngine::IHandler>
+{
+public:
+    virtual void handlePluginDiagnosticEvent(nx::sdk::IPluginDiagnosticEvent* event) override;
+};
+
+struct FakeDevice
+{
+    int index = 0;
+    nx::sdk::Ptr<nx::sdk::analytics::IConsumingDeviceAgent> deviceAgent;
+    nx::sdk::Ptr<DeviceAgentHandler> handler;
+};
+
+/**
+ * Plays the role of the Server for the Plugin library: loads it via its entry point, creates the
+ * Engine and the DeviceAgents, and feeds them the video frame timestamps. Not thread-safe, except
+ * that the DeviceAgent handlers may be called from the Plugin threads.
+ */
+class FakeHost
+{
+public:
+    struct DeviceParams
+    {
+        std::string id;
+        std::string vendor;
+        std::string model;
+        std::string url;
+        std::string sharedId;
+        std::string login;
+        std::string password;
+        std::map<std::string, std::string> settings;
+        std::vector<std::string> neededObjectTypeIds;
+    };
+
+public:
+    /** @param homeDir Plugin home dir, where the Plugin looks for the manifests. */
+    explicit FakeHost(std::string homeDir);
+    ~FakeHost();
+
+    /** @return False on error; see error(). */
+    bool load(const std::string& libraryPath);
+
+    /** Uses the Plugin built into the executable instead of a library. */
+    bool load(nx::sdk::Ptr<nx::sdk::IPlugin> plugin);
+
+    /** @return Null on error; see error(). */
+    FakeDevice* addDevice(const DeviceParams& params);
+
+    /** Feeds a compressed video frame without any media data, only with the timestamp. */
+    void pushVideoFrame(FakeDevice* device, int64_t timestampUs);
+
+    /** Destroys the DeviceAgents, as the Server does when the cameras are removed. */
+    void removeDevices();
+
+    const std::vector<std::unique_ptr<FakeDevice>>& devices() const { return m_devices; }
+
+    const std::string& error() const { return m_error; }
+
+private:
+    bool fail(const std::string& error);
+
+private:
+    const std::string m_homeDir;
+    std::string m_error;
+    void* m_library = nullptr;
+    nx::sdk::Ptr<UtilityProvider> m_utilityProvider;
+    nx::sdk::Ptr<nx::sdk::analytics::IPlugin> m_plugin;
+    nx::sdk::Ptr<nx::sdk::analytics::IEngine> m_engine;
+    nx::sdk::Ptr<EngineHandler> m_engineHandler;
+    std::vector<std::unique_ptr<FakeDevice>> m_devices;
+};
+
+/**
+ * Creates a temporary Plugin home dir with the manifest supporting the simulated cameras.
+ * @param name Prefix of the dir name.
+ */
+std::string makeHomeDir(const std::string& name);
+
+void removeHomeDir(const std::string& homeDir);
+
+/** Device of a CameraSimulator camera, with all the object types enabled and needed. */
+FakeHost::DeviceParams simulatedCameraParams(int cameraIndex);
+
+} // namespace bench
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
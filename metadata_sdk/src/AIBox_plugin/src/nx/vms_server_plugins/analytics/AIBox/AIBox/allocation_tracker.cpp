@@ -0,0 +1,236 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "allocation_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+namespace {
+
+/** Constant-initialized, so usable by operator new during the static initialization. */
+struct Slot
+{
+    std::atomic<const char*> tag{nullptr};
+    std::atomic<int64_t> allocationCount{0};
+    std::atomic<int64_t> byteCount{0};
+};
+
+Slot slots[AllocationTracker::kMaxTagCount];
+std::atomic<int> slotCount{1}; //< Slot 0 is "untagged".
+std::atomic<int64_t> messageCounter{0};
+
+/** Guards only the registration of the tags; std::mutex does not allocate. */
+std::mutex registrationMutex;
+
+int findSlot(const char* tag, int count)
+{
+    for (int i = 1; i < count; ++i)
+    {
+        const char* const slotTag = slots[i].tag.load(std::memory_order_acquire);
+        if (slotTag == tag || std::strcmp(slotTag, tag) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+void AllocationTracker::countMessage()
+{
+    if (isEnabled())
+    {
+        messageCounter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int64_t AllocationTracker::messageCount()
+{
+    return messageCounter.load(std::memory_order_relaxed);
+}
+
+std::vector<AllocationTracker::TagCounts> AllocationTracker::counts()
+{
+    std::vector<TagCounts> result;
+    if (!isEnabled())
+    {
+        return result;
+    }
+
+    const int count = slotCount.load(std::memory_order_acquire);
+    result.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        TagCounts tagCounts;
+        tagCounts.tag = (i == 0) ? "untagged" : slots[i].tag.load(std::memory_order_acquire);
+        tagCounts.allocationCount = slots[i].allocationCount.load(std::memory_order_relaxed);
+        tagCounts.byteCount = slots[i].byteCount.load(std::memory_order_relaxed);
+        result.push_back(std::move(tagCounts));
+    }
+    return result;
+}
+
+void AllocationTracker::reset()
+{
+    for (Slot& slot: slots)
+    {
+        slot.allocationCount.store(0, std::memory_order_relaxed);
+        slot.byteCount.store(0, std::memory_order_relaxed);
+    }
+    messageCounter.store(0, std::memory_order_relaxed);
+}
+
+int AllocationTracker::slotOf(const char* tag)
+{
+    const int slot = findSlot(tag, slotCount.load(std::memory_order_acquire));
+    if (slot >= 0)
+    {
+        return slot;
+    }
+
+    std::lock_guard<std::mutex> lock(registrationMutex);
+    const int count = slotCount.load(std::memory_order_relaxed);
+    const int registeredSlot = findSlot(tag, count);
+    if (registeredSlot >= 0)
+    {
+        return registeredSlot;
+    }
+    if (count == kMaxTagCount)
+    {
+        return 0;
+    }
+    slots[count].tag.store(tag, std::memory_order_release);
+    slotCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+#if defined(AIBOX_ALLOCATION_TRACKING)
+
+static thread_local int currentSlot = 0;
+
+AllocationScope::AllocationScope(const char* tag):
+    m_outerSlot(currentSlot)
+{
+    currentSlot = AllocationTracker::slotOf(tag);
+}
+
+AllocationScope::~AllocationScope()
+{
+    currentSlot = m_outerSlot;
+}
+
+static void countAllocation(std::size_t size)
+{
+    Slot& slot = slots[currentSlot];
+    slot.allocationCount.fetch_add(1, std::memory_order_relaxed);
+    slot.byteCount.fetch_add((int64_t) size, std::memory_order_relaxed);
+}
+
+static void* allocate(std::size_t size)
+{
+    countAllocation(size);
+    for (;;)
+    {
+        if (void* const p = std::malloc(size == 0 ? 1 : size))
+        {
+            return p;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void* allocateNoThrow(std::size_t size) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+#endif // defined(AIBOX_ALLOCATION_TRACKING)
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
+
+#if defined(AIBOX_ALLOCATION_TRACKING)
+
+// The replacement of the global allocation functions. <new> declares them with the default
+// visibility, so the Plugin library exports them, and is linked with -Bsymbolic-functions: they
+// would lose to the ones of libstdc++ otherwise, which come first in the symbol lookup of a
+// dlopen()-ed library. The over-aligned variants are not replaced - the pipeline has no
+// over-aligned types.
+
+using nx::vms_server_plugins::analytics::AIBox::allocate;
+using nx::vms_server_plugins::analytics::AIBox::allocateNoThrow;
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateNoThrow(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateNoThrow(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+#endif // defined(AIBOX_ALLOCATION_TRACKING)
@@ -0,0 +1,87 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Heap allocation accounting of the message pipeline, for the builds with the CMake option
+ * aiboxAllocationTracking (AIBOX_ALLOCATION_TRACKING): the global operator new of the Plugin
+ * counts each allocation and its bytes for the innermost AllocationScope of the calling thread,
+ * or for "untagged". Together with the count of the camera messages, it gives the allocations per
+ * message of each pipeline stage.
+ *
+ * Only the allocations via operator new are seen, i.e. not the direct malloc() calls, e.g. by the
+ * C libraries. In the regular builds, nothing is counted, and the scopes compile to nothing.
+ */
+class AllocationTracker
+{
+public:
+    struct TagCounts
+    {
+        std::string tag;
+        int64_t allocationCount = 0;
+        int64_t byteCount = 0;
+    };
+
+    static constexpr int kMaxTagCount = 32; //< The tags beyond it are counted as "untagged".
+
+    static constexpr bool isEnabled()
+    {
+        #if defined(AIBOX_ALLOCATION_TRACKING)
+            return true;
+        #else
+            return false;
+        #endif
+    }
+
+    /** Counts a camera message, the unit of the per-message figures. */
+    static void countMessage();
+
+    static int64_t messageCount();
+
+    /** @return Counts of the tags which have been entered, in the order of the first entry. */
+    static std::vector<TagCounts> counts();
+
+    /** Zeroes the counts and the message count; the tags stay registered. */
+    static void reset();
+
+    /** @return Slot of the tag, registered on first use; 0 is "untagged". */
+    static int slotOf(const char* tag);
+};
+
+/**
+ * Attributes the allocations of the calling thread to the tag for its lifetime; the scopes nest,
+ * the innermost one wins.
+ */
+class AllocationScope
+{
+public:
+    #if defined(AIBOX_ALLOCATION_TRACKING)
+        /** @param tag String literal, e.g. a pipeline stage name. */
+        explicit AllocationScope(const char* tag);
+        ~AllocationScope();
+    #else
+        explicit AllocationScope(const char* /*tag*/) {}
+    #endif
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+#if defined(AIBOX_ALLOCATION_TRACKING)
+private:
+    const int m_outerSlot;
+#endif
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
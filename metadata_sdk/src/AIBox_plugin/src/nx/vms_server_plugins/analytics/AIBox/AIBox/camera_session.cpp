@@ -0,0 +1,194 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "camera_session.h"
+
+#include <cctype>
+#include <chrono>
+
+#include <nx/kit/debug.h>
+
+#include "metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+CameraSession::CameraSession(
+    std::string key,
+    std::string host,
+    unsigned short port,
+    std::string subscribePath,
+    std::string basicAuth)
+    :
+    m_key(std::move(key)),
+    m_host(std::move(host)),
+    m_port(port),
+    m_subscribePath(std::move(subscribePath)),
+    m_basicAuth(std::move(basicAuth))
+{
+    m_subscriber.setConnectionStateChangedCallback([this]() { wakeUpConnectWaiters(); });
+}
+
+CameraSession::~CameraSession()
+{
+    stop();
+}
+
+void CameraSession::start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isStarted && m_subscriber.isSubscribed())
+    {
+        return;
+    }
+    // A started session which has failed to connect, or has lost the connection, reconnects.
+    NX_PRINT << (m_isStarted ? "IPC Subscription restarting..." : "IPC Subscription starting...");
+    m_subscriber.startIpcSubscription(m_host, m_port, m_subscribePath, m_basicAuth);
+    m_isStarted = true;
+}
+
+void CameraSession::stop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_isStarted)
+    {
+        return;
+    }
+    m_subscriber.registerPEAResultCallback(nullptr);
+    m_subscriber.stopIpcSubscription();
+    m_isStarted = false;
+    NX_PRINT << "IPC Subscription stopped.";
+}
+
+bool CameraSession::waitUntilConnected(int timeoutMs, const std::function<bool()>& isCancelled)
+{
+    std::unique_lock<std::mutex> lock(m_connectMutex);
+    m_connectionStateChanged.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+        [this, &isCancelled]() { return m_subscriber.isSubscribed() || isCancelled(); });
+    return m_subscriber.isSubscribed();
+}
+
+void CameraSession::wakeUpConnectWaiters()
+{
+    {
+        // Makes sure the waiters are either waiting, or will check the connection.
+        std::lock_guard<std::mutex> lock(m_connectMutex);
+    }
+    m_connectionStateChanged.notify_all();
+}
+
+int CameraSession::addChannel(const std::string& mac, Subscriber::PEAResultCallback handler)
+{
+    // Serializes the callback (un)registration of concurrent addChannel() and removeChannel().
+    std::lock_guard<std::mutex> sessionLock(m_mutex);
+
+    int channelId = 0;
+    bool isFirstChannel = false;
+    {
+        std::lock_guard<std::mutex> lock(m_channelMutex);
+        channelId = m_nextChannelId++;
+        isFirstChannel = m_channels.empty();
+        m_channels[channelId] = Channel{normalizeMac(mac), std::move(handler)};
+    }
+
+    // Without channels the messages are not even parsed. Not registered under m_channelMutex,
+    // because the Subscriber calls dispatch() under its own lock.
+    if (isFirstChannel)
+    {
+        m_subscriber.registerPEAResultCallback(
+            [this](const PEAResult& result) { dispatch(result); });
+    }
+    return channelId;
+}
+
+void CameraSession::removeChannel(int channelId)
+{
+    std::lock_guard<std::mutex> sessionLock(m_mutex);
+
+    bool isLastChannel = false;
+    {
+        std::lock_guard<std::mutex> lock(m_channelMutex);
+        m_channels.erase(channelId);
+        isLastChannel = m_channels.empty();
+    }
+    if (isLastChannel)
+    {
+        m_subscriber.registerPEAResultCallback(nullptr);
+    }
+}
+
+void CameraSession::dispatch(const PEAResult& result)
+{
+    std::lock_guard<std::mutex> lock(m_channelMutex);
+
+    // The MAC is optional in the messages, and a camera may report the MAC of another of its
+    // network interfaces, so the only channel receives all the messages.
+    if (m_channels.size() == 1)
+    {
+        m_channels.begin()->second.handler(result);
+        return;
+    }
+
+    const std::string mac = normalizeMac(result.deviceMac);
+    bool hasChannelsWithMac = false;
+    bool isRouted = false;
+    for (const auto& entry: m_channels)
+    {
+        const Channel& channel = entry.second;
+        if (!channel.mac.empty())
+        {
+            hasChannelsWithMac = true;
+        }
+        if (channel.mac.empty() || channel.mac == mac)
+        {
+            isRouted = isRouted || !channel.mac.empty();
+            channel.handler(result);
+        }
+    }
+
+    // Not shown on all the devices of the endpoint, as it belongs to one of them at most.
+    if (hasChannelsWithMac && !isRouted)
+    {
+        Metrics::instance().value("session.unroutedMessages").fetch_add(1);
+    }
+}
+
+void CameraSession::storeTrackState(
+    const std::string& deviceId, std::unique_ptr<CameraTrackState> trackState)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_trackStates[deviceId] = std::move(trackState);
+}
+
+std::unique_ptr<CameraTrackState> CameraSession::takeTrackState(const std::string& deviceId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_trackStates.find(deviceId);
+    if (it == m_trackStates.end())
+    {
+        return nullptr;
+    }
+    std::unique_ptr<CameraTrackState> trackState = std::move(it->second);
+    m_trackStates.erase(it);
+    return trackState;
+}
+
+std::string CameraSession::normalizeMac(const std::string& mac)
+{
+    std::string result;
+    result.reserve(12);
+    for (const char ch: mac)
+    {
+        if (std::isxdigit(static_cast<unsigned char>(ch)))
+        {
+            result.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+        }
+    }
+    return result;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,128 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "clock_sync_estimator.h"
+#include "duplicate_message_filter.h"
+#include "track_table.h"
+#include "../net/subscriber.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/** State of the tracks of a camera, handed over between the DeviceAgents of the camera. */
+struct CameraTrackState
+{
+    TrackTable trackTable;
+    DuplicateMessageFilter duplicateMessageFilter;
+    ClockSyncEstimator clockSyncEstimator{0, 0};
+};
+
+/**
+ * Subscription to the PEA messages of a physical endpoint. Several VMS devices may be behind the
+ * same endpoint (channels of a multi-channel device, or an AIBox appliance serving several
+ * cameras): they share a single connection, and the messages are demultiplexed to their
+ * DeviceAgents by the MAC address.
+ *
+ * Owned by SubscriptionRegistry, so that it can outlive the DeviceAgents which have been using
+ * it, and be handed over to the next DeviceAgents of the same devices without reconnecting.
+ */
+class CameraSession
+{
+public:
+    CameraSession(
+        std::string key,
+        std::string host,
+        unsigned short port,
+        std::string subscribePath,
+        std::string basicAuth);
+
+    ~CameraSession();
+
+    const std::string& key() const { return m_key; }
+
+    /** If already started, but not connected, makes a new connection attempt. */
+    void start();
+
+    void stop();
+
+    bool isConnected() const { return m_subscriber.isSubscribed(); }
+
+    /**
+     * Blocks until the connection is established or the timeout expires, woken up by the
+     * Subscriber on its connection state changes.
+     * @param isCancelled Checked on wakeUpConnectWaiters(); if it returns true, the wait ends.
+     * @return Whether connected.
+     */
+    bool waitUntilConnected(int timeoutMs, const std::function<bool()>& isCancelled);
+
+    /** Makes the callers of waitUntilConnected() re-check the connection and their cancellation. */
+    void wakeUpConnectWaiters();
+
+    /**
+     * @param mac If the session has several channels, the handler receives only the messages
+     *     from this MAC address, in any format; the messages without a MAC address, or with the
+     *     one of no channel, are dropped and counted in the "session.unroutedMessages" metric.
+     *     The only channel of the session receives all the messages. If empty, the handler
+     *     receives all the messages.
+     * @return Id of the channel, for removeChannel().
+     */
+    int addChannel(const std::string& mac, Subscriber::PEAResultCallback handler);
+
+    /** After the call returns, the handler of the channel is not called anymore. */
+    void removeChannel(int channelId);
+
+    /** Keeps the track state of the released DeviceAgent for the next one of the same device. */
+    void storeTrackState(const std::string& deviceId, std::unique_ptr<CameraTrackState> trackState);
+
+    /** @return Null if there is no stored state for the device. */
+    std::unique_ptr<CameraTrackState> takeTrackState(const std::string& deviceId);
+
+    /** @return The MAC address with the separators removed and the letters lower-cased. */
+    static std::string normalizeMac(const std::string& mac);
+
+private:
+    void dispatch(const PEAResult& result);
+
+private:
+    struct Channel
+    {
+        std::string mac; /**< Normalized; empty means any. */
+        Subscriber::PEAResultCallback handler;
+    };
+
+    const std::string m_key;
+    const std::string m_host;
+    const unsigned short m_port;
+    const std::string m_subscribePath;
+    const std::string m_basicAuth;
+
+    std::mutex m_mutex;
+    bool m_isStarted = false;
+    std::map<std::string, std::unique_ptr<CameraTrackState>> m_trackStates;
+
+    /** Held while dispatching, so that a removed channel is not called after its removal. */
+    std::mutex m_channelMutex;
+    std::map<int, Channel> m_channels;
+    int m_nextChannelId = 0;
+
+    std::mutex m_connectMutex;
+    std::condition_variable m_connectionStateChanged;
+
+    /** The last member: its callbacks may run until it is destroyed. */
+    Subscriber m_subscriber;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,57 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "clock_sync_estimator.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+ClockSyncEstimator::ClockSyncEstimator(int64_t windowUs, int64_t maxJumpUs):
+    m_windowUs(windowUs),
+    m_maxJumpUs(maxJumpUs)
+{
+}
+
+int64_t ClockSyncEstimator::toServerTimeUs(int64_t cameraTimeUs, int64_t arrivalTimeUs)
+{
+    const int64_t offsetUs = arrivalTimeUs - cameraTimeUs;
+    if (m_count > 0 && offsetUs - this->offsetUs() > m_maxJumpUs)
+        reset();
+
+    addSample(offsetUs, arrivalTimeUs);
+    return cameraTimeUs + this->offsetUs();
+}
+
+void ClockSyncEstimator::addSample(int64_t offsetUs, int64_t arrivalTimeUs)
+{
+    // Drop the samples which have left the window.
+    while (m_count > 0 && m_samples[m_head].arrivalTimeUs < arrivalTimeUs - m_windowUs)
+    {
+        m_head = (m_head + 1) % kMaxSamples;
+        --m_count;
+    }
+
+    // Drop the samples which can never become the minimum: they are older and not smaller.
+    while (m_count > 0)
+    {
+        const int tail = (m_head + m_count - 1) % kMaxSamples;
+        if (m_samples[tail].offsetUs < offsetUs)
+            break;
+        --m_count;
+    }
+
+    if (m_count == kMaxSamples) //< Too many samples in the window - forget the oldest one.
+    {
+        m_head = (m_head + 1) % kMaxSamples;
+        --m_count;
+    }
+
+    m_samples[(m_head + m_count) % kMaxSamples] = Sample{offsetUs, arrivalTimeUs};
+    ++m_count;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,72 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Maps the camera clock to the Server clock, using the moments the camera messages are received.
+ *
+ * The offset between the clocks is estimated as the minimum of (arrival time - camera time) over
+ * a sliding time window: the network and processing delays only increase this difference, so the
+ * minimum is the closest to the true offset, while the window lets the estimate follow the clock
+ * drift. A sudden change of the difference, e.g. when the camera clock is set, restarts the
+ * estimation.
+ *
+ * Not thread-safe - the owner is expected to guard it.
+ */
+class ClockSyncEstimator
+{
+public:
+    /**
+     * @param windowUs The offset is estimated over the samples received during this time.
+     * @param maxJumpUs A difference exceeding the estimated offset by more than this restarts the
+     *     estimation.
+     */
+    ClockSyncEstimator(int64_t windowUs, int64_t maxJumpUs);
+
+    /**
+     * Adds the sample, and maps the camera time to the Server time.
+     * @param arrivalTimeUs Server time when the message with the given camera time has arrived.
+     */
+    int64_t toServerTimeUs(int64_t cameraTimeUs, int64_t arrivalTimeUs);
+
+    /** Valid only after at least one sample. */
+    int64_t offsetUs() const { return m_samples[m_head].offsetUs; }
+
+    void reset() { m_count = 0; }
+
+private:
+    void addSample(int64_t offsetUs, int64_t arrivalTimeUs);
+
+private:
+    struct Sample
+    {
+        int64_t offsetUs = 0;
+        int64_t arrivalTimeUs = 0;
+    };
+
+    static constexpr int kMaxSamples = 128;
+
+    int64_t m_windowUs = 0;
+    int64_t m_maxJumpUs = 0;
+
+    /**
+     * Monotonic queue: the offsets increase from the head to the tail, so the head is the minimum
+     * over the window. Fixed ring buffer, so that adding samples does no allocations.
+     */
+    std::array<Sample, kMaxSamples> m_samples{};
+    int m_head = 0;
+    int m_count = 0;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
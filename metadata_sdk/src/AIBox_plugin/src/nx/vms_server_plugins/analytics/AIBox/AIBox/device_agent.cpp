@@ -12,10 +12,14 @@
 #include <iomanip>
 #include <nx/sdk/analytics/helpers/object_metadata.h>
 #include <nx/sdk/analytics/helpers/object_metadata_packet.h>
+#include <nx/sdk/helpers/settings_response.h>
+#include <nx/sdk/helpers/string_map.h>
 #include <nx/kit/debug.h>
 
+#include "allocation_tracker.h"
 #include "device_agent_manifest.h"
 #include "ini.h"
+#include "metrics.h"
 
 #include "../net/subscriber.h"
 #include "../net/net_utils.h"
@@ -32,9 +36,13 @@ using Uuid = nx::sdk::Uuid;
 static constexpr float kVideoWidth = 10000.0f;
 static constexpr float kVideoHeight = 10000.0f;
 static constexpr int kPort = 8080;
-const std::string DeviceAgent::kTimeShiftSetting = "timestampShiftMs";
-const std::string DeviceAgent::kSendAttributesSetting = "sendAttributes";
-const std::string DeviceAgent::kObjectTypeGenerationSettingPrefix = "objectTypeIdToGenerate.";
+static constexpr int64_t kMaxCameraClockJumpUs = 10'000'000;
+
+/** Above the subscription starts sharing the timer queue: a flush is short and never blocks. */
+static constexpr int kMetadataFlushPriority = 2;
+
+/** Distinguishes the metrics of the DeviceAgents of the same device, see m_metricsPrefix. */
+static std::atomic<int> nextDeviceAgentIndex{0};
 
 static void parseHostPortFromUrl(const std::string& url, std::string& hostOut)
 {
@@ -82,6 +90,7 @@ static std::string formatTimestampUs(long long us)
 
 static nx::sdk::Uuid makeTrackUuid(const std::string& mac, int targetId)
 {
+    const AllocationScope allocationScope("uuid");
     std::string macNoColons;
     macNoColons.reserve(mac.size());
     for (char ch: mac)
@@ -116,6 +125,38 @@ static nx::sdk::Uuid makeTrackUuid(const std::string& mac, int targetId)
     return nx::sdk::UuidHelper::fromStdString(uuidStr);
 }
 
+/**
+ * The Server usually uses the MAC address as the shared id of the channels of a multi-channel
+ * device, possibly with a suffix.
+ * @return Empty string if the shared id does not start with a MAC address.
+ */
+static std::string macFromSharedId(const std::string& sharedId)
+{
+    std::string mac;
+    size_t i = 0;
+    for (; i < sharedId.size() && mac.size() < 12; ++i)
+    {
+        const auto ch = static_cast<unsigned char>(sharedId[i]);
+        if (std::isxdigit(ch))
+        {
+            mac.push_back(static_cast<char>(std::tolower(ch)));
+        }
+        else if (ch != ':' && ch != '-')
+        {
+            return std::string();
+        }
+    }
+
+    // Reject longer hex ids, e.g. UUIDs.
+    if (mac.size() < 12 || (i < sharedId.size()
+        && (std::isxdigit(static_cast<unsigned char>(sharedId[i]))
+            || sharedId[i] == ':' || sharedId[i] == '-')))
+    {
+        return std::string();
+    }
+    return mac;
+}
+
 static Rect genBox(const TrajectoryResult& traject)
 {
     nx::sdk::analytics::Rect boundingBox;
@@ -126,22 +167,88 @@ static Rect genBox(const TrajectoryResult& traject)
     return boundingBox;
 }
 
-DeviceAgent::DeviceAgent(const nx::sdk::IDeviceInfo* deviceInfo):
-    ConsumingDeviceAgent(deviceInfo, ini().enableOutput)
+static int64_t steadyClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t systemClockUs()
 {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+DeviceAgent::DeviceAgent(
+    const nx::sdk::IDeviceInfo* deviceInfo,
+    std::shared_ptr<SubscriptionRegistry> subscriptionRegistry)
+    :
+    ConsumingDeviceAgent(deviceInfo, ini().enableOutput),
+    m_clockSyncEstimator(ini().clockSyncWindowMs * 1000LL, kMaxCameraClockJumpUs),
+    m_subscriptionRegistry(std::move(subscriptionRegistry))
+{
+    if (ini().asyncMetadataDispatch)
+    {
+        enableAsyncMetadataDispatch();
+    }
+
     m_login = deviceInfo->login();
     m_password = deviceInfo->password();
     m_basicAuth = base64Encode(m_login + ":" + m_password);
     m_deviceUrl = nx::kit::utils::toString(deviceInfo->url());
+    m_deviceId = deviceInfo->id();
+    m_deviceMac = macFromSharedId(deviceInfo->sharedId());
 
     NX_PRINT << "DeviceAgent created for device: " << deviceInfo->vendor() << " " << deviceInfo->model();
 
-    startSubscription();
+    m_metricsPrefix = std::string("device.") + deviceInfo->id() + "#"
+        + std::to_string(nextDeviceAgentIndex.fetch_add(1, std::memory_order_relaxed)) + ".";
+    m_subscriptionStateMetric = &Metrics::instance().value(m_metricsPrefix + "subscriptionState");
+    m_latencyTracker = std::make_unique<MessageLatencyTracker>(
+        m_deviceId,
+        m_metricsPrefix,
+        ini().maxCameraClockOffsetMs * 1000LL,
+        ini().maxCameraNetworkDelayMs * 1000LL);
+    m_messageHealth = std::make_unique<StreamHealthTracker>(m_metricsPrefix + "messages.");
+    m_videoHealth = std::make_unique<StreamHealthTracker>(m_metricsPrefix + "video.");
+
+    // The camera is subscribed to only when the Server needs some of the enabled object types;
+    // see updateSubscriptionDemand().
+    m_subscriptionController = std::make_unique<SubscriptionController>(
+        &m_subscriptionRegistry->timerQueue(),
+        [this]() { return startSubscription(); },
+        [this]() { stopSubscription(); },
+        ini().subscriptionGracePeriodMs,
+        ini().subscriptionRetryMinDelayMs,
+        ini().subscriptionRetryMaxDelayMs);
+    m_subscriptionController->setStateChangedHandler(
+        [this](SubscriptionController::State state)
+        {
+            NX_OUTPUT << "Subscription state: " << (int) state;
+            m_subscriptionStateMetric->store((int64_t) state, std::memory_order_relaxed);
+        });
+
+    if (ini().metadataOnlyMode && ini().metadataOnlyFlushIntervalMs > 0)
+    {
+        scheduleMetadataFlush();
+    }
 }
 
 DeviceAgent::~DeviceAgent()
 {
-    stopSubscription();
+    m_subscriptionRegistry->timerQueue().cancel(this);
+
+    // The subscription may be still waiting for its turn to connect.
+    m_isDestroying = true;
+    m_subscriptionRegistry->wakeUpPendingAcquisitions();
+
+    // Stops the subscription if it is active.
+    m_subscriptionController.reset();
+
+    // Their Metrics publishers must not outlive the metrics.
+    m_messageHealth.reset();
+    m_videoHealth.reset();
+    Metrics::instance().removeAll(m_metricsPrefix);
 }
 
 std::string DeviceAgent::manifestString() const
@@ -151,139 +258,355 @@ std::string DeviceAgent::manifestString() const
 
 bool DeviceAgent::pushCompressedVideoFrame(const ICompressedVideoPacket* videoFrame)
 {
-    {
-        std::lock_guard<std::mutex> lock(m_frameTimeMutex);
-        m_lastVideoFrameTimestampUs = videoFrame->timestampUs();
-    }    
+    m_lastVideoFrameTimestampUs.store(videoFrame->timestampUs(), std::memory_order_relaxed);
+    m_videoHealth->onData(
+        videoFrame->timestampUs(),
+        (size_t) videoFrame->dataSize(),
+        ((uint32_t) videoFrame->flags()
+            & (uint32_t) ICompressedMediaPacket::MediaFlags::keyFrame) != 0);
     return true;
 }
 
-void DeviceAgent::doSetNeededMetadataTypes(
-    nx::sdk::Result<void>* /*outValue*/,
-    const nx::sdk::analytics::IMetadataTypes* /*neededMetadataTypes*/)
+bool DeviceAgent::pullMetadataPackets(std::vector<IMetadataPacket*>* metadataPackets)
 {
-}
+    const int64_t frameTimestampUs =
+        m_lastVideoFrameTimestampUs.load(std::memory_order_relaxed);
+    if (frameTimestampUs <= 0)
+    {
+        return true;
+    }
+    const auto settings = this->settings();
+    const int64_t timestampUs =
+        frameTimestampUs + (static_cast<int64_t>(settings.value(Setting::timestampShiftMs)) * 1000LL);
 
-nx::sdk::Result<const nx::sdk::ISettingsResponse*> DeviceAgent::settingsReceived()
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    const std::map<std::string, std::string>& settings = currentSettings();
-    m_objectTypeIdsToGenerate.clear();
-    for (const auto& entry: settings)
+    Ptr<IMetadataPacket> metadataPacket;
     {
-        const std::string& key = entry.first;
-        std::string value = entry.second;
-        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-        if ((0 == key.rfind(kObjectTypeGenerationSettingPrefix, 0)) && (value == "true" || value == "1"))
+        std::lock_guard<nx::kit::Mutex> lock(m_trackMutex);
+        m_trackTable.expire(timestampUs, ini().trackTimeoutMs * 1000LL);
+        if (settings.isEnabled(Setting::interpolateBoxes))
         {
-            m_objectTypeIdsToGenerate.insert(key.substr(kObjectTypeGenerationSettingPrefix.size()));
+            if (m_trackTable.size() > 0 && m_rateGovernor.tryAcquire(steadyClockUs()))
+            {
+                metadataPacket = generateInterpolatedPacket(timestampUs);
+            }
         }
-        else if (key == kTimeShiftSetting)
+        else if (isPacketDue(timestampUs) && m_rateGovernor.tryAcquire(steadyClockUs()))
         {
-            m_timestampShiftMs = std::stoi(value);
+            // Flush the updates held back by the rate governor, or send the full refresh.
+            metadataPacket = generatePendingPacket(timestampUs);
         }
     }
-    return nullptr;
+
+    if (metadataPacket)
+    {
+        metadataPackets->push_back(metadataPacket.releasePtr());
+    }
+    return true;
 }
 
-void DeviceAgent::startSubscription()
+void DeviceAgent::doSetNeededMetadataTypes(
+    nx::sdk::Result<void>* /*outValue*/,
+    const nx::sdk::analytics::IMetadataTypes* neededMetadataTypes)
 {
-    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
-    if (!m_subscriptionStarted)
+    uint32_t neededObjectClasses = 0;
+    if (neededMetadataTypes && !neededMetadataTypes->isEmpty())
     {
-        m_subscriber.registerPEAResultCallback([this](const PEAResult& result)
+        if (const auto objectTypeIds = neededMetadataTypes->objectTypeIds())
         {
-            this->onPEAResultReceived(result);
-        });
-
-        std::string host;
-        parseHostPortFromUrl(m_deviceUrl, host);
-        NX_PRINT << "IPC Subscription starting...";
-        m_subscriber.startIpcSubscription(host, kPort, "/SetSubscribe", m_basicAuth);
-        m_subscriptionStarted = true;
+            for (int i = 0; i < objectTypeIds->count(); ++i)
+            {
+                const ObjectClass objectClass = objectClassFromTypeId(objectTypeIds->at(i));
+                if (objectClass != ObjectClass::count)
+                {
+                    neededObjectClasses |= 1u << (int) objectClass;
+                }
+            }
+        }
     }
+    m_neededObjectClasses.store(neededObjectClasses, std::memory_order_relaxed);
+    updateSubscriptionDemand();
 }
 
-void DeviceAgent::stopSubscription()
+void DeviceAgent::updateSubscriptionDemand()
 {
-    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
-    if (m_subscriptionStarted)
+    const uint32_t demandedObjectClasses =
+        m_neededObjectClasses.load(std::memory_order_relaxed)
+        & settings().generatedObjectClasses;
+    m_subscriptionController->setPriority(subscriptionPriority());
+    m_subscriptionController->setNeeded(demandedObjectClasses != 0);
+}
+
+int DeviceAgent::subscriptionPriority() const
+{
+    return settings().isEnabled(Setting::connectFirst) ? 1 : 0;
+}
+
+nx::sdk::Result<const nx::sdk::ISettingsResponse*> DeviceAgent::settingsReceived()
+{
+    std::map<std::string, std::string> errors;
+    const DeviceAgentSettings newSettings =
+        DeviceAgentSettings::parse(currentSettings(), &errors);
+    {
+        std::lock_guard<nx::kit::Mutex> lock(m_trackMutex);
+        m_rateGovernor.setMaxPacketsPerSecond(newSettings.value(Setting::maxPacketsPerSecond));
+        m_changeDetector.setMinBoxChange(
+            static_cast<float>(newSettings.value(Setting::minBoxChange)) / kVideoWidth);
+        m_changeDetector.setKeepAliveIntervalUs(ini().trackKeepAliveMs * 1000LL);
+        m_changeDetector.setFullRefreshIntervalUs(ini().fullRefreshIntervalMs * 1000LL);
+    }
+    m_settings.publish(newSettings);
+    updateSubscriptionDemand();
+
+    if (errors.empty())
+    {
+        return nullptr;
+    }
+    for (const auto& error: errors)
     {
-        m_subscriber.stopIpcSubscription();
-        m_subscriptionStarted = false;
-        NX_PRINT << "IPC Subscription stopped.";
+        NX_PRINT << "Invalid setting " << error.first << " of device " << m_deviceId << ": "
+            << error.second;
     }
+    auto response = makePtr<SettingsResponse>();
+    response->setErrors(makePtr<StringMap>(std::move(errors)));
+    return response.releasePtr();
 }
 
-void DeviceAgent::onPEAResultReceived(const PEAResult& result)
+bool DeviceAgent::startSubscription()
 {
-    int64_t frameTimestampUs = 0;
-    int64_t timestampShiftMs = 0;
+    std::lock_guard<nx::kit::Mutex> lock(m_subscriptionMutex);
+    const int priority = subscriptionPriority();
+    const auto isCancelled = [this]() { return m_isDestroying.load(); };
+    if (m_session)
     {
-        std::lock_guard<std::mutex> lock(m_frameTimeMutex);
-        frameTimestampUs = m_lastVideoFrameTimestampUs;
+        return countStart(m_subscriptionRegistry->reconnect(m_session, priority, isCancelled));
     }
+
+    std::string host;
+    parseHostPortFromUrl(m_deviceUrl, host);
+    m_session = m_subscriptionRegistry->acquire(
+        host, kPort, "/SetSubscribe", m_basicAuth, priority, isCancelled);
+    if (!m_session)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        timestampShiftMs = m_timestampShiftMs;
+        return countStart(false);
     }
 
-    if (frameTimestampUs <= 0)
+    // The session may come from the previous DeviceAgent of this camera, with its tracks.
+    if (std::unique_ptr<CameraTrackState> trackState = m_session->takeTrackState(m_deviceId))
+    {
+        std::lock_guard<nx::kit::Mutex> trackLock(m_trackMutex);
+        m_trackTable = std::move(trackState->trackTable);
+        m_duplicateMessageFilter = trackState->duplicateMessageFilter;
+        m_clockSyncEstimator = trackState->clockSyncEstimator;
+    }
+
+    m_sessionChannelId = m_session->addChannel(
+        m_deviceMac,
+        [this](const PEAResult& result)
+        {
+            this->onPEAResultReceived(result);
+        });
+    return countStart(m_session->isConnected());
+}
+
+void DeviceAgent::stopSubscription()
+{
+    std::lock_guard<nx::kit::Mutex> lock(m_subscriptionMutex);
+    if (!m_session)
     {
         return;
     }
-    
-    auto metadataPacket = makePtr<nx::sdk::analytics::ObjectMetadataPacket>();
-    
-    // currentTime
-    metadataPacket->setTimestampUs(frameTimestampUs + (static_cast<int64_t>(timestampShiftMs) * 1000LL));
 
-    // Mac
-    std::string macTail = result.deviceMac;
+    // No callbacks come after this call, so the track state can be handed over.
+    m_session->removeChannel(m_sessionChannelId);
 
-    // trajects
-    for (const auto& traject: result.trajects)
+    auto trackState = std::make_unique<CameraTrackState>();
     {
-        std::string objectTypeId;
-        if (traject.targetType == kStringPerson)
-        {
-            objectTypeId = kStringHuman;
-        }
-        else if (traject.targetType == kStringCar)
+        std::lock_guard<nx::kit::Mutex> trackLock(m_trackMutex);
+        trackState->trackTable = std::move(m_trackTable);
+        trackState->duplicateMessageFilter = m_duplicateMessageFilter;
+        trackState->clockSyncEstimator = m_clockSyncEstimator;
+        m_trackTable = TrackTable();
+        m_duplicateMessageFilter.clear();
+        m_clockSyncEstimator.reset();
+    }
+    m_session->storeTrackState(m_deviceId, std::move(trackState));
+    m_subscriptionRegistry->release(std::move(m_session));
+    Metrics::instance().value("subscription.stops").fetch_add(1);
+}
+
+bool DeviceAgent::countStart(bool isSuccessful)
+{
+    Metrics::instance().value(isSuccessful ? "subscription.starts" : "subscription.startFailures")
+        .fetch_add(1);
+    return isSuccessful;
+}
+
+void DeviceAgent::onPEAResultReceived(const PEAResult& result)
+{
+    m_messageHealth->onData(
+        result.timing.receivedUs > 0 ? result.timing.receivedUs : steadyClockUs(),
+        result.bodySize,
+        /*isKeyFrame*/ false);
+
+    int64_t frameTimestampUs = 0;
+    if (!ini().metadataOnlyMode)
+    {
+        frameTimestampUs = m_lastVideoFrameTimestampUs.load(std::memory_order_relaxed);
+        if (frameTimestampUs <= 0)
         {
-            objectTypeId = kStringMotorVehicle;
+            return;
         }
-        else if (traject.targetType == kStringMotor)
+    }
+    const auto settings = this->settings();
+    const uint32_t neededObjectClasses = m_neededObjectClasses.load(std::memory_order_relaxed);
+
+    Ptr<IMetadataPacket> metadataPacket;
+    const int64_t cameraTimeUs =
+        result.currentTime > 0 ? result.currentTime * ini().cameraTimeUnitUs : 0;
+    int64_t clockOffsetUs = 0;
+    int64_t builtUs = 0;
+    {
+        NX_PROFILE_ZONE("filter");
+        const AllocationScope allocationScope("filter");
+        std::lock_guard<nx::kit::Mutex> trackLock(m_trackMutex);
+        if (m_duplicateMessageFilter.isDuplicate(result))
         {
-            objectTypeId = kStringMotorcycleBicycle;
+            NX_OUTPUT << "Dropped a re-sent PEA message, camera time " << result.currentTime;
+            return;
         }
-        else
+
+        // currentTime; the clock offset is estimated in any mode, for the latency accounting.
+        const int64_t cameraServerTimeUs = serverTimeUsFromCameraTime(result);
+        if (cameraTimeUs > 0)
         {
-            objectTypeId = kStringUnknown;
+            clockOffsetUs = m_clockSyncEstimator.offsetUs();
         }
+        const int64_t timestampUs =
+            (ini().metadataOnlyMode ? cameraServerTimeUs : frameTimestampUs)
+            + (static_cast<int64_t>(settings.value(Setting::timestampShiftMs)) * 1000LL);
+
+        m_trackTable.expire(timestampUs, ini().trackTimeoutMs * 1000LL);
+
+        // trajects
+        for (const auto& traject: result.trajects)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            if (m_objectTypeIdsToGenerate.find(objectTypeId) == m_objectTypeIdsToGenerate.end())
+            const ObjectClass objectClass = objectClassFromTargetType(traject.targetType);
+            if (!settings.isGenerated(objectClass)
+                || (neededObjectClasses & (1u << (int) objectClass)) == 0)
             {
                 continue;
             }
+
+            // The track uuid is built only once, when the camera reports a new target.
+            const TrackTable::Track* knownTrack = m_trackTable.find(traject.targetId);
+            const nx::sdk::Uuid trackId = knownTrack
+                ? knownTrack->trackId
+                : makeTrackUuid(result.deviceMac, traject.targetId);
+            m_trackTable.update(
+                traject.targetId,
+                &objectTypeIdOf(objectClass),
+                trackId,
+                timestampUs,
+                genBox(traject));
         }
-        
-        auto objectMetadata = makePtr<nx::sdk::analytics::ObjectMetadata>();
 
-        // targetType
-        objectMetadata->setTypeId(objectTypeId);
+        // If the rate governor holds the packet back, the updates stay pending in the track
+        // table, merged per track, and go with the next allowed packet.
+        if (isPacketDue(timestampUs) && m_rateGovernor.tryAcquire(steadyClockUs()))
+        {
+            metadataPacket = generatePendingPacket(timestampUs);
+            builtUs = steadyClockUs();
+        }
+    }
 
-        nx::sdk::Uuid trackId = makeTrackUuid(result.deviceMac, traject.targetId);
-        objectMetadata->setTrackId(trackId);
+    int64_t pushedUs = 0;
+    if (metadataPacket)
+    {
+        NX_PROFILE_ZONE("push");
+        const AllocationScope allocationScope("push");
+        pushMetadataPacket(metadataPacket.releasePtr());
+        pushedUs = steadyClockUs();
+    }
+    m_latencyTracker->record(result.timing, cameraTimeUs, clockOffsetUs, builtUs, pushedUs);
+}
 
-        // rect
-        objectMetadata->setBoundingBox(genBox(traject));
+void DeviceAgent::scheduleMetadataFlush()
+{
+    m_subscriptionRegistry->timerQueue().post(
+        this,
+        std::chrono::milliseconds(ini().metadataOnlyFlushIntervalMs),
+        kMetadataFlushPriority,
+        [this]() { flushPendingMetadata(); });
+}
+
+void DeviceAgent::flushPendingMetadata()
+{
+    // The tracks are timestamped by the camera clock mapped to the Server clock, which is the
+    // system one.
+    const int64_t timestampUs = systemClockUs()
+        + (static_cast<int64_t>(settings().value(Setting::timestampShiftMs)) * 1000LL);
 
-        metadataPacket->addItem(objectMetadata.get());
+    Ptr<IMetadataPacket> metadataPacket;
+    {
+        std::lock_guard<nx::kit::Mutex> lock(m_trackMutex);
+        m_trackTable.expire(timestampUs, ini().trackTimeoutMs * 1000LL);
+        if (isPacketDue(timestampUs) && m_rateGovernor.tryAcquire(steadyClockUs()))
+        {
+            metadataPacket = generatePendingPacket(timestampUs);
+        }
+    }
+
+    if (metadataPacket)
+    {
+        pushMetadataPacket(metadataPacket.releasePtr());
     }
+    scheduleMetadataFlush();
+}
 
-    pushMetadataPacket(metadataPacket.releasePtr());
+int64_t DeviceAgent::serverTimeUsFromCameraTime(const PEAResult& result)
+{
+    const int64_t arrivalTimeUs = result.timing.receivedSystemUs > 0
+        ? result.timing.receivedSystemUs
+        : systemClockUs();
+    if (result.currentTime <= 0)
+    {
+        return arrivalTimeUs;
+    }
+    return m_clockSyncEstimator.toServerTimeUs(
+        result.currentTime * ini().cameraTimeUnitUs, arrivalTimeUs);
+}
+
+bool DeviceAgent::isPacketDue(int64_t timestampUs) const
+{
+    return m_trackTable.hasPendingTracks()
+        || (m_trackTable.size() > 0 && m_changeDetector.isFullRefreshDue(timestampUs));
+}
+
+int64_t DeviceAgent::packetDurationUs() const
+{
+    // The boxes of the suppressed tracks must stay on the screen until their keep-alive.
+    const int64_t durationUs = m_rateGovernor.packetDurationUs();
+    if (m_changeDetector.isEnabled())
+    {
+        return std::max(durationUs, m_changeDetector.keepAliveIntervalUs());
+    }
+    return durationUs;
+}
+
+Ptr<IMetadataPacket> DeviceAgent::generatePendingPacket(int64_t timestampUs)
+{
+    return m_packetBuilder.buildPendingPacket(
+        &m_trackTable, &m_changeDetector, timestampUs, packetDurationUs());
+}
+
+Ptr<IMetadataPacket> DeviceAgent::generateInterpolatedPacket(int64_t timestampUs)
+{
+    return m_packetBuilder.buildInterpolatedPacket(
+        &m_trackTable,
+        &m_changeDetector,
+        timestampUs,
+        packetDurationUs(),
+        ini().maxBoxExtrapolationMs * 1000LL);
 }
 
 } // namespace AIBox
@@ -2,18 +2,31 @@
 
 #pragma once
 
-#include <set>
+#include <atomic>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <mutex>
+#include <nx/kit/mutex.h>
 #include <nx/sdk/analytics/helpers/object_metadata.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
 
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
 #include <nx/sdk/helpers/uuid_helper.h>
 
+#include "clock_sync_estimator.h"
+#include "device_agent_settings.h"
+#include "duplicate_message_filter.h"
 #include "engine.h"
+#include "message_latency_tracker.h"
+#include "metadata_packet_builder.h"
+#include "metadata_rate_governor.h"
+#include "stream_health_tracker.h"
+#include "subscription_controller.h"
+#include "subscription_registry.h"
+#include "track_change_detector.h"
+#include "track_table.h"
 #include "../net/net_utils.h"
-#include "../net/subscriber.h"
 
 namespace nx {
 namespace vms_server_plugins {
@@ -23,12 +36,9 @@ namespace AIBox {
 class DeviceAgent: public nx::sdk::analytics::ConsumingDeviceAgent
 {
 public:
-    static const std::string kTimeShiftSetting;
-    static const std::string kSendAttributesSetting;
-    static const std::string kObjectTypeGenerationSettingPrefix;
-
-public:
-    DeviceAgent(const nx::sdk::IDeviceInfo* deviceInfo);
+    DeviceAgent(
+        const nx::sdk::IDeviceInfo* deviceInfo,
+        std::shared_ptr<SubscriptionRegistry> subscriptionRegistry);
     virtual ~DeviceAgent() override;
 
 protected:
@@ -37,6 +47,9 @@ protected:
     virtual bool pushCompressedVideoFrame(
         const nx::sdk::analytics::ICompressedVideoPacket* videoFrame) override;
 
+    virtual bool pullMetadataPackets(
+        std::vector<nx::sdk::analytics::IMetadataPacket*>* metadataPackets) override;
+
     virtual void doSetNeededMetadataTypes(
         nx::sdk::Result<void>* outValue,
         const nx::sdk::analytics::IMetadataTypes* neededMetadataTypes) override;
@@ -51,28 +64,102 @@ private:
 
     void onPEAResultReceived(const PEAResult& result);
 
-    void startSubscription();
+    /** Requires m_trackMutex to be locked. */
+    int64_t serverTimeUsFromCameraTime(const PEAResult& result);
+
+    /** Lock-free copy of the current settings; see PublishedDeviceAgentSettings. */
+    DeviceAgentSettings settings() const { return m_settings.load(); }
+
+    /**
+     * In metadataOnlyMode, no video frames pull the metadata: sends the pending packet from the
+     * timer instead, and re-schedules itself.
+     */
+    void flushPendingMetadata();
+
+    void scheduleMetadataFlush();
+
+    /** Requires m_trackMutex to be locked. */
+    bool isPacketDue(int64_t timestampUs) const;
+
+    /** Requires m_trackMutex to be locked. */
+    int64_t packetDurationUs() const;
+
+    /** Requires m_trackMutex to be locked. */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> generatePendingPacket(int64_t timestampUs);
+
+    /** Requires m_trackMutex to be locked. */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> generateInterpolatedPacket(
+        int64_t timestampUs);
+
+    /**
+     * Keeps the acquired session even if it has failed to connect; the next call retries the
+     * connection.
+     * @return Whether the session is connected.
+     */
+    bool startSubscription();
 
     void stopSubscription();
 
+    /** @return The given result of a subscription start, after counting it in the metrics. */
+    static bool countStart(bool isSuccessful);
+
+    /** Subscribes to the camera only if some of the enabled object types are needed. */
+    void updateSubscriptionDemand();
+
+    /** Of the subscription starts, both waiting for a thread and for the admission. */
+    int subscriptionPriority() const;
+
 private:
-    mutable std::mutex m_mutex;
-    mutable std::mutex m_frameTimeMutex;
-    mutable std::mutex m_subscriptionMutex;
+    mutable nx::kit::Mutex m_subscriptionMutex{"AIBox::DeviceAgent::m_subscriptionMutex"};
+    mutable nx::kit::Mutex m_trackMutex{"AIBox::DeviceAgent::m_trackMutex"};
 
     int m_frameIndex = 0;
-    int m_timestampShiftMs = 0;
-    bool m_subscriptionStarted = false;
-    int64_t m_lastVideoFrameTimestampUs = 0;
-    
+    std::atomic<int64_t> m_lastVideoFrameTimestampUs{0};
+
+    /** Published by settingsReceived(), which the Server calls by one thread at a time. */
+    PublishedDeviceAgentSettings m_settings;
+
+    /** Bit mask of ObjectClass values needed by the Server. */
+    std::atomic<uint32_t> m_neededObjectClasses{0};
+
     std::vector<nx::sdk::Uuid> m_trackIds;
-    std::set<std::string> m_objectTypeIdsToGenerate;
+    TrackTable m_trackTable;
+
+    MetadataPacketBuilder m_packetBuilder;
+
+    MetadataRateGovernor m_rateGovernor;
+    ClockSyncEstimator m_clockSyncEstimator;
+    TrackChangeDetector m_changeDetector;
+    DuplicateMessageFilter m_duplicateMessageFilter;
     std::string m_login;
     std::string m_password;
     std::string m_basicAuth;
     std::string m_deviceUrl;
-
-    Subscriber m_subscriber;  
+    std::string m_deviceId;
+
+    /** Normalized; empty if unknown, then all the messages of the endpoint are accepted. */
+    std::string m_deviceMac;
+
+    const std::shared_ptr<SubscriptionRegistry> m_subscriptionRegistry;
+    std::shared_ptr<CameraSession> m_session;
+    int m_sessionChannelId = -1;
+    /**
+     * "device.<deviceId>#<agentIndex>.": the Server may create the next DeviceAgent of the device
+     * before destroying the previous one, which then removes only its own metrics.
+     */
+    std::string m_metricsPrefix;
+    std::atomic<int64_t>* m_subscriptionStateMetric = nullptr;
+    std::unique_ptr<SubscriptionController> m_subscriptionController;
+
+    /** Used by the thread of the session delivering the messages. */
+    std::unique_ptr<MessageLatencyTracker> m_latencyTracker;
+    std::unique_ptr<StreamHealthTracker> m_messageHealth;
+
+    /** Used by the Server thread pushing the video frames. */
+    std::unique_ptr<StreamHealthTracker> m_videoHealth;
+
+    /** Cancels the subscription start waiting in the startup queue. */
+    std::atomic<bool> m_isDestroying{false};
 };
 
 } // namespace AIBox
@@ -0,0 +1,225 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "device_agent_settings.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "device_agent_manifest.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+ObjectClass objectClassFromTargetType(const std::string& targetType)
+{
+    if (targetType == kStringPerson)
+    {
+        return ObjectClass::human;
+    }
+    if (targetType == kStringCar)
+    {
+        return ObjectClass::motorVehicle;
+    }
+    if (targetType == kStringMotor)
+    {
+        return ObjectClass::motorcycleBicycle;
+    }
+    return ObjectClass::unknown;
+}
+
+ObjectClass objectClassFromTypeId(const std::string& objectTypeId)
+{
+    for (int i = 0; i < (int) ObjectClass::count; ++i)
+    {
+        if (objectTypeIdOf((ObjectClass) i) == objectTypeId)
+        {
+            return (ObjectClass) i;
+        }
+    }
+    return ObjectClass::count;
+}
+
+const std::string& objectTypeIdOf(ObjectClass objectClass)
+{
+    switch (objectClass)
+    {
+        case ObjectClass::human:
+            return kStringHuman;
+        case ObjectClass::motorVehicle:
+            return kStringMotorVehicle;
+        case ObjectClass::motorcycleBicycle:
+            return kStringMotorcycleBicycle;
+        default:
+            return kStringUnknown;
+    }
+}
+
+bool isGeneratedByDefault(ObjectClass objectClass)
+{
+    return objectClass == ObjectClass::human
+        || objectClass == ObjectClass::motorVehicle
+        || objectClass == ObjectClass::motorcycleBicycle;
+}
+
+static bool equalsIgnoringCase(const std::string& text, const char* lowercaseText)
+{
+    const size_t size = std::char_traits<char>::length(lowercaseText);
+    if (text.size() != size)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < size; ++i)
+    {
+        const char c = text[i];
+        if (((c >= 'A' && c <= 'Z') ? (char) (c - 'A' + 'a') : c) != lowercaseText[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @return False if the text is not a boolean, which is "true", "false", "1" or "0". */
+static bool parseBool(const std::string& text, int* value)
+{
+    if (equalsIgnoringCase(text, "true") || text == "1")
+    {
+        *value = 1;
+        return true;
+    }
+    if (equalsIgnoringCase(text, "false") || text == "0")
+    {
+        *value = 0;
+        return true;
+    }
+    return false;
+}
+
+/** @return False if the text is not a decimal int, possibly surrounded by spaces. */
+static bool parseInt(const std::string& text, int* value)
+{
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+    while (begin != end && *begin == ' ')
+    {
+        ++begin;
+    }
+    while (end != begin && end[-1] == ' ')
+    {
+        --end;
+    }
+    const std::from_chars_result result = std::from_chars(begin, end, *value);
+    return begin != end && result.ec == std::errc() && result.ptr == end;
+}
+
+DeviceAgentSettings::DeviceAgentSettings()
+{
+    for (const SettingDescriptor& descriptor: kSettingDescriptors)
+    {
+        values[(size_t) descriptor.setting] = descriptor.defaultValue;
+    }
+}
+
+DeviceAgentSettings DeviceAgentSettings::parse(
+    const std::map<std::string, std::string>& settings,
+    std::map<std::string, std::string>* errors)
+{
+    DeviceAgentSettings result;
+
+    for (const SettingDescriptor& descriptor: kSettingDescriptors)
+    {
+        const auto it = settings.find(descriptor.name);
+        if (it == settings.end())
+        {
+            continue;
+        }
+
+        int value = 0;
+        if (descriptor.type == SettingDescriptor::Type::checkBox)
+        {
+            if (!parseBool(it->second, &value))
+            {
+                (*errors)[descriptor.name] = "Expected true or false, got \"" + it->second + "\"";
+                continue;
+            }
+        }
+        else
+        {
+            if (!parseInt(it->second, &value))
+            {
+                (*errors)[descriptor.name] = "Expected an integer, got \"" + it->second + "\"";
+                continue;
+            }
+            if (descriptor.hasRange
+                && (value < descriptor.minValue || value > descriptor.maxValue))
+            {
+                (*errors)[descriptor.name] = "Expected a value from "
+                    + std::to_string(descriptor.minValue) + " to "
+                    + std::to_string(descriptor.maxValue) + ", got " + it->second;
+                value = std::clamp(value, descriptor.minValue, descriptor.maxValue);
+            }
+        }
+        result.values[(size_t) descriptor.setting] = value;
+    }
+
+    for (int i = 0; i < (int) ObjectClass::count; ++i)
+    {
+        const auto it = settings.find(
+            kObjectTypeGenerationSettingPrefix + objectTypeIdOf((ObjectClass) i));
+        int isGenerated = 0;
+        if (it != settings.end() && parseBool(it->second, &isGenerated) && isGenerated)
+        {
+            result.setGenerated((ObjectClass) i);
+        }
+    }
+
+    return result;
+}
+
+void PublishedDeviceAgentSettings::publish(const DeviceAgentSettings& settings)
+{
+    const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_generatedObjectClasses.store(settings.generatedObjectClasses, std::memory_order_relaxed);
+    for (int i = 0; i < (int) Setting::count; ++i)
+    {
+        m_values[i].store(settings.values[i], std::memory_order_relaxed);
+    }
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+DeviceAgentSettings PublishedDeviceAgentSettings::load() const
+{
+    DeviceAgentSettings settings;
+    for (;;)
+    {
+        const uint64_t sequence = m_sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0)
+        {
+            continue; //< The publisher is in the middle of an update, which is a few stores.
+        }
+
+        settings.generatedObjectClasses =
+            m_generatedObjectClasses.load(std::memory_order_relaxed);
+        for (int i = 0; i < (int) Setting::count; ++i)
+        {
+            settings.values[i] = m_values[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return settings;
+        }
+    }
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
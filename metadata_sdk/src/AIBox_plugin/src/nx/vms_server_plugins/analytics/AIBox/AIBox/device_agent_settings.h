@@ -0,0 +1,191 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/** Classes of the objects the camera detects, used as bit indices in the settings snapshot. */
+enum class ObjectClass: int
+{
+    human,
+    motorVehicle,
+    motorcycleBicycle,
+    unknown,
+    count
+};
+
+ObjectClass objectClassFromTargetType(const std::string& targetType);
+
+/** @return ObjectClass::count if the object type id is not produced by the plugin. */
+ObjectClass objectClassFromTypeId(const std::string& objectTypeId);
+
+/** @return Reference to one of the static object type id constants. */
+const std::string& objectTypeIdOf(ObjectClass objectClass);
+
+/** Prefix of the names of the per-object-type generation checkboxes; the object type id follows. */
+static const std::string kObjectTypeGenerationSettingPrefix = "objectTypeIdToGenerate.";
+
+/** @return Whether the object type is generated by default, as declared in the manifest. */
+bool isGeneratedByDefault(ObjectClass objectClass);
+
+/** The DeviceAgent settings other than the object type generation ones. */
+enum class Setting: int
+{
+    timestampShiftMs,
+    interpolateBoxes,
+    maxPacketsPerSecond,
+    minBoxChange,
+    connectFirst,
+    count
+};
+
+/**
+ * Declares a setting once, for both the settings model in the Engine manifest and the parsing of
+ * the values the Server sends to DeviceAgent.
+ */
+struct SettingDescriptor
+{
+    enum class Type { spinBox, checkBox };
+
+    Setting setting; /**< Index of the descriptor in kSettingDescriptors. */
+    Type type;
+    const char* name;
+    const char* caption;
+    const char* description;
+    int defaultValue; /**< For a checkbox, 0 or 1. */
+    bool hasRange;
+    int minValue;
+    int maxValue;
+};
+
+inline constexpr std::array<SettingDescriptor, (size_t) Setting::count> kSettingDescriptors = {{
+    {
+        Setting::timestampShiftMs, SettingDescriptor::Type::spinBox,
+        "timestampShiftMs",
+        "Timestamp shift",
+        "Metadata timestamp shift in milliseconds",
+        /*defaultValue*/ 0, /*hasRange*/ false, 0, 0
+    },
+    {
+        Setting::interpolateBoxes, SettingDescriptor::Type::checkBox,
+        "interpolateBoxes",
+        "Interpolate boxes",
+        "Predict boxes for the video frames between two camera updates",
+        /*defaultValue*/ 0, /*hasRange*/ false, 0, 0
+    },
+    {
+        Setting::maxPacketsPerSecond, SettingDescriptor::Type::spinBox,
+        "maxPacketsPerSecond",
+        "Max metadata packets per second",
+        "0 means unlimited; the updates in between are merged",
+        /*defaultValue*/ 0, /*hasRange*/ true, 0, 100
+    },
+    {
+        Setting::minBoxChange, SettingDescriptor::Type::spinBox,
+        "minBoxChange",
+        "Min box change",
+        "Objects are re-sent only if their box moves or resizes by at least this many units "
+            "of the camera's 10000x10000 grid; 0 sends every update. If on, the boxes stay on "
+            "the screen up to the keep-alive interval after their objects are gone",
+        /*defaultValue*/ 0, /*hasRange*/ true, 0, 1000
+    },
+    {
+        Setting::connectFirst, SettingDescriptor::Type::checkBox,
+        "connectFirst",
+        "Connect first",
+        "When many cameras connect at once, e.g. on the Server start, connect this one before "
+            "the others",
+        /*defaultValue*/ 0, /*hasRange*/ false, 0, 0
+    },
+}};
+
+constexpr bool areSettingDescriptorsIndexed()
+{
+    for (size_t i = 0; i < kSettingDescriptors.size(); ++i)
+    {
+        if ((size_t) kSettingDescriptors[i].setting != i)
+            return false;
+    }
+    return true;
+}
+static_assert(areSettingDescriptorsIndexed(), "kSettingDescriptors must be in the Setting order");
+
+constexpr const SettingDescriptor& settingDescriptor(Setting setting)
+{
+    return kSettingDescriptors[(size_t) setting];
+}
+
+/**
+ * Immutable snapshot of the DeviceAgent settings, parsed from the settings map once each time the
+ * Server sends the settings, so that the per-message path reads them by index, without string
+ * work.
+ */
+struct DeviceAgentSettings
+{
+    uint32_t generatedObjectClasses = 0; /**< Bit mask of ObjectClass values. */
+    std::array<int, (size_t) Setting::count> values{}; /**< Indexed by Setting. */
+
+    /** The defaults of the descriptors; no object types are generated until the settings come. */
+    DeviceAgentSettings();
+
+    /**
+     * Does not throw. A missing value is left default; an invalid value is left default, and a
+     * value out of the range is clamped, both reported in the errors.
+     * @param errors Setting name -> error message, as expected in ISettingsResponse.
+     */
+    static DeviceAgentSettings parse(
+        const std::map<std::string, std::string>& settings,
+        std::map<std::string, std::string>* errors);
+
+    int value(Setting setting) const { return values[(size_t) setting]; }
+
+    bool isEnabled(Setting setting) const { return value(setting) != 0; }
+
+    bool isGenerated(ObjectClass objectClass) const
+    {
+        return (generatedObjectClasses & (1u << (int) objectClass)) != 0;
+    }
+
+    void setGenerated(ObjectClass objectClass)
+    {
+        generatedObjectClasses |= 1u << (int) objectClass;
+    }
+};
+
+/**
+ * Holds the current DeviceAgentSettings for the per-message path: load() takes no lock and makes
+ * no allocation, copying the few fields under a sequence lock, and retrying in the rare case the
+ * settings are being published at that moment.
+ *
+ * publish() must be called by one thread at a time; load() can be called from any thread.
+ */
+class PublishedDeviceAgentSettings
+{
+public:
+    /** Publishes the defaults, as constructed by DeviceAgentSettings(). */
+    PublishedDeviceAgentSettings() { publish(DeviceAgentSettings()); }
+
+    void publish(const DeviceAgentSettings& settings);
+
+    DeviceAgentSettings load() const;
+
+private:
+    // Sequence lock: odd while the publisher is updating the fields.
+    std::atomic<uint64_t> m_sequence{0};
+    std::atomic<uint32_t> m_generatedObjectClasses{0};
+    std::array<std::atomic<int>, (size_t) Setting::count> m_values{};
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
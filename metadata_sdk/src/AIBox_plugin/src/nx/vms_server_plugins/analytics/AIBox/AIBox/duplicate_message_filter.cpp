@@ -0,0 +1,75 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "duplicate_message_filter.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+namespace {
+
+/** FNV-1a. */
+class Fingerprint
+{
+public:
+    void add(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_value ^= bytes[i];
+            m_value *= 0x100000001B3ULL;
+        }
+    }
+
+    void add(int64_t value) { add(&value, sizeof(value)); }
+    void add(const std::string& value) { add(value.data(), value.size()); }
+
+    uint64_t value() const { return m_value; }
+
+private:
+    uint64_t m_value = 0xCBF29CE484222325ULL;
+};
+
+} // namespace
+
+bool DuplicateMessageFilter::isDuplicate(const PEAResult& result)
+{
+    if (result.currentTime == 0)
+        return false;
+
+    Fingerprint fingerprint;
+    fingerprint.add(result.currentTime);
+    fingerprint.add(result.deviceMac);
+    for (const auto& traject: result.trajects)
+    {
+        fingerprint.add(traject.targetType);
+        fingerprint.add(traject.targetId);
+        fingerprint.add(traject.x1);
+        fingerprint.add(traject.y1);
+        fingerprint.add(traject.x2);
+        fingerprint.add(traject.y2);
+    }
+
+    const uint64_t value = fingerprint.value();
+    if (std::find(m_fingerprints.begin(), m_fingerprints.end(), value) != m_fingerprints.end())
+        return true;
+
+    m_fingerprints[m_next] = value;
+    m_next = (m_next + 1) % kHistorySize;
+    return false;
+}
+
+void DuplicateMessageFilter::clear()
+{
+    m_fingerprints.fill(0);
+    m_next = 0;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
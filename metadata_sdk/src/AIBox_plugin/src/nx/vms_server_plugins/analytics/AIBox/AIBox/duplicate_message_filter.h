@@ -0,0 +1,43 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "../net/net_utils.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Recognizes the PEA messages which the camera sends again, e.g. after a reconnect, by
+ * remembering the fingerprints of the recently received messages.
+ *
+ * Not thread-safe - the owner is expected to guard it.
+ */
+class DuplicateMessageFilter
+{
+public:
+    /**
+     * @return True if the same message has been seen recently. Messages without the camera
+     *     timestamp are never treated as duplicates, because a static scene legitimately produces
+     *     identical messages.
+     */
+    bool isDuplicate(const PEAResult& result);
+
+    void clear();
+
+private:
+    static constexpr int kHistorySize = 64;
+
+    std::array<uint64_t, kHistorySize> m_fingerprints{};
+    int m_next = 0;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -15,10 +15,13 @@ namespace fs = std::filesystem;
 
 #include <nx/kit/json.h>
 #include <nx/kit/debug.h>
+#include <nx/kit/mutex.h>
 
 #include "device_agent.h"
 #include "device_agent_manifest.h"
+#include "device_agent_settings.h"
 #include "ini.h"
+#include "reactor_monitor.h"
 
 namespace nx {
 namespace vms_server_plugins {
@@ -28,78 +31,157 @@ namespace AIBox {
 using namespace nx::sdk;
 using namespace nx::sdk::analytics;
 
-static const std::set<std::string> kObjectTypeIdsGeneratedByDefault = {
-    kStringHuman,
-    kStringMotorVehicle,
-    kStringMotorcycleBicycle
-};
-
 Engine::Engine(): 
-    nx::sdk::analytics::Engine(ini().enableOutput)
+    nx::sdk::analytics::Engine(ini().enableOutput),
+    m_subscriptionRegistry(std::make_shared<SubscriptionRegistry>(
+        ini().subscriptionLingerMs,
+        ini().startupMaxConnectsPerSecond,
+        ini().startupMaxConcurrentConnects,
+        ini().startupConnectTimeoutMs))
 {
+    nx::kit::setLockProfilingEnabled(ini().enableLockProfile);
+    if (ini().metricsLogIntervalMs > 0)
+    {
+        m_metricsReporter = std::make_unique<MetricsReporter>(ini().metricsLogIntervalMs);
+    }
+    if (ini().enableProfile)
+    {
+        m_profileReporter = std::make_unique<ProfileReporter>(
+            ini().profileWriteIntervalMs,
+            std::string(nx::kit::IniConfig::iniFilesDir()) + "AIBox_profile.txt");
+    }
+    m_stallHandlerId = ReactorMonitor::instance().addStallHandler(
+        [this](const std::string& description)
+        {
+            pushPluginDiagnosticEvent(
+                IPluginDiagnosticEvent::Level::warning, "Camera connection stalled", description);
+        });
 }
 
 Engine::~Engine()
 {
-    EngineManifestHelper::clearManifest();
+    ReactorMonitor::instance().removeStallHandler(m_stallHandlerId);
+    // The manifest index is process-wide and may be in use by another Engine, so it is kept.
+    m_manifestDirWatcher.reset();
 }
 
 void Engine::initialize(nx::sdk::analytics::Plugin* plugin)
 {
     m_plugin = plugin;
     obtainPluginHomeDir();
+    findManifestDir();
     loadCompatibleManifests();
+
+    // New manifests are picked up without restarting the Server.
+    if (!m_manifestDir.empty() && ini().manifestPollIntervalMs > 0)
+    {
+        m_manifestDirWatcher = std::make_unique<ManifestDirWatcher>(
+            m_manifestDir,
+            ini().manifestPollIntervalMs,
+            [this]()
+            {
+                NX_PRINT << "Manifest files have changed, reloading";
+                loadCompatibleManifests();
+            });
+    }
 }
 
 bool Engine::isCompatible(const nx::sdk::IDeviceInfo* deviceInfo) const
 {
     const std::string vendor = nx::kit::utils::toString(deviceInfo->vendor());
     const std::string model = nx::kit::utils::toString(deviceInfo->model());
-    if (!EngineManifestHelper::isVendorSupported(vendor))
+
+    // The Server asks about every camera, and mostly about the same few models; the answers are
+    // valid until the manifests are reloaded.
+    const std::shared_ptr<const ManifestIndex> index = EngineManifestHelper::index();
+    std::lock_guard<std::mutex> lock(m_compatibilityCacheMutex);
+    if (m_compatibilityCacheIndex != index)
+    {
+        m_compatibilityCache.clear();
+        m_compatibilityCacheIndex = index;
+    }
+    const auto key = std::make_pair(vendor, model);
+    const auto cached = m_compatibilityCache.find(key);
+    if (cached != m_compatibilityCache.end())
     {
-        return false;
+        return cached->second;
     }
-    if (!EngineManifestHelper::isModelSupported(model))
+
+    // Answered from the same snapshot the cache belongs to, even if a reload happens meanwhile.
+    const bool isCompatible =
+        index->isVendorSupported(EngineManifestHelper::toLowerSpaceless(vendor))
+        && index->isModelSupported(EngineManifestHelper::toLowerSpaceless(model));
+    if (isCompatible)
     {
-        return false;
+        NX_PRINT << "Device compatible " << vendor << " " << model;
     }
-    NX_PRINT << "Device compatible " << vendor << " " << model;
-    return true;
+    m_compatibilityCache.emplace(key, isCompatible);
+    return isCompatible;
 }
 
 std::string Engine::manifestString() const
+{
+    // The Server asks for the manifest on each device and settings change, while it may change
+    // only with the loaded manifests.
+    const std::shared_ptr<const ManifestIndex> index = EngineManifestHelper::index();
+    std::lock_guard<std::mutex> lock(m_manifestMutex);
+    if (m_manifest.empty() || m_manifestIndex != index)
+    {
+        m_manifest = buildManifestString();
+        m_manifestIndex = index;
+    }
+    return m_manifest;
+}
+
+std::string Engine::buildManifestString() const
 {
     using namespace nx::kit;
 
-    std::string errors;
-    Json deviceAgentManifest = Json::parse(kDeviceAgentManifest, errors).object_items();
+    // Parsed once: the DeviceAgent manifest is a compile-time constant.
+    static const Json::array kSupportedTypes =
+        []()
+        {
+            std::string errors;
+            return Json::parse(kDeviceAgentManifest, errors)["supportedTypes"].array_items();
+        }();
 
     Json::array generationSettings;
-
-    Json::object timeShiftSetting = {
-        {"type", "SpinBox"},
-        {"name", DeviceAgent::kTimeShiftSetting},
-        {"caption", "Timestamp shift"},
-        {"description", "Metadata timestamp shift in milliseconds"},
-        {"defaultValue", 0}
-    };
-    generationSettings.push_back(std::move(timeShiftSetting));
+    for (const SettingDescriptor& descriptor: kSettingDescriptors)
+    {
+        Json::object setting = {
+            {"name", descriptor.name},
+            {"caption", descriptor.caption},
+            {"description", descriptor.description}
+        };
+        if (descriptor.type == SettingDescriptor::Type::checkBox)
+        {
+            setting["type"] = "CheckBox";
+            setting["defaultValue"] = descriptor.defaultValue != 0;
+        }
+        else
+        {
+            setting["type"] = "SpinBox";
+            setting["defaultValue"] = descriptor.defaultValue;
+            if (descriptor.hasRange)
+            {
+                setting["minValue"] = descriptor.minValue;
+                setting["maxValue"] = descriptor.maxValue;
+            }
+        }
+        generationSettings.push_back(std::move(setting));
+    }
 
     generationSettings.push_back(Json::object{ {"type", "Separator"} });
 
-    for (const auto& supportedType : deviceAgentManifest["supportedTypes"].array_items())
+    for (const auto& supportedType : kSupportedTypes)
     {
         Json::object supportedTypeObject = supportedType.object_items();
         const std::string& objectTypeId = supportedTypeObject["objectTypeId"].string_value();
         Json::object generationSetting = {
             {"type", "CheckBox"},
-            {"name", DeviceAgent::kObjectTypeGenerationSettingPrefix + objectTypeId},
+            {"name", kObjectTypeGenerationSettingPrefix + objectTypeId},
             {"caption", objectTypeId},
-            {
-                "defaultValue",
-                kObjectTypeIdsGeneratedByDefault.find(objectTypeId)
-                    != kObjectTypeIdsGeneratedByDefault.cend()
-            }
+            {"defaultValue", isGeneratedByDefault(objectClassFromTypeId(objectTypeId))}
         };
         generationSettings.push_back(std::move(generationSetting));
     }
@@ -110,7 +192,9 @@ std::string Engine::manifestString() const
     };
 
     Json::object engineManifest = {
-        {"streamTypeFilter", "compressedVideo"},
+        // In the metadata-only mode the timestamps come from the camera clock, so no media is
+        // needed.
+        {"streamTypeFilter", ini().metadataOnlyMode ? "" : "compressedVideo"},
         {"deviceAgentSettingsModel", settingsModel}
     };
 
@@ -119,7 +203,7 @@ std::string Engine::manifestString() const
 
 void Engine::doObtainDeviceAgent(Result<IDeviceAgent*>* outResult, const IDeviceInfo* deviceInfo)
 {
-    *outResult = new DeviceAgent(deviceInfo);
+    *outResult = new DeviceAgent(deviceInfo, m_subscriptionRegistry);
 }
 
 void Engine::obtainPluginHomeDir()
@@ -145,7 +229,7 @@ void Engine::obtainPluginHomeDir()
     }
 }
 
-void Engine::loadCompatibleManifests()
+void Engine::findManifestDir()
 {
     if (m_pluginHomeDir.empty())
     {
@@ -169,8 +253,25 @@ void Engine::loadCompatibleManifests()
             NX_PRINT << "Plugin home dir does not exist or is not a directory: " << baseDir;
             return;
         }
-        size_t added = 0;
-        for (const auto& entry : fs::directory_iterator(baseDir))
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Failed to check plugin home dir: " << e.what() << '\n';
+        return;
+    }
+    m_manifestDir = baseDir;
+}
+
+void Engine::loadCompatibleManifests()
+{
+    if (m_manifestDir.empty())
+    {
+        return;
+    }
+    try
+    {
+        std::vector<std::string> manifestPaths;
+        for (const auto& entry : fs::directory_iterator(m_manifestDir))
         {
             if (!fs::is_regular_file(entry.status()))
             {
@@ -181,21 +282,22 @@ void Engine::loadCompatibleManifests()
             {
                 continue;
             }
-            m_manifestPaths.push_back(filePath);
-            ++added;
+            manifestPaths.push_back(filePath);
         }
-        if (added == 0)
+        if (manifestPaths.empty())
         {
-            NX_PRINT << "No manifest files found in: " << baseDir;
-            return;
+            NX_PRINT << "No manifest files found in: " << m_manifestDir;
         }
-        if (EngineManifestHelper::loadManifests(m_manifestPaths))
+
+        // Publishes the index even if there are no files, so that removing them takes effect.
+        if (EngineManifestHelper::loadManifests(manifestPaths))
         {
-            NX_PRINT << "Loaded " << added << " manifest files from: " << baseDir;
+            NX_PRINT << "Loaded " << manifestPaths.size() << " manifest files from: "
+                << m_manifestDir;
         }
         else
         {
-            NX_PRINT << "Failed to load manifest files from: " << baseDir;
+            NX_PRINT << "Failed to load manifest files from: " << m_manifestDir;
         }
     }
     catch(const std::exception& e)
@@ -2,11 +2,20 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
 #include <nx/sdk/analytics/helpers/engine.h>
 #include <nx/sdk/analytics/helpers/plugin.h>
 #include <nx/sdk/analytics/i_uncompressed_video_frame.h>
 
 #include "engine_manifest.h"
+#include "manifest_dir_watcher.h"
+#include "metrics.h"
+#include "subscription_registry.h"
 
 namespace nx {
 namespace vms_server_plugins {
@@ -32,13 +41,36 @@ protected:
         const nx::sdk::IDeviceInfo* deviceInfo) override;
 
 private:
+    std::string buildManifestString() const;
     void obtainPluginHomeDir();
+    void findManifestDir();
+
+    /** (Re)loads all the manifests from the manifest dir. */
     void loadCompatibleManifests();
 
 private:
     nx::sdk::analytics::Plugin* m_plugin = nullptr;
     std::string m_pluginHomeDir;
-    std::vector<std::string> m_manifestPaths;
+
+    /** Empty if the manifests are not available. */
+    std::string m_manifestDir;
+    std::unique_ptr<ManifestDirWatcher> m_manifestDirWatcher;
+
+    mutable std::mutex m_manifestMutex;
+    mutable std::shared_ptr<const ManifestIndex> m_manifestIndex;
+    mutable std::string m_manifest;
+
+    mutable std::mutex m_compatibilityCacheMutex;
+    mutable std::shared_ptr<const ManifestIndex> m_compatibilityCacheIndex;
+    mutable std::map<std::pair<std::string, std::string>, bool> m_compatibilityCache;
+    std::unique_ptr<MetricsReporter> m_metricsReporter;
+    std::unique_ptr<ProfileReporter> m_profileReporter;
+
+    /** The reactors are process-wide, and each Engine reports their stalls to the Server. */
+    int m_stallHandlerId = 0;
+
+    /** Shared with the DeviceAgents, which may outlive the Engine. */
+    std::shared_ptr<SubscriptionRegistry> m_subscriptionRegistry;
 };
 
 } // namespace AIBox
@@ -4,20 +4,21 @@
 #include <fstream>
 #include <cctype>
 #include <algorithm>
+#include <atomic>
 
 #include <nx/kit/debug.h>
 
-namespace nx::vms_server_plugins::analytics::AIBox::ManifestStorage {
-    std::unordered_set<std::string> supportedVendors;
-    std::unordered_set<std::string> supportedModels;
-    std::unordered_set<std::string> partlySupportedModels;
-    std::vector<EventType> supportedPeaEvents;
-}
-
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
 namespace AIBox {
+
+namespace {
+
+/** Accessed only via std::atomic_load() and std::atomic_store(). */
+std::shared_ptr<const ManifestIndex> currentIndex = std::make_shared<const ManifestIndex>();
+
+} // namespace
     
 std::string EngineManifestHelper::toLowerSpaceless(const std::string& str)
 {
@@ -61,7 +62,8 @@ void EngineManifestHelper::parseEvents(const nlohmann::json& eventJsonArray, std
     }
 }
 
-bool EngineManifestHelper::loadManifest(const std::string& jsonFilePath)
+bool EngineManifestHelper::loadManifest(
+    const std::string& jsonFilePath, ManifestContents& contents)
 {
     std::ifstream jsonFile(jsonFilePath);
     if (!jsonFile.is_open())
@@ -88,7 +90,7 @@ bool EngineManifestHelper::loadManifest(const std::string& jsonFilePath)
         for (const auto& vendor : manifestJson["supportedCameraVendors"])
         {
             std::string lowerVendor = toLowerSpaceless(vendor.get<std::string>());
-            ManifestStorage::supportedVendors.insert(lowerVendor);
+            contents.vendors.insert(lowerVendor);
         }
     }
 
@@ -97,7 +99,7 @@ bool EngineManifestHelper::loadManifest(const std::string& jsonFilePath)
         for (const auto& model : manifestJson["supportedCameraModels"])
         {
             std::string lowerModel = toLowerSpaceless(model.get<std::string>());
-            ManifestStorage::supportedModels.insert(lowerModel);
+            contents.models.insert(lowerModel);
         }
     }
 
@@ -106,13 +108,13 @@ bool EngineManifestHelper::loadManifest(const std::string& jsonFilePath)
         for (const auto& model : manifestJson["partlySupportedCameraModels"])
         {
             std::string lowerModel = toLowerSpaceless(model.get<std::string>());
-            ManifestStorage::partlySupportedModels.insert(lowerModel);
+            contents.models.insert(lowerModel);
         }
     }
 
     if (manifestJson.contains("eventTypes") && manifestJson["eventTypes"].is_array())
     {
-        parseEvents(manifestJson["eventTypes"], ManifestStorage::supportedPeaEvents);
+        parseEvents(manifestJson["eventTypes"], contents.peaEvents);
     }
 
     NX_PRINT << "Successfully loaded manifest file: " << jsonFilePath;
@@ -121,40 +123,38 @@ bool EngineManifestHelper::loadManifest(const std::string& jsonFilePath)
 
 bool EngineManifestHelper::loadManifests(const std::vector<std::string>& jsonFilePaths)
 {
+    ManifestContents contents;
     bool allLoaded = true;
     for (const auto& path : jsonFilePaths)
     {
-        if (!loadManifest(path))
+        if (!loadManifest(path, contents))
         {
             allLoaded = false;
         }
     }
+    publish(std::make_shared<const ManifestIndex>(
+        contents.vendors, std::move(contents.models), std::move(contents.peaEvents)));
     return allLoaded;
 }
 
+std::shared_ptr<const ManifestIndex> EngineManifestHelper::index()
+{
+    return std::atomic_load(&currentIndex);
+}
+
 bool EngineManifestHelper::isVendorSupported(const std::string& deviceVendor)
 {
-    const std::string lowerVendor = toLowerSpaceless(deviceVendor);
-    for (const auto& supportedVendor : ManifestStorage::supportedVendors)
-    {
-        if (lowerVendor.find(supportedVendor) == 0)
-        {
-            return true;
-        }
-    }
-    return false;
+    return index()->isVendorSupported(toLowerSpaceless(deviceVendor));
 }
 
 bool EngineManifestHelper::isModelSupported(const std::string& deviceModel)
 {
-    const std::string lowerModel = toLowerSpaceless(deviceModel);
-    return ManifestStorage::supportedModels.count(lowerModel) > 0 
-        || ManifestStorage::partlySupportedModels.count(lowerModel) > 0;
+    return index()->isModelSupported(toLowerSpaceless(deviceModel));
 }
 
 bool EngineManifestHelper::isPeaEventSupported(const std::string& eventId)
 {
-    for (const auto& event : ManifestStorage::supportedPeaEvents)
+    for (const auto& event : index()->peaEvents())
     {
         if (event.id == eventId)
         {
@@ -164,19 +164,22 @@ bool EngineManifestHelper::isPeaEventSupported(const std::string& eventId)
     return false;
 }
 
-const std::vector<EventType>& EngineManifestHelper::getSupportedPeaEvents()
+std::vector<EventType> EngineManifestHelper::getSupportedPeaEvents()
 {
-    return ManifestStorage::supportedPeaEvents;
+    return index()->peaEvents();
 }
 
-void EngineManifestHelper::clearManifest() {
-    ManifestStorage::supportedVendors.clear();
-    ManifestStorage::supportedModels.clear();
-    ManifestStorage::partlySupportedModels.clear();
-    ManifestStorage::supportedPeaEvents.clear();
+void EngineManifestHelper::clearManifest()
+{
+    publish(std::make_shared<const ManifestIndex>());
+}
+
+void EngineManifestHelper::publish(std::shared_ptr<const ManifestIndex> index)
+{
+    std::atomic_store(&currentIndex, std::move(index));
 }
 
 } // namespace AIBox
 } // namespace analytics
 } // namespace vms_server_plugins
-} // namespace nx
\ No newline at end of file
+} // namespace nx
@@ -1,46 +1,60 @@
 #pragma once
 
+#include <memory>
 #include <unordered_set>
 #include <string>
 #include <vector>
 
 #include "nlohmann/json.hpp"
 
+#include "manifest_index.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
 namespace AIBox {
 
-struct EventType
-{
-    std::string id;
-    std::string internalName;
-    std::string alarmName;
-    bool restricted = false;
-    int group = 0;
-};
-
-namespace ManifestStorage {
-    extern std::unordered_set<std::string> supportedVendors;
-    extern std::unordered_set<std::string> supportedModels;
-    extern std::unordered_set<std::string> partlySupportedModels;
-    extern std::vector<EventType> supportedPeaEvents;
-}
-
+/**
+ * Loads the manifests which declare the compatible cameras. The loaded contents are published as
+ * an immutable ManifestIndex, atomically replaced on each (re)load, so the queries are lock-free
+ * and may run concurrently with a reload.
+ */
 class EngineManifestHelper
 {
 public:
-    static bool loadManifest(const std::string& jsonFilePath);
+    /**
+     * Replaces the current index with the one compiled from the given files; the files which
+     * fail to load are skipped.
+     * @return False if any of the files has failed to load.
+     */
     static bool loadManifests(const std::vector<std::string>& jsonFilePaths);
+
+    /** @return Never null; the snapshot stays valid while held, regardless of the reloads. */
+    static std::shared_ptr<const ManifestIndex> index();
+
     static bool isVendorSupported(const std::string& vendor);
     static bool isModelSupported(const std::string& model);
     static bool isPeaEventSupported(const std::string& eventId);
-    static const std::vector<EventType>& getSupportedPeaEvents();
+    static std::vector<EventType> getSupportedPeaEvents();
     static void clearManifest();
 
-private:
+    /**
+     * The normalization applied to the vendors and models of the manifests; the queries to
+     * ManifestIndex are to be normalized the same way.
+     */
     static std::string toLowerSpaceless(const std::string& str);
+
+private:
+    struct ManifestContents
+    {
+        std::unordered_set<std::string> vendors;
+        std::unordered_set<std::string> models; /**< Both the supported and partly supported. */
+        std::vector<EventType> peaEvents;
+    };
+
+    static bool loadManifest(const std::string& jsonFilePath, ManifestContents& contents);
     static void parseEvents(const nlohmann::json& eventJsonArray, std::vector<EventType>& outEvents);
+    static void publish(std::shared_ptr<const ManifestIndex> index);
 };
 
 } // namespace AIBox
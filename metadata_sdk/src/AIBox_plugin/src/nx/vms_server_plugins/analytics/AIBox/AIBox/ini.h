@@ -15,7 +15,34 @@ struct Ini: public nx::kit::IniConfig
     Ini(): IniConfig("AIBox_plugin.ini") { reload(); }
 
     NX_INI_FLAG(0, enableOutput, "Can use NX_OUTPUT or not.");
+    NX_INI_FLAG(0, asyncOutput, "Write the log lines on a background thread instead of the printing one.");
+    NX_INI_INT(0, maxLogLinesPerSecond, "Each place in the code prints at most this many log lines per second; 0 means unlimited.");
     NX_INI_FLAG(0, isLicenseRequired, "Whether the Plugin declares in its manifest that it requires a license.");
+    NX_INI_FLAG(0, metadataOnlyMode, "Request no video from the Server and timestamp the metadata using the camera clock mapped to the Server clock. Box interpolation is not available in this mode.");
+    NX_INI_INT(100, metadataOnlyFlushIntervalMs, "In metadataOnlyMode, the track updates held back by the rate limit, and the full refreshes, are sent from a timer this often, even if the camera goes quiet; 0 disables the timer.");
+    NX_INI_INT(1000, cameraTimeUnitUs, "Duration of the camera currentTime unit, in microseconds.");
+    NX_INI_INT(30000, clockSyncWindowMs, "Window over which the offset between the camera and the Server clocks is estimated.");
+    NX_INI_INT(2000, maxCameraClockOffsetMs, "Camera is reported if the offset of its clock from the Server clock exceeds this; 0 disables the check.");
+    NX_INI_INT(500, maxCameraNetworkDelayMs, "Camera is reported if its messages arrive later than this above the best delay seen; 0 disables the check.");
+    NX_INI_INT(10000, subscriptionGracePeriodMs, "Camera subscription is kept for this time after the metadata stops being needed.");
+    NX_INI_INT(1000, subscriptionRetryMinDelayMs, "Camera subscription which has failed to connect is retried after this time, doubled after each next failure.");
+    NX_INI_INT(60000, subscriptionRetryMaxDelayMs, "Camera subscription retries are not delayed longer than this.");
+    NX_INI_INT(30000, subscriptionLingerMs, "Camera subscription released by a DeviceAgent is kept alive for this time, to be reused by the next DeviceAgent of the camera.");
+    NX_INI_INT(20, startupMaxConnectsPerSecond, "New camera connections are started at most this often; 0 means unlimited.");
+    NX_INI_INT(8, startupMaxConcurrentConnects, "At most this many new camera connections are being established at a time; 0 means unlimited.");
+    NX_INI_INT(3000, startupConnectTimeoutMs, "New camera connection stops occupying a startup slot after this time even if not established yet.");
+    NX_INI_INT(2000, manifestPollIntervalMs, "Plugin home dir is checked for changed manifests this often if inotify is not available; 0 disables reloading the manifests.");
+    NX_INI_FLAG(0, enableProfile, "Collect the NX_PROFILE_ZONE statistics, written to AIBox_profile.txt next to this file.");
+    NX_INI_FLAG(0, enableLockProfile, "Collect the contention statistics of the Plugin and SDK locks, published with the metrics and the profile.");
+    NX_INI_INT(10000, profileWriteIntervalMs, "If enableProfile is on, the profile file is rewritten with this period.");
+    NX_INI_INT(0, metricsLogIntervalMs, "If positive, the plugin metrics are logged with this period.");
+    NX_INI_INT(1000, reactorProbeIntervalMs, "Each camera I/O thread measures how late it dispatches a timer this often; 0 disables the probes.");
+    NX_INI_INT(100, reactorStallThresholdMs, "Camera I/O thread blocked, or its handler running, for longer than this is reported as a stall; 0 disables the reports.");
+    NX_INI_FLAG(0, asyncMetadataDispatch, "Deliver metadata to the Server on a dedicated thread per camera instead of the camera I/O thread.");
+    NX_INI_INT(2000, trackTimeoutMs, "Track is forgotten if the camera has not updated it for this time.");
+    NX_INI_INT(500, maxBoxExtrapolationMs, "Interpolated boxes are not predicted further than this after the last camera update.");
+    NX_INI_INT(1000, trackKeepAliveMs, "Track with an unchanged box is re-sent at least this often, if the box change suppression is on.");
+    NX_INI_INT(10000, fullRefreshIntervalMs, "All tracks are re-sent this often, if the box change suppression is on.");
 };
 
 Ini& ini();
@@ -0,0 +1,213 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "manifest_dir_watcher.h"
+
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#if defined(__GNUC__) && __GNUC__ < 9
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#else
+#include <filesystem>
+namespace fs = std::filesystem;
+#endif
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <nx/kit/debug.h>
+
+#include "ini.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+namespace {
+
+/** How often the watching thread checks whether it is stopped. */
+constexpr int kStopCheckIntervalMs = 200;
+
+/** Changes coming closer to each other than this are reported once. */
+constexpr int kSettleTimeMs = 300;
+
+bool isManifestFileName(const std::string& name)
+{
+    static const std::string kExtension = ".json";
+    return name.size() > kExtension.size()
+        && name.compare(name.size() - kExtension.size(), kExtension.size(), kExtension) == 0;
+}
+
+} // namespace
+
+ManifestDirWatcher::ManifestDirWatcher(
+    std::string dir, int pollIntervalMs, std::function<void()> onChanged)
+    :
+    m_dir(std::move(dir)),
+    m_pollIntervalMs(pollIntervalMs),
+    m_onChanged(std::move(onChanged)),
+    m_thread([this]() { run(); })
+{
+}
+
+ManifestDirWatcher::~ManifestDirWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopped = true;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+}
+
+void ManifestDirWatcher::run()
+{
+    if (!watchWithInotify())
+    {
+        NX_OUTPUT << "Watching the manifests by polling every " << m_pollIntervalMs << " ms";
+        watchByPolling();
+    }
+}
+
+bool ManifestDirWatcher::watchWithInotify()
+{
+    #if defined(__linux__)
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        const uint32_t kMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE
+            | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+        int watch = inotify_add_watch(fd, m_dir.c_str(), kMask);
+        if (watch < 0)
+        {
+            close(fd);
+            return false;
+        }
+        NX_OUTPUT << "Watching the manifests with inotify";
+
+        alignas(struct inotify_event) char buffer[4096];
+        bool isChangePending = false;
+        while (!m_isStopped)
+        {
+            pollfd pollFd{fd, POLLIN, 0};
+            const int timeoutMs = isChangePending ? kSettleTimeMs : kStopCheckIntervalMs;
+            const int result = poll(&pollFd, 1, timeoutMs);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            if (result == 0)
+            {
+                if (isChangePending)
+                {
+                    isChangePending = false;
+                    m_onChanged();
+                }
+                continue;
+            }
+
+            bool isWatchLost = false;
+            ssize_t size = 0;
+            while ((size = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* p = buffer; p < buffer + size;)
+                {
+                    const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+                    if (event->wd == watch)
+                    {
+                        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+                        {
+                            isWatchLost = true;
+                        }
+                        else if (event->len > 0 && isManifestFileName(event->name))
+                        {
+                            isChangePending = true;
+                        }
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+
+            if (isWatchLost)
+            {
+                // The dir has been removed or moved away; it may have been replaced by another
+                // one, e.g. on a plugin update. The events of the old watch are ignored.
+                inotify_rm_watch(fd, watch);
+                isChangePending = true;
+                watch = inotify_add_watch(fd, m_dir.c_str(), kMask);
+                if (watch < 0)
+                {
+                    NX_OUTPUT << "The manifest dir has vanished: " << m_dir;
+                    close(fd);
+                    m_onChanged();
+                    return false;
+                }
+                NX_OUTPUT << "The manifest dir has been replaced, watching the new one";
+            }
+        }
+        close(fd);
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+void ManifestDirWatcher::watchByPolling()
+{
+    std::map<std::string, FileState> files = listManifests();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_isStopped)
+    {
+        m_wakeUp.wait_for(lock, std::chrono::milliseconds(m_pollIntervalMs));
+        if (m_isStopped)
+        {
+            break;
+        }
+
+        lock.unlock();
+        std::map<std::string, FileState> newFiles = listManifests();
+        if (newFiles != files)
+        {
+            files = std::move(newFiles);
+            m_onChanged();
+        }
+        lock.lock();
+    }
+}
+
+std::map<std::string, ManifestDirWatcher::FileState> ManifestDirWatcher::listManifests() const
+{
+    std::map<std::string, FileState> files;
+    std::error_code error;
+    for (fs::directory_iterator it(m_dir, error), end; !error && it != end; it.increment(error))
+    {
+        if (!isManifestFileName(it->path().filename().string()))
+        {
+            continue;
+        }
+        // A file being replaced may vanish meanwhile; it is then seen on the next listing.
+        std::error_code fileError;
+        FileState state;
+        state.modificationTime =
+            (int64_t) fs::last_write_time(it->path(), fileError).time_since_epoch().count();
+        state.size = fs::file_size(it->path(), fileError);
+        files[it->path().string()] = state;
+    }
+    return files;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,69 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Watches a directory for the created, modified and removed *.json files, and calls the handler
+ * on its own thread after each burst of changes. Uses inotify where available, and falls back to
+ * comparing the directory listings periodically. If the directory is removed or moved away, the
+ * watch is re-armed on its path, or, if there is no directory there anymore, the polling takes
+ * over and picks the directory up when it reappears.
+ */
+class ManifestDirWatcher
+{
+public:
+    ManifestDirWatcher(std::string dir, int pollIntervalMs, std::function<void()> onChanged);
+    ~ManifestDirWatcher();
+
+private:
+    struct FileState
+    {
+        int64_t modificationTime = 0;
+        uintmax_t size = 0;
+
+        bool operator==(const FileState& other) const
+        {
+            return modificationTime == other.modificationTime && size == other.size;
+        }
+    };
+
+    void run();
+
+    /**
+     * @return False if inotify is not available, or the directory has vanished; then the polling
+     *     is to be used.
+     */
+    bool watchWithInotify();
+
+    void watchByPolling();
+    std::map<std::string, FileState> listManifests() const;
+
+private:
+    const std::string m_dir;
+    const int m_pollIntervalMs;
+    const std::function<void()> m_onChanged;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<bool> m_isStopped{false};
+    std::thread m_thread;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,77 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "manifest_index.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+namespace {
+
+template<typename Children>
+int findChild(const Children& children, char c)
+{
+    for (const auto& child: children)
+    {
+        if (child.first == c)
+            return child.second;
+    }
+    return -1;
+}
+
+} // namespace
+
+ManifestIndex::ManifestIndex(
+    const std::unordered_set<std::string>& vendors,
+    std::unordered_set<std::string> models,
+    std::vector<EventType> peaEvents)
+    :
+    m_vendorTrie(1),
+    m_models(std::move(models)),
+    m_peaEvents(std::move(peaEvents))
+{
+    for (const std::string& vendor: vendors)
+    {
+        int node = 0;
+        for (const char c: vendor)
+        {
+            int child = findChild(m_vendorTrie[node].children, c);
+            if (child < 0)
+            {
+                child = (int) m_vendorTrie.size();
+                m_vendorTrie.emplace_back();
+                m_vendorTrie[node].children.emplace_back(c, child);
+            }
+            node = child;
+        }
+        m_vendorTrie[node].isTerminal = true;
+    }
+}
+
+bool ManifestIndex::isVendorSupported(const std::string& vendor) const
+{
+    if (m_vendorTrie.empty())
+        return false;
+
+    int node = 0;
+    for (const char c: vendor)
+    {
+        if (m_vendorTrie[node].isTerminal)
+            return true;
+        node = findChild(m_vendorTrie[node].children, c);
+        if (node < 0)
+            return false;
+    }
+    return m_vendorTrie[node].isTerminal;
+}
+
+bool ManifestIndex::isModelSupported(const std::string& model) const
+{
+    return m_models.count(model) > 0;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
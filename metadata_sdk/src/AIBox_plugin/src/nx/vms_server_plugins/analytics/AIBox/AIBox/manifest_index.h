@@ -0,0 +1,64 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+struct EventType
+{
+    std::string id;
+    std::string internalName;
+    std::string alarmName;
+    bool restricted = false;
+    int group = 0;
+};
+
+/**
+ * Compiled contents of the loaded manifests. Immutable after the construction, so it is shared
+ * between threads without locks; a reload builds a new index instead of modifying this one.
+ *
+ * The vendors and models are expected to be normalized by the caller, the same way as the
+ * manifest entries have been.
+ */
+class ManifestIndex
+{
+public:
+    ManifestIndex() = default;
+
+    ManifestIndex(
+        const std::unordered_set<std::string>& vendors,
+        std::unordered_set<std::string> models,
+        std::vector<EventType> peaEvents);
+
+    /** @return Whether the vendor starts with one of the supported vendors. */
+    bool isVendorSupported(const std::string& vendor) const;
+
+    bool isModelSupported(const std::string& model) const;
+
+    const std::vector<EventType>& peaEvents() const { return m_peaEvents; }
+
+private:
+    /** Node of the vendor prefix trie; the root is m_vendorTrie[0]. */
+    struct TrieNode
+    {
+        std::vector<std::pair<char, int>> children; /**< Character, index of the child. */
+        bool isTerminal = false;
+    };
+
+    std::vector<TrieNode> m_vendorTrie;
+    std::unordered_set<std::string> m_models;
+    std::vector<EventType> m_peaEvents;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
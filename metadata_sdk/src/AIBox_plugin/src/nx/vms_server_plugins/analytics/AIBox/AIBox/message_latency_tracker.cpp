@@ -0,0 +1,105 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "message_latency_tracker.h"
+
+#include <cstdlib>
+#include <utility>
+
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+MessageLatencyTracker::MessageLatencyTracker(
+    std::string deviceId,
+    const std::string& metricsPrefix,
+    int64_t maxClockOffsetUs,
+    int64_t maxNetworkDelayUs)
+    :
+    m_deviceId(std::move(deviceId)),
+    m_maxClockOffsetUs(maxClockOffsetUs),
+    m_maxNetworkDelayUs(maxNetworkDelayUs),
+    m_networkUs(Metrics::instance().histogram(metricsPrefix + "latency.networkUs")),
+    m_parseUs(Metrics::instance().histogram(metricsPrefix + "latency.parseUs")),
+    m_buildUs(Metrics::instance().histogram(metricsPrefix + "latency.buildUs")),
+    m_pushUs(Metrics::instance().histogram(metricsPrefix + "latency.pushUs")),
+    m_pluginUs(Metrics::instance().histogram(metricsPrefix + "latency.pluginUs")),
+    m_clockOffsetUsMetric(Metrics::instance().value(metricsPrefix + "latency.clockOffsetUs")),
+    m_clockOffsetExceededMetric(
+        Metrics::instance().value(metricsPrefix + "latency.clockOffsetExceeded")),
+    m_networkDelayExceededMetric(
+        Metrics::instance().value(metricsPrefix + "latency.networkDelayExceeded"))
+{
+}
+
+void MessageLatencyTracker::record(
+    const MessageTiming& timing,
+    int64_t cameraTimeUs,
+    int64_t clockOffsetUs,
+    int64_t builtUs,
+    int64_t pushedUs)
+{
+    if (timing.receivedUs == 0)
+    {
+        return;
+    }
+
+    if (cameraTimeUs > 0 && timing.receivedSystemUs > 0)
+    {
+        const int64_t networkUs = timing.receivedSystemUs - cameraTimeUs - clockOffsetUs;
+        m_networkUs.record(networkUs);
+        m_clockOffsetUsMetric.store(clockOffsetUs, std::memory_order_relaxed);
+
+        updateFlag(
+            m_maxClockOffsetUs > 0 && std::llabs(clockOffsetUs) > m_maxClockOffsetUs,
+            &m_isClockOffsetExceeded, &m_clockOffsetExceededMetric, "clock offset",
+            clockOffsetUs, m_maxClockOffsetUs);
+        updateFlag(
+            m_maxNetworkDelayUs > 0 && networkUs > m_maxNetworkDelayUs,
+            &m_isNetworkDelayExceeded, &m_networkDelayExceededMetric, "network delay",
+            networkUs, m_maxNetworkDelayUs);
+    }
+
+    if (timing.parsedUs > 0)
+    {
+        m_parseUs.record(timing.parsedUs - timing.receivedUs);
+        if (builtUs > 0)
+        {
+            m_buildUs.record(builtUs - timing.parsedUs);
+        }
+    }
+    if (builtUs > 0 && pushedUs > 0)
+    {
+        m_pushUs.record(pushedUs - builtUs);
+        m_pluginUs.record(pushedUs - timing.receivedUs);
+    }
+}
+
+void MessageLatencyTracker::updateFlag(
+    bool isExceeded, bool* isFlagged, std::atomic<int64_t>* metric, const char* what,
+    int64_t valueUs, int64_t thresholdUs)
+{
+    if (isExceeded == *isFlagged)
+    {
+        return;
+    }
+    *isFlagged = isExceeded;
+    metric->store(isExceeded ? 1 : 0, std::memory_order_relaxed);
+    if (isExceeded)
+    {
+        NX_PRINT << "Device " << m_deviceId << ": " << what << " " << valueUs / 1000
+            << " ms exceeds " << thresholdUs / 1000 << " ms";
+    }
+    else
+    {
+        NX_PRINT << "Device " << m_deviceId << ": " << what << " is back within "
+            << thresholdUs / 1000 << " ms";
+    }
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,88 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "metrics.h"
+#include "../net/net_utils.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Accounts where the latency of the camera messages comes from, per stage, in the histograms
+ * "<prefix>latency.<stage>Us" of Metrics:
+ * - network: from the camera time to receiving the message, minus the estimated clock offset.
+ *     The constant part of the network delay is indistinguishable from the clock offset, so only
+ *     the delay above the minimum over the clock sync window is seen here.
+ * - parse: from receiving the message header to the message parsed, including reading the body.
+ * - build: from the message parsed to the metadata packet built, including the track filtering.
+ * - push: from the packet built to pushMetadataPacket() returned. With asyncMetadataDispatch, it
+ *     is only the queueing of the packet for the dispatch thread.
+ * - plugin: from receiving the message to pushMetadataPacket() returned.
+ *
+ * Besides, the camera is flagged in "<prefix>latency.clockOffsetExceeded" and
+ * "<prefix>latency.networkDelayExceeded" while its clock offset or its network delay exceeds the
+ * threshold, and each change of the flags is logged.
+ *
+ * Must be used by one thread at a time.
+ */
+class MessageLatencyTracker
+{
+public:
+    /**
+     * @param maxClockOffsetUs Threshold of the clock offset magnitude; 0 means no threshold.
+     * @param maxNetworkDelayUs Threshold of the network stage; 0 means no threshold.
+     */
+    MessageLatencyTracker(
+        std::string deviceId,
+        const std::string& metricsPrefix,
+        int64_t maxClockOffsetUs,
+        int64_t maxNetworkDelayUs);
+
+    /**
+     * @param cameraTimeUs Camera clock, since epoch; 0 if the message has no time.
+     * @param clockOffsetUs Estimated offset of the Server clock from the camera clock; see
+     *     ClockSyncEstimator.
+     * @param builtUs Steady clock; 0 if no packet has been made of the message.
+     * @param pushedUs Steady clock; 0 if no packet has been made of the message.
+     */
+    void record(
+        const MessageTiming& timing,
+        int64_t cameraTimeUs,
+        int64_t clockOffsetUs,
+        int64_t builtUs,
+        int64_t pushedUs);
+
+private:
+    void updateFlag(
+        bool isExceeded, bool* isFlagged, std::atomic<int64_t>* metric, const char* what,
+        int64_t valueUs, int64_t thresholdUs);
+
+private:
+    const std::string m_deviceId;
+    const int64_t m_maxClockOffsetUs;
+    const int64_t m_maxNetworkDelayUs;
+
+    LatencyHistogram& m_networkUs;
+    LatencyHistogram& m_parseUs;
+    LatencyHistogram& m_buildUs;
+    LatencyHistogram& m_pushUs;
+    LatencyHistogram& m_pluginUs;
+    std::atomic<int64_t>& m_clockOffsetUsMetric;
+    std::atomic<int64_t>& m_clockOffsetExceededMetric;
+    std::atomic<int64_t>& m_networkDelayExceededMetric;
+
+    bool m_isClockOffsetExceeded = false;
+    bool m_isNetworkDelayExceeded = false;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,114 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "metadata_packet_builder.h"
+
+#include <nx/kit/debug.h>
+
+#include "allocation_tracker.h"
+#include "ini.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+using namespace nx::sdk;
+using namespace nx::sdk::analytics;
+
+Ptr<IMetadataPacket> MetadataPacketBuilder::buildPendingPacket(
+    TrackTable* trackTable,
+    TrackChangeDetector* changeDetector,
+    int64_t timestampUs,
+    int64_t durationUs)
+{
+    NX_PROFILE_ZONE("packet build");
+    const AllocationScope allocationScope("packet build");
+    m_objectBoxes.clear();
+    const bool isFullRefresh = changeDetector->startPacket(timestampUs);
+    trackTable->forEach(
+        [&](TrackTable::Track* track)
+        {
+            if (!track->pending && !isFullRefresh)
+            {
+                return;
+            }
+            const Rect& box = track->newestSample().box;
+            if (!isFullRefresh && !changeDetector->hasChanged(*track, box, timestampUs))
+            {
+                trackTable->setSkipped(track);
+                return;
+            }
+            addObjectBox(*track, box);
+            trackTable->setEmitted(track, timestampUs, box);
+        });
+
+    return finishPacket(timestampUs, durationUs);
+}
+
+Ptr<IMetadataPacket> MetadataPacketBuilder::buildInterpolatedPacket(
+    TrackTable* trackTable,
+    TrackChangeDetector* changeDetector,
+    int64_t timestampUs,
+    int64_t durationUs,
+    int64_t maxExtrapolationUs)
+{
+    NX_PROFILE_ZONE("packet build");
+    const AllocationScope allocationScope("packet build");
+    m_objectBoxes.clear();
+    const bool isFullRefresh = changeDetector->startPacket(timestampUs);
+    trackTable->forEach(
+        [&](TrackTable::Track* track)
+        {
+            // The camera box for this very moment has already been sent.
+            if (track->newestSample().timestampUs == timestampUs
+                && !track->pending
+                && !isFullRefresh)
+            {
+                return;
+            }
+            Rect box;
+            if (!TrackTable::predict(*track, timestampUs, maxExtrapolationUs, &box))
+            {
+                return;
+            }
+            if (!isFullRefresh && !changeDetector->hasChanged(*track, box, timestampUs))
+            {
+                trackTable->setSkipped(track);
+                return;
+            }
+            addObjectBox(*track, box);
+            trackTable->setEmitted(track, timestampUs, box);
+        });
+
+    return finishPacket(timestampUs, durationUs);
+}
+
+void MetadataPacketBuilder::addObjectBox(const TrackTable::Track& track, const Rect& box)
+{
+    ObjectBox objectBox;
+    objectBox.typeId = track.typeId->c_str();
+    objectBox.trackId = track.trackId;
+    objectBox.boundingBox = box;
+    m_objectBoxes.push_back(objectBox);
+}
+
+Ptr<IMetadataPacket> MetadataPacketBuilder::finishPacket(int64_t timestampUs, int64_t durationUs)
+{
+    if (m_objectBoxes.empty())
+    {
+        return nullptr;
+    }
+
+    // The items are built in place from the collected boxes, with a single reservation.
+    auto metadataPacket = m_objectMetadataPool.makeObjectMetadataPacket();
+    metadataPacket->setTimestampUs(timestampUs);
+    metadataPacket->setDurationUs(durationUs);
+    metadataPacket->addItems(
+        m_objectBoxes.data(), (int) m_objectBoxes.size(), &m_objectMetadataPool);
+    return metadataPacket;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
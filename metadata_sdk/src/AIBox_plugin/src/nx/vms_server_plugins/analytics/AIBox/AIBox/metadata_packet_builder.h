@@ -0,0 +1,70 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <nx/sdk/analytics/helpers/pooled_object_metadata.h>
+#include <nx/sdk/analytics/i_metadata_packet.h>
+#include <nx/sdk/ptr.h>
+
+#include "track_change_detector.h"
+#include "track_table.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Builds the object metadata packets of the tracks, marking the tracks as sent or skipped in the
+ * track table. The boxes are collected into the storage reused from packet to packet, and then
+ * added to the packet in bulk, built of the pooled objects.
+ *
+ * Not thread-safe - the owner is expected to guard it together with the track table.
+ */
+class MetadataPacketBuilder
+{
+public:
+    /**
+     * Of the tracks updated by the camera since they were last sent, the ones which the change
+     * detector considers changed; all the tracks if a full refresh is due.
+     * @return Null if there are no tracks to send.
+     */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> buildPendingPacket(
+        TrackTable* trackTable,
+        TrackChangeDetector* changeDetector,
+        int64_t timestampUs,
+        int64_t durationUs);
+
+    /**
+     * The boxes of the tracks predicted for the given moment; the tracks not updated by the camera
+     * for longer than maxExtrapolationUs are left out.
+     * @return Null if there are no tracks to send.
+     */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> buildInterpolatedPacket(
+        TrackTable* trackTable,
+        TrackChangeDetector* changeDetector,
+        int64_t timestampUs,
+        int64_t durationUs,
+        int64_t maxExtrapolationUs);
+
+private:
+    void addObjectBox(const TrackTable::Track& track, const nx::sdk::analytics::Rect& box);
+
+    /** @return Packet of the boxes collected by addObjectBox(), or null if there are none. */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> finishPacket(
+        int64_t timestampUs, int64_t durationUs);
+
+private:
+    std::vector<nx::sdk::analytics::ObjectBox> m_objectBoxes;
+
+    /** The packets may outlive the builder; then they are freed when the Server drops them. */
+    nx::sdk::analytics::ObjectMetadataPool m_objectMetadataPool;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,27 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "metadata_rate_governor.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+void MetadataRateGovernor::setMaxPacketsPerSecond(int maxPacketsPerSecond)
+{
+    m_minIntervalUs = (maxPacketsPerSecond > 0) ? (1000000LL / maxPacketsPerSecond) : 0;
+}
+
+bool MetadataRateGovernor::tryAcquire(int64_t nowUs)
+{
+    if (isLimited() && m_lastPacketUs != 0 && nowUs - m_lastPacketUs < m_minIntervalUs)
+        return false;
+
+    m_lastPacketUs = nowUs;
+    return true;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
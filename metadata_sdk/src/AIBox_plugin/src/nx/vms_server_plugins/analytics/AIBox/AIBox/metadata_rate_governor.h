@@ -0,0 +1,47 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Limits the rate of the metadata packets a DeviceAgent sends to the Server. The updates which
+ * are not allowed to be sent immediately are expected to be merged by the caller and sent with
+ * the next allowed packet.
+ *
+ * Not thread-safe - the owner is expected to guard it.
+ */
+class MetadataRateGovernor
+{
+public:
+    /** @param maxPacketsPerSecond 0 means unlimited. */
+    void setMaxPacketsPerSecond(int maxPacketsPerSecond);
+
+    bool isLimited() const { return m_minIntervalUs > 0; }
+
+    /**
+     * @return Whether a packet may be sent at the given moment; if so, the moment is remembered
+     *     as the time of the last sent packet.
+     */
+    bool tryAcquire(int64_t nowUs);
+
+    /**
+     * @return Duration to assign to a sent packet, so that its boxes persist on the screen until
+     *     the next packet, or -1 if the rate is unlimited.
+     */
+    int64_t packetDurationUs() const { return isLimited() ? m_minIntervalUs : -1; }
+
+private:
+    int64_t m_minIntervalUs = 0;
+    int64_t m_lastPacketUs = 0;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,244 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+#include <nx/kit/debug.h>
+#include <nx/kit/json.h>
+#include <nx/kit/mutex.h>
+
+#include "allocation_tracker.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+void LatencyHistogram::record(int64_t valueUs)
+{
+    valueUs = std::max(valueUs, (int64_t) 0);
+    m_buckets[Buckets::bucketOf((uint64_t) valueUs)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    int64_t maxUs = m_maxUs.load(std::memory_order_relaxed);
+    while (valueUs > maxUs
+        && !m_maxUs.compare_exchange_weak(maxUs, valueUs, std::memory_order_relaxed))
+    {
+    }
+}
+
+int64_t LatencyHistogram::percentileUs(int percent) const
+{
+    std::array<uint64_t, Buckets::kBucketCount> counts;
+    for (int i = 0; i < Buckets::kBucketCount; ++i)
+    {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    const int bucket = Buckets::percentileBucket(counts.data(), percent / 100.0);
+    return (bucket < 0) ? 0 : (int64_t) Buckets::bucketLowerBound(bucket);
+}
+
+Metrics& Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+std::atomic<int64_t>& Metrics::value(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& value = m_values[name];
+    if (!value)
+    {
+        value = std::make_unique<std::atomic<int64_t>>(0);
+    }
+    return *value;
+}
+
+LatencyHistogram& Metrics::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& histogram = m_histograms[name];
+    if (!histogram)
+    {
+        histogram = std::make_unique<LatencyHistogram>();
+    }
+    return *histogram;
+}
+
+template<typename Map>
+static void eraseByPrefix(Map* map, const std::string& namePrefix)
+{
+    auto it = map->lower_bound(namePrefix);
+    while (it != map->end() && it->first.compare(0, namePrefix.size(), namePrefix) == 0)
+    {
+        it = map->erase(it);
+    }
+}
+
+void Metrics::removeAll(const std::string& namePrefix)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    eraseByPrefix(&m_values, namePrefix);
+    eraseByPrefix(&m_histograms, namePrefix);
+}
+
+int Metrics::addPublisher(std::function<void()> publisher)
+{
+    std::lock_guard<std::mutex> lock(m_publishersMutex);
+    const int id = ++m_lastPublisherId;
+    m_publishers.emplace(id, std::move(publisher));
+    return id;
+}
+
+void Metrics::removePublisher(int id)
+{
+    std::lock_guard<std::mutex> lock(m_publishersMutex);
+    m_publishers.erase(id);
+}
+
+std::string Metrics::toJson() const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_publishersMutex);
+        for (const auto& entry: m_publishers)
+        {
+            entry.second();
+        }
+    }
+
+    nx::kit::Json::object values;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& entry: m_values)
+        {
+            // Json keeps numbers as double, which is exact for any practical metric value.
+            values[entry.first] = (double) entry.second->load(std::memory_order_relaxed);
+        }
+        for (const auto& entry: m_histograms)
+        {
+            const LatencyHistogram& histogram = *entry.second;
+            values[entry.first] = nx::kit::Json::object{
+                {"count", (double) histogram.count()},
+                {"p50", (double) histogram.percentileUs(50)},
+                {"p90", (double) histogram.percentileUs(90)},
+                {"p99", (double) histogram.percentileUs(99)},
+                {"max", (double) histogram.maxUs()},
+            };
+        }
+    }
+    if (nx::kit::isLockProfilingEnabled())
+    {
+        for (const nx::kit::LockProfile& profile: nx::kit::lockProfile())
+        {
+            values["lock." + profile.name] = nx::kit::Json::object{
+                {"count", (double) profile.acquisitionCount},
+                {"contended", (double) profile.contentionCount},
+                {"waitUs", (double) profile.waitUs},
+                {"maxWaitUs", (double) profile.maxWaitUs},
+                {"holdUs", (double) profile.holdUs},
+                {"maxHoldUs", (double) profile.maxHoldUs},
+            };
+        }
+    }
+    if (AllocationTracker::isEnabled())
+    {
+        const int64_t messageCount = AllocationTracker::messageCount();
+        values["alloc.messages"] = (double) messageCount;
+        for (const AllocationTracker::TagCounts& counts: AllocationTracker::counts())
+        {
+            values["alloc." + counts.tag] = nx::kit::Json::object{
+                {"count", (double) counts.allocationCount},
+                {"bytes", (double) counts.byteCount},
+                {"perMessage", messageCount > 0
+                    ? (double) counts.allocationCount / messageCount
+                    : 0.0},
+            };
+        }
+    }
+    return nx::kit::Json(values).dump();
+}
+
+MetricsReporter::MetricsReporter(int intervalMs):
+    m_intervalMs(intervalMs),
+    m_thread([this]() { run(); })
+{
+}
+
+MetricsReporter::~MetricsReporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+}
+
+void MetricsReporter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wakeUp.wait_for(
+        lock, std::chrono::milliseconds(m_intervalMs), [this]() { return m_stopped; }))
+    {
+        NX_PRINT << "Metrics: " << Metrics::instance().toJson();
+    }
+}
+
+ProfileReporter::ProfileReporter(int intervalMs, std::string filePath):
+    m_intervalMs(intervalMs),
+    m_filePath(std::move(filePath)),
+    m_thread([this]() { run(); })
+{
+    NX_PRINT << "Profile is written to " << m_filePath;
+}
+
+ProfileReporter::~ProfileReporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+    writeReport();
+}
+
+void ProfileReporter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wakeUp.wait_for(
+        lock, std::chrono::milliseconds(m_intervalMs), [this]() { return m_stopped; }))
+    {
+        writeReport();
+    }
+}
+
+void ProfileReporter::writeReport() const
+{
+    // Written to a temporary file first, so that a reader never sees a partial report.
+    const std::string tempFilePath = m_filePath + ".tmp";
+    {
+        std::ofstream file(tempFilePath, std::ios::trunc);
+        if (!file.good())
+        {
+            NX_PRINT << "Unable to write the profile to " << tempFilePath;
+            return;
+        }
+        file << nx::kit::debug::profileReport();
+        if (nx::kit::isLockProfilingEnabled())
+        {
+            file << "\n" << nx::kit::lockProfileReport();
+        }
+    }
+    std::rename(tempFilePath.c_str(), m_filePath.c_str());
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
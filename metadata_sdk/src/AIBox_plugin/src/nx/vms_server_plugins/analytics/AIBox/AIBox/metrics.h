@@ -0,0 +1,148 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Lock-free histogram of durations, with the log-linear buckets of
+ * nx::kit::debug::LogLinearHistogram, so that a percentile is known to within 1/8.
+ */
+class LatencyHistogram
+{
+public:
+    /** Negative values are counted as 0. */
+    void record(int64_t valueUs);
+
+    int64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    int64_t maxUs() const { return m_maxUs.load(std::memory_order_relaxed); }
+
+    /** @return Lower bound of the bucket holding the percentile, or 0 if there are no values. */
+    int64_t percentileUs(int percent) const;
+
+private:
+    using Buckets = nx::kit::debug::LogLinearHistogram;
+
+    std::array<std::atomic<uint64_t>, Buckets::kBucketCount> m_buckets{};
+    std::atomic<int64_t> m_count{0};
+    std::atomic<int64_t> m_maxUs{0};
+};
+
+/**
+ * Process-wide registry of named integer metrics - gauges and counters - of the plugin. The
+ * Analytics SDK has no metrics API, so the metrics are published by MetricsReporter to the log.
+ *
+ * The names are dot-separated, e.g. "device.<deviceId>#<agentIndex>.subscriptionState". Updating
+ * a metric is a single atomic operation on the value obtained once via value().
+ */
+class Metrics
+{
+public:
+    static Metrics& instance();
+
+    /**
+     * Creates the metric on first use.
+     * @return Reference valid until the metric is removed.
+     */
+    std::atomic<int64_t>& value(const std::string& name);
+
+    /**
+     * Creates the histogram on first use.
+     * @return Reference valid until the histogram is removed.
+     */
+    LatencyHistogram& histogram(const std::string& name);
+
+    /** Removes all the metrics and histograms whose names start with the prefix. */
+    void removeAll(const std::string& namePrefix);
+
+    /**
+     * Registers a function updating some metrics from the state they are derived from, called
+     * whenever the metrics are read, so that such metrics are never older than the reading.
+     * @return Id for removePublisher().
+     */
+    int addPublisher(std::function<void()> publisher);
+
+    /** After it returns, the publisher is not being called and will not be called anymore. */
+    void removePublisher(int id);
+
+    /**
+     * Calls the publishers, and then collects the metrics.
+     * @return JSON object: name -> value, or name -> {count, p50, p90, p99, max} for histograms.
+     *     With the lock profiling enabled, also "lock.<name>" -> nx::kit::LockProfile fields.
+     *     With the allocation tracking, also "alloc.<tag>" -> {count, bytes, perMessage}.
+     */
+    std::string toJson() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<std::atomic<int64_t>>> m_values;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> m_histograms;
+
+    /** Held while the publishers are called, so that they can take m_mutex. */
+    mutable std::mutex m_publishersMutex;
+    std::map<int, std::function<void()>> m_publishers;
+    int m_lastPublisherId = 0;
+};
+
+/** Logs all the Metrics periodically, on its own thread. */
+class MetricsReporter
+{
+public:
+    explicit MetricsReporter(int intervalMs);
+    ~MetricsReporter();
+
+private:
+    void run();
+
+private:
+    const int m_intervalMs;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_stopped = false;
+    std::thread m_thread;
+};
+
+/**
+ * Writes the nx_kit profiler report, and the lock profile if enabled, to a file periodically, on
+ * its own thread, and once more on destruction, so that the profile of a running Server can be
+ * taken at any moment.
+ */
+class ProfileReporter
+{
+public:
+    ProfileReporter(int intervalMs, std::string filePath);
+    ~ProfileReporter();
+
+private:
+    void run();
+    void writeReport() const;
+
+private:
+    const int m_intervalMs;
+    const std::string m_filePath;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_stopped = false;
+    std::thread m_thread;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -18,6 +18,20 @@ namespace AIBox {
 using namespace nx::sdk;
 using namespace nx::sdk::analytics;
 
+Plugin::Plugin()
+{
+    // The camera I/O threads print on each reconnect and malformed message, so a misbehaving
+    // camera must not make them wait for the output.
+    nx::kit::debug::setAsyncOutput(ini().asyncOutput);
+    nx::kit::debug::setRateLimit(ini().maxLogLinesPerSecond);
+}
+
+Plugin::~Plugin()
+{
+    // Writes the pending lines while the library is still loaded.
+    nx::kit::debug::setAsyncOutput(false);
+}
+
 Result<IEngine*> Plugin::doObtainEngine()
 {
     auto engine = new Engine();
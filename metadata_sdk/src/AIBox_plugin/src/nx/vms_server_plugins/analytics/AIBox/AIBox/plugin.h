@@ -12,6 +12,10 @@ namespace AIBox {
 
 class Plugin: public nx::sdk::analytics::Plugin
 {
+public:
+    Plugin();
+    virtual ~Plugin() override;
+
 protected:
     virtual nx::sdk::Result<nx::sdk::analytics::IEngine*> doObtainEngine() override;
     virtual std::string manifestString() const override;
@@ -0,0 +1,144 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "reactor_monitor.h"
+
+#include <nx/kit/debug.h>
+#include <nx/kit/utils.h>
+
+#include "ini.h"
+#include "metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+ReactorMonitor::ReactorMonitor(int64_t stallThresholdUs, const std::string& metricsPrefix):
+    m_stallThresholdUs(stallThresholdUs),
+    m_metricsPrefix(metricsPrefix),
+    m_probeLagUs(Metrics::instance().histogram(metricsPrefix + "probeLagUs")),
+    m_stallCount(Metrics::instance().value(metricsPrefix + "stalls")),
+    m_slowHandlerCount(Metrics::instance().value(metricsPrefix + "slowHandlers"))
+{
+}
+
+ReactorMonitor& ReactorMonitor::instance()
+{
+    static ReactorMonitor monitor(ini().reactorStallThresholdMs * 1000LL, "reactor.");
+    return monitor;
+}
+
+int ReactorMonitor::addStallHandler(StallHandler handler)
+{
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    const int id = ++m_lastStallHandlerId;
+    m_stallHandlers.emplace(id, std::move(handler));
+    return id;
+}
+
+void ReactorMonitor::removeStallHandler(int id)
+{
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    m_stallHandlers.erase(id);
+}
+
+void ReactorMonitor::reportProbeLag(int64_t lagUs, int64_t nowUs)
+{
+    m_probeLagUs.record(lagUs);
+    if (m_stallThresholdUs <= 0 || lagUs <= m_stallThresholdUs)
+    {
+        return;
+    }
+
+    m_stallCount.fetch_add(1, std::memory_order_relaxed);
+    reportStall(
+        nx::kit::utils::format(
+            "Camera I/O thread was blocked for %lld ms", (long long) (lagUs / 1000)),
+        nowUs);
+}
+
+void ReactorMonitor::reportHandler(const char* tag, int64_t durationUs, int64_t nowUs)
+{
+    if (m_stallThresholdUs <= 0 || durationUs <= m_stallThresholdUs)
+    {
+        return;
+    }
+
+    m_slowHandlerCount.fetch_add(1, std::memory_order_relaxed);
+    Metrics::instance().value(m_metricsPrefix + "slowHandler." + tag)
+        .fetch_add(1, std::memory_order_relaxed);
+    reportStall(
+        nx::kit::utils::format(
+            "Camera I/O handler %s has run for %lld ms", tag, (long long) (durationUs / 1000)),
+        nowUs);
+}
+
+void ReactorMonitor::reportStall(const std::string& description, int64_t nowUs)
+{
+    // The stalls tend to come in bursts; the Server needs to know only that they happen. Nor is
+    // each of them logged: the log would be written on the very thread which is stalled.
+    int64_t lastReportUs = m_lastReportUs.load(std::memory_order_relaxed);
+    do
+    {
+        if (lastReportUs != 0 && nowUs - lastReportUs < kMinReportIntervalUs)
+        {
+            return;
+        }
+    } while (!m_lastReportUs.compare_exchange_weak(
+        lastReportUs, nowUs, std::memory_order_relaxed));
+
+    // This stall has been counted by the caller.
+    const int64_t stallCount = m_stallCount.load(std::memory_order_relaxed)
+        + m_slowHandlerCount.load(std::memory_order_relaxed);
+    const int64_t suppressedCount =
+        stallCount - m_reportedStallCount.exchange(stallCount, std::memory_order_relaxed) - 1;
+    const std::string report = (suppressedCount > 0)
+        ? nx::kit::utils::format("%s; %lld more stall(s) since the previous report",
+            description.c_str(), (long long) suppressedCount)
+        : description;
+    NX_PRINT << report;
+
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    for (const auto& entry: m_stallHandlers)
+    {
+        entry.second(report);
+    }
+}
+
+ReactorProbe::ReactorProbe(asio::io_context& ioContext, int intervalMs):
+    m_interval(intervalMs),
+    m_timer(ioContext)
+{
+    if (intervalMs > 0)
+    {
+        m_timer.expires_after(m_interval);
+        schedule();
+    }
+}
+
+void ReactorProbe::schedule()
+{
+    m_timer.async_wait(
+        [this](const asio::error_code& error)
+        {
+            if (error)
+            {
+                return;
+            }
+            const auto now = asio::steady_timer::clock_type::now();
+            ReactorMonitor::instance().reportProbeLag(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - m_timer.expiry()).count(),
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    now.time_since_epoch()).count());
+
+            // From the actual moment, so that a stall is not followed by a burst of probes.
+            m_timer.expires_at(now + m_interval);
+            schedule();
+        });
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
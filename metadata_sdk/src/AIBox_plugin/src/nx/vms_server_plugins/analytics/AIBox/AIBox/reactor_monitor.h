@@ -0,0 +1,138 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <asio.hpp>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+class LatencyHistogram;
+
+/**
+ * Watches the I/O threads (reactors) of the camera connections. A handler blocking a reactor,
+ * e.g. in a synchronous resolve, in a slow Server metadata handler or in a log flood, silently
+ * stalls every connection served by this reactor.
+ *
+ * The stalls are found in two ways: each reactor runs a ReactorProbe measuring how late its timer
+ * is dispatched, and the handlers are measured by ReactorHandlerScope, which names the slow ones
+ * by their call-site tags. Both are counted in Metrics under "reactor.", and logged and reported
+ * to the stall handlers at most once per kMinReportIntervalUs, with the number of the stalls
+ * suppressed since the previous report.
+ */
+class ReactorMonitor
+{
+public:
+    using StallHandler = std::function<void(const std::string& description)>;
+
+    static constexpr int64_t kMinReportIntervalUs = 10'000'000;
+
+    /** The monitor of the plugin reactors, with the threshold from the ini. */
+    static ReactorMonitor& instance();
+
+    /**
+     * @param stallThresholdUs 0 disables the stall reports.
+     * @param metricsPrefix Prefix of the names of the metrics, e.g. "reactor.".
+     */
+    ReactorMonitor(int64_t stallThresholdUs, const std::string& metricsPrefix);
+
+    /**
+     * Each of the registered handlers receives each stall report, so that every Engine can
+     * forward the reports to the Server.
+     * @return Id for removeStallHandler().
+     */
+    int addStallHandler(StallHandler handler);
+
+    /** After it returns, the handler is not being called and will not be called anymore. */
+    void removeStallHandler(int id);
+
+    /** The probe of a reactor has been dispatched this late. */
+    void reportProbeLag(int64_t lagUs, int64_t nowUs);
+
+    /** The handler with the given call-site tag has run for this time. */
+    void reportHandler(const char* tag, int64_t durationUs, int64_t nowUs);
+
+private:
+    void reportStall(const std::string& description, int64_t nowUs);
+
+private:
+    const int64_t m_stallThresholdUs;
+    const std::string m_metricsPrefix;
+    LatencyHistogram& m_probeLagUs;
+    std::atomic<int64_t>& m_stallCount;
+    std::atomic<int64_t>& m_slowHandlerCount;
+    std::atomic<int64_t> m_lastReportUs{0};
+
+    /** The sum of both stall counters as of the previous report. */
+    std::atomic<int64_t> m_reportedStallCount{0};
+
+    std::mutex m_handlerMutex;
+    std::map<int, StallHandler> m_stallHandlers;
+    int m_lastStallHandlerId = 0;
+};
+
+/**
+ * Measures the dispatch delay of an io_context: a timer expires periodically, and the difference
+ * between the expiry and the moment its handler runs is how long the reactor was busy.
+ *
+ * Must be destroyed only after the io_context has stopped running its handlers.
+ */
+class ReactorProbe
+{
+public:
+    /** @param intervalMs 0 disables the probe. */
+    ReactorProbe(asio::io_context& ioContext, int intervalMs);
+
+    ReactorProbe(const ReactorProbe&) = delete;
+    ReactorProbe& operator=(const ReactorProbe&) = delete;
+
+private:
+    void schedule();
+
+private:
+    const std::chrono::milliseconds m_interval;
+    asio::steady_timer m_timer;
+};
+
+/** Measures the reactor handler it is created in; the tag names the call site. */
+class ReactorHandlerScope
+{
+public:
+    /** @param tag String literal. */
+    explicit ReactorHandlerScope(const char* tag):
+        m_tag(tag),
+        m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ReactorHandlerScope()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        ReactorMonitor::instance().reportHandler(
+            m_tag,
+            std::chrono::duration_cast<std::chrono::microseconds>(now - m_start).count(),
+            std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+    }
+
+    ReactorHandlerScope(const ReactorHandlerScope&) = delete;
+    ReactorHandlerScope& operator=(const ReactorHandlerScope&) = delete;
+
+private:
+    const char* const m_tag;
+    const std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
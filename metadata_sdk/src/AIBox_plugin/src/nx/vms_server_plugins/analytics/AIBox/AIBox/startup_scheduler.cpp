@@ -0,0 +1,81 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "startup_scheduler.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+StartupScheduler::StartupScheduler(int maxStartsPerSecond, int maxConcurrentStarts):
+    m_interval((maxStartsPerSecond > 0)
+        ? std::chrono::duration_cast<Clock::duration>(
+            std::chrono::microseconds(1000000 / maxStartsPerSecond))
+        : Clock::duration::zero()),
+    m_maxConcurrentStarts(maxConcurrentStarts)
+{
+}
+
+bool StartupScheduler::admit(int priority, const std::function<bool()>& isCancelled)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const Waiter waiter{priority, m_nextSequence++};
+    m_waiters.insert(waiter);
+
+    for (;;)
+    {
+        if (isCancelled())
+        {
+            m_waiters.erase(waiter);
+            m_wakeUp.notify_all(); //< The next waiter may become the first one.
+            return false;
+        }
+
+        const bool isFirst = !(*m_waiters.begin() < waiter) && !(waiter < *m_waiters.begin());
+        const bool hasFreeSlot =
+            m_maxConcurrentStarts <= 0 || m_runningStarts < m_maxConcurrentStarts;
+        if (isFirst && hasFreeSlot)
+        {
+            const Clock::time_point now = Clock::now();
+            if (now >= m_nextAdmissionTime)
+            {
+                // The bucket holds a single token, and unused admissions do not accumulate: even
+                // the first admissions, or a burst after a quiet period, are spaced by the
+                // interval.
+                m_nextAdmissionTime = std::max(m_nextAdmissionTime, now) + m_interval;
+                ++m_runningStarts;
+                m_waiters.erase(waiter);
+                m_wakeUp.notify_all();
+                return true;
+            }
+            m_wakeUp.wait_until(lock, m_nextAdmissionTime);
+            continue;
+        }
+        m_wakeUp.wait(lock);
+    }
+}
+
+void StartupScheduler::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_runningStarts;
+    }
+    m_wakeUp.notify_all();
+}
+
+void StartupScheduler::wakeUpAll()
+{
+    {
+        // Makes sure the waiters are either waiting, or will check the cancellation.
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_wakeUp.notify_all();
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,78 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Admits the new camera connections at a limited rate and concurrency, so that the burst of
+ * DeviceAgents created on the Server start does not turn into a connection storm. The waiting
+ * connections are admitted in the order of their priority, then in the order of arrival. The
+ * first connection is admitted at once, and each next one not earlier than 1/maxStartsPerSecond
+ * after the previous one.
+ *
+ * The callers block in admit(), so it is expected to be called on a thread which can wait.
+ */
+class StartupScheduler
+{
+public:
+    /**
+     * @param maxStartsPerSecond 0 means unlimited.
+     * @param maxConcurrentStarts 0 means unlimited.
+     */
+    StartupScheduler(int maxStartsPerSecond, int maxConcurrentStarts);
+
+    /**
+     * Blocks until the caller's turn. On success, finish() must be called when the connection
+     * has been established or has failed.
+     * @param isCancelled Checked on wakeUpAll(); if it returns true, admit() gives up.
+     * @return False if cancelled.
+     */
+    bool admit(int priority, const std::function<bool()>& isCancelled);
+
+    void finish();
+
+    /** Makes the waiting callers re-check their cancellation. */
+    void wakeUpAll();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiter
+    {
+        int priority = 0;
+        uint64_t sequence = 0;
+
+        bool operator<(const Waiter& other) const
+        {
+            if (priority != other.priority)
+                return priority > other.priority;
+            return sequence < other.sequence;
+        }
+    };
+
+    const Clock::duration m_interval;
+    const int m_maxConcurrentStarts;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::set<Waiter> m_waiters;
+    uint64_t m_nextSequence = 0;
+    int m_runningStarts = 0;
+    Clock::time_point m_nextAdmissionTime;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,58 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "stream_health_tracker.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+static int64_t steadyClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+StreamHealthTracker::StreamHealthTracker(const std::string& metricsPrefix):
+    m_fpsMetric(Metrics::instance().value(metricsPrefix + "fps")),
+    m_bitrateBpsMetric(Metrics::instance().value(metricsPrefix + "bitrateBps")),
+    m_gopFramesMetric(Metrics::instance().value(metricsPrefix + "gopFrames"))
+{
+    m_publisherId = Metrics::instance().addPublisher([this]() { publish(steadyClockUs()); });
+}
+
+StreamHealthTracker::~StreamHealthTracker()
+{
+    Metrics::instance().removePublisher(m_publisherId);
+}
+
+void StreamHealthTracker::onData(int64_t timestampUs, size_t sizeBytes, bool isKeyFrame)
+{
+    m_statistics.onData(std::chrono::microseconds(timestampUs), sizeBytes, isKeyFrame);
+}
+
+void StreamHealthTracker::publish(int64_t nowUs)
+{
+    if (m_statistics.isStale(std::chrono::microseconds(nowUs)))
+    {
+        m_fpsMetric.store(0, std::memory_order_relaxed);
+        m_bitrateBpsMetric.store(0, std::memory_order_relaxed);
+        m_gopFramesMetric.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    m_fpsMetric.store(std::lround(m_statistics.getFrameRate()), std::memory_order_relaxed);
+    m_bitrateBpsMetric.store(m_statistics.bitrateBitsPerSecond(), std::memory_order_relaxed);
+    m_gopFramesMetric.store(
+        std::lround(m_statistics.getAverageGopSize()), std::memory_order_relaxed);
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,65 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <nx/sdk/helpers/media_stream_statistics.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Keeps the rate statistics of a stream - the video frames from the Server, or the messages from
+ * the camera - and publishes them to Metrics as "<prefix>fps", "<prefix>bitrateBps" and
+ * "<prefix>gopFrames". The statistics are O(1) per item and lock-free, so it can be fed on the
+ * hot path.
+ *
+ * The metrics are published by the reader side - a Metrics publisher, called whenever the metrics
+ * are read - rather than by onData(), so that a stream which has stopped shows up as such: once
+ * the statistics are stale - no item within their window - all the metrics are published as 0.
+ *
+ * Must be fed by one thread at a time; the statistics can be read from any thread.
+ */
+class StreamHealthTracker
+{
+public:
+    /** @param metricsPrefix E.g. "device.<deviceId>#<agentIndex>.video.". */
+    explicit StreamHealthTracker(const std::string& metricsPrefix);
+    ~StreamHealthTracker();
+
+    StreamHealthTracker(const StreamHealthTracker&) = delete;
+    StreamHealthTracker& operator=(const StreamHealthTracker&) = delete;
+
+    /**
+     * @param timestampUs Stream time of the item.
+     * @param isKeyFrame For the streams without key frames, false.
+     */
+    void onData(int64_t timestampUs, size_t sizeBytes, bool isKeyFrame);
+
+    /**
+     * Updates the metrics; called by the Metrics publisher, may be called from any thread.
+     * @param nowUs Steady clock.
+     */
+    void publish(int64_t nowUs);
+
+    const nx::sdk::MediaStreamStatistics& statistics() const { return m_statistics; }
+
+private:
+    nx::sdk::MediaStreamStatistics m_statistics;
+
+    std::atomic<int64_t>& m_fpsMetric;
+    std::atomic<int64_t>& m_bitrateBpsMetric;
+    std::atomic<int64_t>& m_gopFramesMetric;
+    int m_publisherId = 0;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
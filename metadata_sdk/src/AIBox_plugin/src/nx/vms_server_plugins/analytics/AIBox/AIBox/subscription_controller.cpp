@@ -0,0 +1,182 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "subscription_controller.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+SubscriptionController::SubscriptionController(
+    TimerQueue* timerQueue,
+    std::function<bool()> startSubscription,
+    std::function<void()> stopSubscription,
+    int64_t gracePeriodMs,
+    int64_t minRetryDelayMs,
+    int64_t maxRetryDelayMs)
+    :
+    m_timerQueue(timerQueue),
+    m_startSubscription(std::move(startSubscription)),
+    m_stopSubscription(std::move(stopSubscription)),
+    m_gracePeriod(gracePeriodMs),
+    m_minRetryDelay(std::max<int64_t>(minRetryDelayMs, 1)),
+    m_maxRetryDelay(std::max<int64_t>(maxRetryDelayMs, minRetryDelayMs)),
+    m_retryDelay(m_minRetryDelay)
+{
+}
+
+SubscriptionController::~SubscriptionController()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopped = true;
+    }
+
+    // Waits for the running step; after that, no step runs anymore.
+    m_timerQueue->cancel(this);
+
+    if (m_isStarted)
+    {
+        m_stopSubscription();
+        setState(State::idle);
+    }
+}
+
+void SubscriptionController::setStateChangedHandler(std::function<void(State)> handler)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stateChangedHandler = std::move(handler);
+}
+
+void SubscriptionController::setNeeded(bool isNeeded)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (isNeeded == m_isNeeded)
+    {
+        return;
+    }
+    m_isNeeded = isNeeded;
+    schedule(Clock::duration::zero());
+}
+
+void SubscriptionController::setPriority(int priority)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_priority = priority;
+}
+
+void SubscriptionController::setState(State state)
+{
+    m_state.store(state, std::memory_order_relaxed);
+    if (m_stateChangedHandler)
+    {
+        m_stateChangedHandler(state);
+    }
+}
+
+void SubscriptionController::schedule(Clock::duration delay)
+{
+    m_timerQueue->post(this, delay, m_priority, [this]() { run(); });
+}
+
+void SubscriptionController::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Another thread of the queue may be in the middle of a blocking start or stop.
+    if (m_isRunning)
+    {
+        m_isRunPending = true;
+        return;
+    }
+
+    m_isRunning = true;
+    do
+    {
+        m_isRunPending = false;
+        step(lock);
+    } while (m_isRunPending && !m_isStopped);
+    m_isRunning = false;
+}
+
+void SubscriptionController::step(std::unique_lock<std::mutex>& lock)
+{
+    if (m_isStopped)
+    {
+        return;
+    }
+
+    const Clock::time_point now = Clock::now();
+    if (m_isNeeded && !m_isActive)
+    {
+        if (now < m_retryTime)
+        {
+            schedule(m_retryTime - now);
+            return;
+        }
+
+        lock.unlock();
+        const bool isStartSuccessful = m_startSubscription();
+        lock.lock();
+        m_isStarted = true;
+        if (isStartSuccessful)
+        {
+            m_isActive = true;
+            m_retryDelay = m_minRetryDelay;
+            setState(State::active);
+        }
+        else
+        {
+            m_retryTime = Clock::now() + m_retryDelay;
+            m_retryDelay = std::min(m_retryDelay * 2, m_maxRetryDelay);
+            setState(State::failed);
+        }
+
+        // The demand may have changed during the start.
+        m_isRunPending = true;
+        return;
+    }
+
+    if (!m_isNeeded && m_isStarted)
+    {
+        // A failed subscription is not worth keeping for the grace period.
+        if (m_isActive)
+        {
+            if (state() != State::gracePeriod)
+            {
+                m_gracePeriodEnd = now + m_gracePeriod;
+                setState(State::gracePeriod);
+            }
+            if (now < m_gracePeriodEnd)
+            {
+                schedule(m_gracePeriodEnd - now);
+                return;
+            }
+        }
+
+        lock.unlock();
+        m_stopSubscription();
+        lock.lock();
+        m_isStarted = false;
+        m_isActive = false;
+        m_retryDelay = m_minRetryDelay;
+        m_retryTime = Clock::time_point();
+        setState(State::idle);
+
+        // The demand may have changed during the stop.
+        m_isRunPending = true;
+        return;
+    }
+
+    if (m_isNeeded && state() == State::gracePeriod)
+    {
+        setState(State::active);
+    }
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,107 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "timer_queue.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Drives the lifecycle of the camera subscription by demand: subscribes as soon as the metadata
+ * becomes needed, and unsubscribes when it has not been needed for the grace period, so that
+ * short gaps in the demand do not cause re-subscriptions.
+ *
+ * The subscription is started and stopped on the threads of a TimerQueue shared by all the
+ * controllers, because both may block for a while, and the demand changes come from the Server
+ * threads. A failed start is retried while the subscription is needed, with the delay doubling
+ * after each failure up to the maximum.
+ */
+class SubscriptionController
+{
+public:
+    enum class State: int
+    {
+        idle = 0,
+        active = 1,
+        gracePeriod = 2, /**< Still active, but not needed anymore. */
+        failed = 3, /**< Needed, but the last start has failed; to be retried. */
+    };
+
+    /**
+     * @param timerQueue Must outlive the controller.
+     * @param startSubscription Returns false if the subscription has failed to start; then it
+     *     is either started again after the retry delay, or stopped if not needed anymore.
+     * @param stopSubscription Called after each start, either successful or not.
+     */
+    SubscriptionController(
+        TimerQueue* timerQueue,
+        std::function<bool()> startSubscription,
+        std::function<void()> stopSubscription,
+        int64_t gracePeriodMs,
+        int64_t minRetryDelayMs,
+        int64_t maxRetryDelayMs);
+
+    /** Stops the subscription immediately if it is active. */
+    ~SubscriptionController();
+
+    void setNeeded(bool isNeeded);
+
+    /** The starts of the controllers with a higher priority are run first by the TimerQueue. */
+    void setPriority(int priority);
+
+    State state() const { return m_state.load(std::memory_order_relaxed); }
+
+    /** Called on a TimerQueue thread, or in the destructor, whenever the state changes. */
+    void setStateChangedHandler(std::function<void(State)> handler);
+
+private:
+    using Clock = TimerQueue::Clock;
+
+    /** Must be called with m_mutex locked. */
+    void schedule(Clock::duration delay);
+
+    /** Run by the TimerQueue; the steps of the controller do not run concurrently. */
+    void run();
+
+    /** Makes a single transition, if any is due. */
+    void step(std::unique_lock<std::mutex>& lock);
+
+    void setState(State state);
+
+private:
+    TimerQueue* const m_timerQueue;
+    const std::function<bool()> m_startSubscription;
+    const std::function<void()> m_stopSubscription;
+    const std::chrono::milliseconds m_gracePeriod;
+    const std::chrono::milliseconds m_minRetryDelay;
+    const std::chrono::milliseconds m_maxRetryDelay;
+    std::function<void(State)> m_stateChangedHandler;
+
+    std::atomic<State> m_state{State::idle};
+
+    std::mutex m_mutex;
+    bool m_isNeeded = false;
+    bool m_isStopped = false;
+    int m_priority = 0;
+    bool m_isRunning = false;
+    bool m_isRunPending = false; /**< Requested while running: the running one runs again. */
+    bool m_isStarted = false; /**< The start has been called, even if it has failed. */
+    bool m_isActive = false;
+    std::chrono::milliseconds m_retryDelay;
+    Clock::time_point m_retryTime;
+    Clock::time_point m_gracePeriodEnd;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
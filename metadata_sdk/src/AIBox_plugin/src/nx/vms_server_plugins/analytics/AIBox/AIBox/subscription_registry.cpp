@@ -0,0 +1,256 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "subscription_registry.h"
+
+#include <atomic>
+#include <vector>
+
+#include <nx/kit/debug.h>
+
+#include "ini.h"
+#include "metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/** With the unlimited concurrent starts, the starts beyond this wait for a thread. */
+static constexpr int kMaxTimerQueueStartThreads = 8;
+
+SubscriptionRegistry::SubscriptionRegistry(
+    int64_t lingerMs,
+    int maxStartsPerSecond,
+    int maxConcurrentStarts,
+    int connectTimeoutMs)
+    :
+    m_linger(lingerMs),
+    m_connectTimeoutMs(connectTimeoutMs),
+    m_startupScheduler(maxStartsPerSecond, maxConcurrentStarts),
+    // The admitted starts block while connecting; one more thread keeps the stops and the timers
+    // going meanwhile.
+    m_timerQueue(
+        (maxConcurrentStarts > 0 ? maxConcurrentStarts : kMaxTimerQueueStartThreads) + 1),
+    m_reaperThread([this]() { run(); })
+{
+}
+
+SubscriptionRegistry::~SubscriptionRegistry()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopped = true;
+    }
+    m_wakeUp.notify_one();
+    m_reaperThread.join();
+
+    // The sessions still in use are stopped by their DeviceAgents.
+    m_entries.clear();
+}
+
+std::shared_ptr<CameraSession> SubscriptionRegistry::acquire(
+    const std::string& host,
+    unsigned short port,
+    const std::string& subscribePath,
+    const std::string& basicAuth,
+    int priority,
+    const std::function<bool()>& isCancelled)
+{
+    const std::string key = host + ":" + std::to_string(port) + subscribePath + "|" + basicAuth;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (std::shared_ptr<CameraSession> session = acquireExisting(key, host, port))
+        {
+            return session;
+        }
+    }
+
+    std::atomic<int64_t>& queuedStarts = Metrics::instance().value("subscription.queuedStarts");
+    queuedStarts.fetch_add(1);
+    const bool isAdmitted = m_startupScheduler.admit(priority, isCancelled);
+    queuedStarts.fetch_sub(1);
+    if (!isAdmitted)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<CameraSession> session;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Another device of the endpoint may have connected while this one was waiting.
+        session = acquireExisting(key, host, port);
+        if (session)
+        {
+            m_startupScheduler.finish();
+            return session;
+        }
+
+        Entry& entry = m_entries[key];
+        entry.session = std::make_shared<CameraSession>(
+            key, host, port, subscribePath, basicAuth);
+        entry.useCount = 1;
+        session = entry.session;
+    }
+
+    session->start();
+    const bool isConnected = session->waitUntilConnected(m_connectTimeoutMs, isCancelled);
+    m_startupScheduler.finish();
+    if (!isConnected && isCancelled())
+    {
+        // Lingers, still connecting, for the next DeviceAgent of the endpoint.
+        release(session);
+        return nullptr;
+    }
+    if (!isConnected)
+    {
+        // The session keeps reconnecting on its own, but does not hold the startup slot anymore.
+        NX_OUTPUT << "Connection to " << host << ":" << port << " is not established in "
+            << m_connectTimeoutMs << " ms";
+        Metrics::instance().value("subscription.startTimeouts").fetch_add(1);
+    }
+    return session;
+}
+
+bool SubscriptionRegistry::reconnect(
+    const std::shared_ptr<CameraSession>& session,
+    int priority,
+    const std::function<bool()>& isCancelled)
+{
+    if (session->isConnected())
+    {
+        return true;
+    }
+
+    std::atomic<int64_t>& queuedStarts = Metrics::instance().value("subscription.queuedStarts");
+    queuedStarts.fetch_add(1);
+    const bool isAdmitted = m_startupScheduler.admit(priority, isCancelled);
+    queuedStarts.fetch_sub(1);
+    if (!isAdmitted)
+    {
+        return false;
+    }
+
+    session->start();
+    const bool isConnected = session->waitUntilConnected(m_connectTimeoutMs, isCancelled);
+    m_startupScheduler.finish();
+    if (!isConnected && !isCancelled())
+    {
+        NX_OUTPUT << "Reconnection is not established in " << m_connectTimeoutMs << " ms";
+        Metrics::instance().value("subscription.startTimeouts").fetch_add(1);
+    }
+    return isConnected;
+}
+
+void SubscriptionRegistry::wakeUpPendingAcquisitions()
+{
+    m_startupScheduler.wakeUpAll();
+
+    // The callers which have been admitted may be waiting for the connection of any session.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry: m_entries)
+    {
+        entry.second.session->wakeUpConnectWaiters();
+    }
+}
+
+std::shared_ptr<CameraSession> SubscriptionRegistry::acquireExisting(
+    const std::string& key, const std::string& host, unsigned short port)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+        return nullptr;
+    }
+
+    Entry& entry = it->second;
+    if (entry.useCount == 0)
+    {
+        NX_OUTPUT << "Reusing the lingering subscription to " << host << ":" << port;
+        Metrics::instance().value("subscription.reused").fetch_add(1);
+    }
+    else
+    {
+        NX_OUTPUT << "Sharing the subscription to " << host << ":" << port << " by "
+            << (entry.useCount + 1) << " devices";
+        Metrics::instance().value("subscription.shared").fetch_add(1);
+    }
+    ++entry.useCount;
+    return entry.session;
+}
+
+void SubscriptionRegistry::release(std::shared_ptr<CameraSession> session)
+{
+    if (!session)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(session->key());
+    if (!NX_KIT_ASSERT(it != m_entries.end() && it->second.session == session))
+    {
+        return;
+    }
+    Entry& entry = it->second;
+    if (--entry.useCount == 0)
+    {
+        entry.lingerDeadline = Clock::now() + m_linger;
+        m_wakeUp.notify_one();
+    }
+}
+
+void SubscriptionRegistry::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_isStopped)
+    {
+        const Clock::time_point now = Clock::now();
+        Clock::time_point nextDeadline = Clock::time_point::max();
+        std::vector<std::shared_ptr<CameraSession>> expiredSessions;
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            const Entry& entry = it->second;
+            if (entry.useCount == 0 && entry.lingerDeadline <= now)
+            {
+                expiredSessions.push_back(entry.session);
+                it = m_entries.erase(it);
+                continue;
+            }
+            if (entry.useCount == 0)
+            {
+                nextDeadline = std::min(nextDeadline, entry.lingerDeadline);
+            }
+            ++it;
+        }
+
+        if (!expiredSessions.empty())
+        {
+            // Stopping may block for a while.
+            lock.unlock();
+            for (const auto& session: expiredSessions)
+            {
+                NX_OUTPUT << "Stopping a subscription which nobody has acquired";
+                session->stop();
+            }
+            expiredSessions.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (nextDeadline == Clock::time_point::max())
+        {
+            m_wakeUp.wait(lock);
+        }
+        else
+        {
+            m_wakeUp.wait_until(lock, nextDeadline);
+        }
+    }
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
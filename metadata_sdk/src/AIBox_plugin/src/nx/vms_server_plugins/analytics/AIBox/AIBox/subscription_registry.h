@@ -0,0 +1,122 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "camera_session.h"
+#include "startup_scheduler.h"
+#include "timer_queue.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Engine-wide registry of the camera subscriptions, keyed by the physical endpoint: address and
+ * credentials. The DeviceAgents of all the devices behind the same endpoint share a single
+ * subscription, reference-counted by the registry.
+ *
+ * The Server re-creates DeviceAgents on settings changes, camera re-enabling, etc; a subscription
+ * released by all its DeviceAgents is kept alive for the linger period, and if a DeviceAgent of
+ * the endpoint acquires it meanwhile, it gets the live connection together with the track state,
+ * instead of reconnecting from scratch.
+ *
+ * The new connections are admitted by StartupScheduler, so that the DeviceAgents created in a
+ * burst on the Server start connect gradually; the existing sessions are handed out immediately.
+ *
+ * The SubscriptionControllers of all the DeviceAgents run on the TimerQueue of the registry, with
+ * enough threads for the starts which StartupScheduler admits concurrently.
+ */
+class SubscriptionRegistry
+{
+public:
+    SubscriptionRegistry(
+        int64_t lingerMs,
+        int maxStartsPerSecond,
+        int maxConcurrentStarts,
+        int connectTimeoutMs);
+
+    /** Stops all the lingering subscriptions. */
+    ~SubscriptionRegistry();
+
+    /**
+     * If there is no session of the endpoint, blocks until StartupScheduler admits a new one,
+     * and then until it connects or the connect timeout expires.
+     * @param priority Callers with a higher priority are admitted first.
+     * @param isCancelled Checked on wakeUpPendingAcquisitions(), both while waiting for the
+     *     admission and for the connection; the startup slot is freed on the cancellation.
+     * @return Either the existing session of the endpoint, or a new one; started in both cases.
+     *     Must be released via release(). Null if cancelled.
+     */
+    std::shared_ptr<CameraSession> acquire(
+        const std::string& host,
+        unsigned short port,
+        const std::string& subscribePath,
+        const std::string& basicAuth,
+        int priority,
+        const std::function<bool()>& isCancelled);
+
+    /**
+     * Makes a new connection attempt of an acquired session which is not connected, admitted the
+     * same way as a new session. Blocks like acquire().
+     * @return Whether the session is connected.
+     */
+    bool reconnect(
+        const std::shared_ptr<CameraSession>& session,
+        int priority,
+        const std::function<bool()>& isCancelled);
+
+    /** Makes the callers waiting in acquire() or reconnect() re-check their cancellation. */
+    void wakeUpPendingAcquisitions();
+
+    /** Shared by the SubscriptionControllers, which call acquire() and release() on it. */
+    TimerQueue& timerQueue() { return m_timerQueue; }
+
+    /**
+     * When the last user releases the session, it is stopped unless somebody acquires it during
+     * the linger period.
+     */
+    void release(std::shared_ptr<CameraSession> session);
+
+private:
+    /** Must be called with m_mutex locked. @return Null if there is no session of the key. */
+    std::shared_ptr<CameraSession> acquireExisting(
+        const std::string& key, const std::string& host, unsigned short port);
+
+    void run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        std::shared_ptr<CameraSession> session;
+        int useCount = 0;
+        Clock::time_point lingerDeadline;
+    };
+
+    const std::chrono::milliseconds m_linger;
+    const int m_connectTimeoutMs;
+    StartupScheduler m_startupScheduler;
+    TimerQueue m_timerQueue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_isStopped = false;
+    std::map<std::string, Entry> m_entries;
+    std::thread m_reaperThread;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
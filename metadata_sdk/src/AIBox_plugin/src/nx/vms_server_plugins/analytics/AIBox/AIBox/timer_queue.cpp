@@ -0,0 +1,126 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "timer_queue.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+TimerQueue::TimerQueue(int threadCount)
+{
+    for (int i = 0; i < std::max(threadCount, 1); ++i)
+    {
+        m_threads.emplace_back([this]() { run(); });
+    }
+}
+
+TimerQueue::~TimerQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopped = true;
+        m_tasks.clear();
+    }
+    m_wakeUp.notify_all();
+    for (auto& thread: m_threads)
+    {
+        thread.join();
+    }
+}
+
+void TimerQueue::post(
+    const void* owner, Clock::duration delay, int priority, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isStopped || m_cancelledOwners.count(owner) != 0)
+        {
+            return;
+        }
+        m_tasks.push_back(
+            Task{Clock::now() + delay, priority, m_nextSequence++, owner, std::move(task)});
+    }
+
+    // The waiting threads may have to wait for an earlier deadline now.
+    m_wakeUp.notify_all();
+}
+
+void TimerQueue::cancel(const void* owner)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasks.erase(
+        std::remove_if(m_tasks.begin(), m_tasks.end(),
+            [owner](const Task& task) { return task.owner == owner; }),
+        m_tasks.end());
+
+    m_cancelledOwners.insert(owner);
+    m_taskFinished.wait(lock, [this, owner]() { return m_runningTaskCounts.count(owner) == 0; });
+    m_cancelledOwners.erase(owner);
+}
+
+int TimerQueue::dueTaskIndex(Clock::time_point now, Clock::time_point* nextDeadline) const
+{
+    int result = -1;
+    for (int i = 0; i < (int) m_tasks.size(); ++i)
+    {
+        const Task& task = m_tasks[i];
+        if (task.deadline > now)
+        {
+            *nextDeadline = std::min(*nextDeadline, task.deadline);
+            continue;
+        }
+        if (result < 0
+            || task.priority > m_tasks[result].priority
+            || (task.priority == m_tasks[result].priority
+                && task.sequence < m_tasks[result].sequence))
+        {
+            result = i;
+        }
+    }
+    return result;
+}
+
+void TimerQueue::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_isStopped)
+    {
+        Clock::time_point nextDeadline = Clock::time_point::max();
+        const int taskIndex = dueTaskIndex(Clock::now(), &nextDeadline);
+        if (taskIndex < 0)
+        {
+            if (nextDeadline == Clock::time_point::max())
+            {
+                m_wakeUp.wait(lock);
+            }
+            else
+            {
+                m_wakeUp.wait_until(lock, nextDeadline);
+            }
+            continue;
+        }
+
+        Task task = std::move(m_tasks[taskIndex]);
+        m_tasks.erase(m_tasks.begin() + taskIndex);
+        ++m_runningTaskCounts[task.owner];
+
+        lock.unlock();
+        task.func();
+        lock.lock();
+
+        const auto it = m_runningTaskCounts.find(task.owner);
+        if (--it->second == 0)
+        {
+            m_runningTaskCounts.erase(it);
+        }
+        m_taskFinished.notify_all();
+    }
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
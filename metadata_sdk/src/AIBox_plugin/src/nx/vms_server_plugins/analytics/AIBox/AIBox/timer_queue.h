@@ -0,0 +1,81 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Runs the delayed tasks of many owners on a fixed set of threads, so that the number of threads
+ * does not grow with the number of owners. The tasks may block: while some of the threads are
+ * busy, the due tasks are run by the others.
+ *
+ * Of the tasks which are due, the ones with a higher priority run first, then in the order of
+ * posting.
+ */
+class TimerQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimerQueue(int threadCount);
+
+    /** Drops the pending tasks, and waits for the running ones. */
+    ~TimerQueue();
+
+    /** @param owner Identifies the tasks for cancel(). */
+    void post(const void* owner, Clock::duration delay, int priority, std::function<void()> task);
+
+    /**
+     * Drops the pending tasks of the owner, and waits for its running ones to finish; the tasks
+     * posted by them meanwhile are dropped as well. Must not be called from a task of the owner.
+     */
+    void cancel(const void* owner);
+
+private:
+    struct Task
+    {
+        Clock::time_point deadline;
+        int priority = 0;
+        uint64_t sequence = 0;
+        const void* owner = nullptr;
+        std::function<void()> func;
+    };
+
+    void run();
+
+    /**
+     * Must be called with m_mutex locked.
+     * @param nextDeadline If no task is due, receives the earliest deadline, if any.
+     * @return Index of the task to run next, or -1 if no task is due.
+     */
+    int dueTaskIndex(Clock::time_point now, Clock::time_point* nextDeadline) const;
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_taskFinished;
+    bool m_isStopped = false;
+    std::vector<Task> m_tasks;
+    uint64_t m_nextSequence = 0;
+    std::map<const void*, int> m_runningTaskCounts;
+    std::set<const void*> m_cancelledOwners; /**< While cancel() is waiting for them. */
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
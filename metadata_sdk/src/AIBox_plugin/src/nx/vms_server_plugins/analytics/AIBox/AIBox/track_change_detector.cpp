@@ -0,0 +1,57 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "track_change_detector.h"
+
+#include <cmath>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+using nx::sdk::analytics::Rect;
+
+bool TrackChangeDetector::isFullRefreshDue(int64_t timestampUs) const
+{
+    if (!isEnabled() || m_fullRefreshIntervalUs <= 0)
+        return false;
+
+    // The timestamps go backwards when the video stream restarts; refresh in this case too.
+    return m_lastFullRefreshUs == 0
+        || timestampUs < m_lastFullRefreshUs
+        || timestampUs - m_lastFullRefreshUs >= m_fullRefreshIntervalUs;
+}
+
+bool TrackChangeDetector::startPacket(int64_t timestampUs)
+{
+    if (!isFullRefreshDue(timestampUs))
+        return false;
+
+    m_lastFullRefreshUs = timestampUs;
+    return true;
+}
+
+bool TrackChangeDetector::hasChanged(
+    const TrackTable::Track& track, const Rect& box, int64_t timestampUs) const
+{
+    if (!isEnabled() || !track.emitted)
+        return true;
+
+    if (m_keepAliveIntervalUs > 0
+        && (timestampUs < track.emittedTimestampUs
+            || timestampUs - track.emittedTimestampUs >= m_keepAliveIntervalUs))
+    {
+        return true;
+    }
+
+    const Rect& emittedBox = track.emittedBox;
+    return std::abs(box.x - emittedBox.x) >= m_minBoxChange
+        || std::abs(box.y - emittedBox.y) >= m_minBoxChange
+        || std::abs(box.width - emittedBox.width) >= m_minBoxChange
+        || std::abs(box.height - emittedBox.height) >= m_minBoxChange;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,65 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+
+#include <nx/sdk/analytics/rect.h>
+
+#include "track_table.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Decides which tracks are worth sending to the Server: near-static objects, e.g. parked cars,
+ * are reported by the camera over and over with tiny box changes, and are re-sent only when
+ * their box changes noticeably or the keep-alive interval expires. Besides, every track is sent
+ * in the periodic full refresh packets.
+ *
+ * Not thread-safe - the owner is expected to guard it.
+ */
+class TrackChangeDetector
+{
+public:
+    /**
+     * @param minBoxChange Minimal change of any box coordinate or size, in the frame-relative
+     *     units, which makes the track to be sent. 0 disables the suppression.
+     */
+    void setMinBoxChange(float minBoxChange) { m_minBoxChange = minBoxChange; }
+
+    void setKeepAliveIntervalUs(int64_t intervalUs) { m_keepAliveIntervalUs = intervalUs; }
+
+    void setFullRefreshIntervalUs(int64_t intervalUs) { m_fullRefreshIntervalUs = intervalUs; }
+
+    bool isEnabled() const { return m_minBoxChange > 0; }
+
+    int64_t keepAliveIntervalUs() const { return m_keepAliveIntervalUs; }
+
+    bool isFullRefreshDue(int64_t timestampUs) const;
+
+    /**
+     * Must be called for each packet being generated.
+     * @return Whether the packet must be a full refresh one, i.e. contain all the tracks.
+     */
+    bool startPacket(int64_t timestampUs);
+
+    /** @return Whether the track must be sent with the given box at the given moment. */
+    bool hasChanged(
+        const TrackTable::Track& track,
+        const nx::sdk::analytics::Rect& box,
+        int64_t timestampUs) const;
+
+private:
+    float m_minBoxChange = 0;
+    int64_t m_keepAliveIntervalUs = 0;
+    int64_t m_fullRefreshIntervalUs = 0;
+    int64_t m_lastFullRefreshUs = 0;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,250 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "track_table.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+using nx::sdk::analytics::Rect;
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+static Rect lerp(const Rect& from, const Rect& to, float ratio)
+{
+    return Rect(
+        from.x + (to.x - from.x) * ratio,
+        from.y + (to.y - from.y) * ratio,
+        from.width + (to.width - from.width) * ratio,
+        from.height + (to.height - from.height) * ratio);
+}
+
+/** Extrapolation may push the box out of the frame; keep it valid for the Server. */
+static Rect clampToFrame(Rect box)
+{
+    box.width = std::clamp(box.width, 0.0f, 1.0f);
+    box.height = std::clamp(box.height, 0.0f, 1.0f);
+    box.x = std::clamp(box.x, 0.0f, 1.0f - box.width);
+    box.y = std::clamp(box.y, 0.0f, 1.0f - box.height);
+    return box;
+}
+
+TrackTable::TrackTable(int initialCapacity):
+    m_slots(roundUpToPowerOfTwo((size_t) std::max(initialCapacity, 8))),
+    m_mask(m_slots.size() - 1)
+{
+}
+
+size_t TrackTable::slotIndex(int targetId) const
+{
+    // Fibonacci hashing: spreads the sequential target ids over the whole table.
+    const uint64_t hash = (uint64_t) (uint32_t) targetId * 0x9E3779B97F4A7C15ULL;
+    return (size_t) (hash >> 32) & m_mask;
+}
+
+size_t TrackTable::findSlot(int targetId) const
+{
+    size_t index = slotIndex(targetId);
+    while (m_slots[index].used && m_slots[index].track.targetId != targetId)
+        index = (index + 1) & m_mask;
+    return index;
+}
+
+TrackTable::Track* TrackTable::update(
+    int targetId,
+    const std::string* typeId,
+    const nx::sdk::Uuid& trackId,
+    int64_t timestampUs,
+    const Rect& box)
+{
+    if ((size_t) (m_size + 1) * 2 > m_slots.size()) //< Keep the load factor below 0.5.
+        grow();
+
+    Slot& slot = m_slots[findSlot(targetId)];
+    Track& track = slot.track;
+    if (!slot.used)
+    {
+        slot.used = true;
+        track = Track();
+        track.targetId = targetId;
+        track.trackId = trackId;
+        ++m_size;
+    }
+    track.typeId = typeId;
+
+    if (track.historyCount > 0 && timestampUs < track.newestSample().timestampUs)
+        return &track;
+
+    if (!track.pending)
+    {
+        track.pending = true;
+        ++m_pendingCount;
+    }
+
+    // Several camera updates may arrive between two video frames, and thus get the same
+    // timestamp - the latest of them wins.
+    if (track.historyCount > 0 && timestampUs == track.newestSample().timestampUs)
+    {
+        track.history[track.newest].box = box;
+        return &track;
+    }
+
+    track.newest = (track.newest + 1) % kHistorySize;
+    track.history[track.newest] = Sample{timestampUs, box};
+    track.historyCount = std::min(track.historyCount + 1, kHistorySize);
+    return &track;
+}
+
+void TrackTable::setEmitted(Track* track, int64_t timestampUs, const Rect& box)
+{
+    setSkipped(track);
+    track->emitted = true;
+    track->emittedTimestampUs = timestampUs;
+    track->emittedBox = box;
+}
+
+void TrackTable::setSkipped(Track* track)
+{
+    if (track->pending)
+    {
+        track->pending = false;
+        --m_pendingCount;
+    }
+}
+
+const TrackTable::Track* TrackTable::find(int targetId) const
+{
+    const Slot& slot = m_slots[findSlot(targetId)];
+    return slot.used ? &slot.track : nullptr;
+}
+
+bool TrackTable::predict(
+    const Track& track, int64_t timestampUs, int64_t maxExtrapolationUs, Rect* outBox)
+{
+    if (track.historyCount == 0)
+        return false;
+
+    const Sample& newest = track.newestSample();
+    if (timestampUs >= newest.timestampUs)
+    {
+        const int64_t aheadUs = timestampUs - newest.timestampUs;
+        if (aheadUs > maxExtrapolationUs)
+            return false;
+
+        if (track.historyCount < 2 || aheadUs == 0)
+        {
+            *outBox = newest.box;
+            return true;
+        }
+
+        const Sample& previous = track.sample(1);
+        const int64_t spanUs = newest.timestampUs - previous.timestampUs;
+        if (spanUs <= 0)
+        {
+            *outBox = newest.box;
+            return true;
+        }
+
+        *outBox = clampToFrame(
+            lerp(previous.box, newest.box, 1.0f + (float) aheadUs / (float) spanUs));
+        return true;
+    }
+
+    for (int age = 0; age + 1 < track.historyCount; ++age)
+    {
+        const Sample& later = track.sample(age);
+        const Sample& earlier = track.sample(age + 1);
+        if (earlier.timestampUs <= timestampUs)
+        {
+            const int64_t spanUs = later.timestampUs - earlier.timestampUs;
+            const float ratio = (spanUs > 0)
+                ? (float) (timestampUs - earlier.timestampUs) / (float) spanUs
+                : 1.0f;
+            *outBox = lerp(earlier.box, later.box, ratio);
+            return true;
+        }
+    }
+    return false; //< The moment is older than the whole history.
+}
+
+int TrackTable::expire(int64_t nowUs, int64_t timeoutUs)
+{
+    int removed = 0;
+    size_t index = 0;
+    while (index < m_slots.size())
+    {
+        const Slot& slot = m_slots[index];
+        if (slot.used && slot.track.newestSample().timestampUs < nowUs - timeoutUs)
+        {
+            // Backward-shift deletion may move a not yet visited entry into this slot, so the
+            // slot is checked again.
+            eraseSlot(index);
+            ++removed;
+            continue;
+        }
+        ++index;
+    }
+    return removed;
+}
+
+void TrackTable::eraseSlot(size_t index)
+{
+    if (m_slots[index].track.pending)
+        --m_pendingCount;
+
+    // Backward-shift deletion keeps the probe sequences intact without tombstones.
+    size_t hole = index;
+    size_t next = index;
+    for (;;)
+    {
+        next = (next + 1) & m_mask;
+        if (!m_slots[next].used)
+            break;
+
+        const size_t home = slotIndex(m_slots[next].track.targetId);
+        const bool homeIsBetweenHoleAndNext = (hole <= next)
+            ? (hole < home && home <= next)
+            : (hole < home || home <= next);
+        if (homeIsBetweenHoleAndNext)
+            continue;
+
+        m_slots[hole] = m_slots[next];
+        hole = next;
+    }
+    m_slots[hole].used = false;
+    --m_size;
+}
+
+void TrackTable::grow()
+{
+    std::vector<Slot> oldSlots(m_slots.size() * 2);
+    oldSlots.swap(m_slots);
+    m_mask = m_slots.size() - 1;
+    for (const Slot& slot: oldSlots)
+    {
+        if (slot.used)
+            m_slots[findSlot(slot.track.targetId)] = slot;
+    }
+}
+
+void TrackTable::clear()
+{
+    for (Slot& slot: m_slots)
+        slot.used = false;
+    m_size = 0;
+    m_pendingCount = 0;
+}
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,156 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nx/sdk/analytics/rect.h>
+#include <nx/sdk/uuid.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+
+/**
+ * Per-DeviceAgent table of the object tracks reported by the camera, keyed by the camera's
+ * targetId. Each track keeps its last few boxes in a fixed ring buffer, which allows to
+ * interpolate (or extrapolate) the box for the video frames arriving between two camera updates.
+ *
+ * Implemented as a flat open-addressing hash map with linear probing, so that the steady state
+ * does no allocations. Not thread-safe - the owner is expected to guard it.
+ */
+class TrackTable
+{
+public:
+    static constexpr int kHistorySize = 4;
+
+    struct Sample
+    {
+        int64_t timestampUs = 0;
+        nx::sdk::analytics::Rect box;
+    };
+
+    struct Track
+    {
+        int targetId = 0;
+        const std::string* typeId = nullptr; //< Points to one of the static type id constants.
+        nx::sdk::Uuid trackId;
+
+        /** Ring buffer; `newest` is the index of the most recent sample. */
+        std::array<Sample, kHistorySize> history{};
+        int historyCount = 0;
+        int newest = -1;
+
+        /** The newest box has not been sent to the Server yet. */
+        bool pending = false;
+
+        /** The box last sent to the Server, and when; valid only if `emitted` is set. */
+        bool emitted = false;
+        int64_t emittedTimestampUs = 0;
+        nx::sdk::analytics::Rect emittedBox;
+
+        const Sample& newestSample() const { return history[newest]; }
+
+        /** @param age 0 for the newest sample, 1 for the previous one, and so on. */
+        const Sample& sample(int age) const
+        {
+            return history[(newest - age + kHistorySize) % kHistorySize];
+        }
+    };
+
+public:
+    explicit TrackTable(int initialCapacity = 64);
+
+    /**
+     * Adds a sample to the track, creating the track if needed, and marks the track as pending.
+     * Samples older than the newest one are ignored.
+     * @param trackId Used only when the track is created.
+     * @return The updated track, valid until the next modification of the table.
+     */
+    Track* update(
+        int targetId,
+        const std::string* typeId,
+        const nx::sdk::Uuid& trackId,
+        int64_t timestampUs,
+        const nx::sdk::analytics::Rect& box);
+
+    const Track* find(int targetId) const;
+
+    /**
+     * Calculates the box of the track at the given moment: interpolates between the samples
+     * surrounding the moment, or extrapolates from the two newest samples if the moment is after
+     * the newest one.
+     * @param maxExtrapolationUs The box is not predicted further than this from the newest sample.
+     * @return False if the box cannot be predicted for the given moment.
+     */
+    static bool predict(
+        const Track& track,
+        int64_t timestampUs,
+        int64_t maxExtrapolationUs,
+        nx::sdk::analytics::Rect* outBox);
+
+    /**
+     * Removes the tracks which have not been updated since `nowUs - timeoutUs`.
+     * @return Number of removed tracks.
+     */
+    int expire(int64_t nowUs, int64_t timeoutUs);
+
+    void clear();
+
+    int size() const { return m_size; }
+
+    bool hasPendingTracks() const { return m_pendingCount > 0; }
+
+    /** Marks the track as sent to the Server with the given box. */
+    void setEmitted(Track* track, int64_t timestampUs, const nx::sdk::analytics::Rect& box);
+
+    /** Clears the pending flag of the track without sending it, e.g. if its box has not changed. */
+    void setSkipped(Track* track);
+
+    template<typename Visitor>
+    void forEach(Visitor visitor) const
+    {
+        for (const Slot& slot: m_slots)
+        {
+            if (slot.used)
+                visitor(slot.track);
+        }
+    }
+
+    template<typename Visitor>
+    void forEach(Visitor visitor)
+    {
+        for (Slot& slot: m_slots)
+        {
+            if (slot.used)
+                visitor(&slot.track);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        bool used = false;
+        Track track;
+    };
+
+    size_t slotIndex(int targetId) const;
+    size_t findSlot(int targetId) const;
+    void eraseSlot(size_t index);
+    void grow();
+
+private:
+    std::vector<Slot> m_slots;
+    size_t m_mask = 0;
+    int m_size = 0;
+    int m_pendingCount = 0;
+};
+
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
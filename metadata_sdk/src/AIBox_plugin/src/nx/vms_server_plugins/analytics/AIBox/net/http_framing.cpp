@@ -0,0 +1,74 @@
+
+#include "http_framing.h"
+
+#include <istream>
+
+/** @return Whether the line is the Content-Length field; its value is 0 if malformed. */
+static bool parseContentLength(const std::string& line, size_t* outContentLength)
+{
+    static const std::string kKey = "Content-Length:";
+    const size_t pos = line.find(kKey);
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+
+    std::string value = line.substr(pos + kKey.size());
+    const size_t start = value.find_first_not_of(" \t");
+    const size_t end = value.find_last_not_of(" \t\r");
+    if (start != std::string::npos && end != std::string::npos && end >= start)
+    {
+        value = value.substr(start, end - start + 1);
+    }
+    try
+    {
+        *outContentLength = static_cast<size_t>(std::stoul(value));
+    }
+    catch (...)
+    {
+        *outContentLength = 0;
+    }
+    return true;
+}
+
+HttpMessageHeader readHttpMessageHeader(asio::streambuf* buffer)
+{
+    HttpMessageHeader header;
+    std::istream stream(buffer);
+    std::getline(stream, header.firstLine);
+    if (!header.firstLine.empty() && header.firstLine.back() == '\r')
+    {
+        header.firstLine.pop_back();
+    }
+
+    size_t codeStart = header.firstLine.find(' ');
+    if (codeStart != std::string::npos)
+    {
+        codeStart++;
+    }
+    const size_t codeEnd = header.firstLine.find(' ', codeStart);
+    if (codeStart != std::string::npos && codeEnd != std::string::npos && codeEnd > codeStart)
+    {
+        header.statusCode = header.firstLine.substr(codeStart, codeEnd - codeStart);
+    }
+
+    // The first Content-Length field is taken.
+    bool hasContentLength = false;
+    std::string line;
+    while (std::getline(stream, line) && line != "\r")
+    {
+        if (!hasContentLength)
+        {
+            hasContentLength = parseContentLength(line, &header.contentLength);
+        }
+    }
+    return header;
+}
+
+std::string readHttpMessageBody(asio::streambuf* buffer, size_t contentLength)
+{
+    const auto data = buffer->data();
+    std::string body(asio::buffers_begin(data), asio::buffers_begin(data) + contentLength);
+    buffer->consume(contentLength);
+    return body;
+}
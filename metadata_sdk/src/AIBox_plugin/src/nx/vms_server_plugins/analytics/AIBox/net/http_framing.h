@@ -0,0 +1,24 @@
+// http_framing.h
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <asio.hpp>
+
+/** Start line and the fields of the header of an HTTP message, which the Plugin needs. */
+struct HttpMessageHeader
+{
+    std::string firstLine; //< Without the line end.
+    std::string statusCode; //< Second word of the first line: the status code of a response.
+    size_t contentLength = 0; //< 0 if there is no valid Content-Length field.
+};
+
+/**
+ * Consumes the header, up to and including the empty line, from the buffer. The header must be in
+ * the buffer as a whole, e.g. read by asio::async_read_until() up to "\r\n\r\n".
+ */
+HttpMessageHeader readHttpMessageHeader(asio::streambuf* buffer);
+
+/** Consumes the body of the given length, which must be in the buffer as a whole. */
+std::string readHttpMessageBody(asio::streambuf* buffer, size_t contentLength);
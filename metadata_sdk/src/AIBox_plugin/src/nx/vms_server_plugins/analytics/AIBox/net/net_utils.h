@@ -1,6 +1,7 @@
 // net_utils.h
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,14 @@ struct TrajectoryResult
     int y2;
 };
 
+/** Moments of a message's way through the Plugin, in microseconds; 0 if not measured. */
+struct MessageTiming
+{
+    int64_t receivedUs = 0; //< Steady clock; when the message header was read from the socket.
+    int64_t receivedSystemUs = 0; //< System clock at the same moment, to compare with currentTime.
+    int64_t parsedUs = 0; //< Steady clock.
+};
+
 struct PEAResult
 {
     std::string smartType;
@@ -24,6 +33,8 @@ struct PEAResult
     std::string deviceMac;
     std::string deviceName;
     std::vector<TrajectoryResult> trajects;
+    MessageTiming timing;
+    size_t bodySize = 0; //< Of the XML message, in bytes.
 };
 
 std::string preprocessXmlData(const std::string& xmlData);
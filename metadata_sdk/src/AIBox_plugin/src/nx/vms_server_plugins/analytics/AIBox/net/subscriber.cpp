@@ -7,18 +7,35 @@
 
 #include <nx/kit/debug.h>
 
+#include "../AIBox/allocation_tracker.h"
+#include "../AIBox/ini.h"
+
+using nx::vms_server_plugins::analytics::AIBox::ini; //< For NX_PROFILE_ZONE.
+using nx::vms_server_plugins::analytics::AIBox::AllocationScope;
+using nx::vms_server_plugins::analytics::AIBox::AllocationTracker;
+
 Subscriber::Subscriber() 
 {
     m_client =  std::make_shared<TcpClient>();
 }
 
-Subscriber::~Subscriber() {}
+Subscriber::~Subscriber()
+{
+    // A handler running on the IO thread may hold the client; it must not become its last owner.
+    m_client->stop();
+}
 
 void Subscriber::registerPEAResultCallback(PEAResultCallback callback)
 {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
     m_PEAResultCallback = callback;
 }
 
+void Subscriber::setConnectionStateChangedCallback(std::function<void()> callback)
+{
+    m_client->setConnectionStateChangedCallback(std::move(callback));
+}
+
 void Subscriber::startIpcSubscription(const std::string& host, unsigned short port, const std::string& subscribePath, const std::string& basicAuth)
 {
     NX_PRINT << "Starting IPC subscription to " << host << ":" << port << subscribePath;
@@ -28,9 +45,24 @@ void Subscriber::startIpcSubscription(const std::string& host, unsigned short po
         return;
     }
     m_client->connect(host, port, subscribePath, basicAuth,
-        [this](const std::string& data) {
-            PEAResult result = parsePEATrajectoryData(data);
-            if (m_PEAResultCallback && !result.trajects.empty())
+        [this](const std::string& data, const MessageTiming& timing) {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            if (!m_PEAResultCallback)
+            {
+                return;
+            }
+            PEAResult result;
+            {
+                NX_PROFILE_ZONE("parse");
+                const AllocationScope allocationScope("parse");
+                result = parsePEATrajectoryData(data);
+            }
+            AllocationTracker::countMessage();
+            result.timing = timing;
+            result.bodySize = data.size();
+            result.timing.parsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            if (!result.trajects.empty())
             {
                 m_PEAResultCallback(result);
             }
@@ -1,6 +1,7 @@
 #ifndef SUBSCRIBER_H
 #define SUBSCRIBER_H
 
+#include <mutex>
 #include <string>
 
 #include "tcp_client.h"
@@ -20,10 +21,23 @@ public:
 
     bool isSubscribed() const { return m_client->isConnected(); }
 
+    /**
+     * Called after isSubscribed() may have changed, without the locks of the subscriber held.
+     * Must be set before startIpcSubscription().
+     */
+    void setConnectionStateChangedCallback(std::function<void()> callback);
+
     using PEAResultCallback = std::function<void(const PEAResult&)>;
+
+    /**
+     * Can be called at any time to replace the callback, or to remove it with nullptr; after the
+     * call returns, the previous callback is not called anymore. Without a callback, the received
+     * data is not parsed.
+     */
     void registerPEAResultCallback(PEAResultCallback callback);
 
 private:
+    std::mutex m_callbackMutex;
     PEAResultCallback m_PEAResultCallback = nullptr;
     std::shared_ptr<TcpClient> m_client;
 };
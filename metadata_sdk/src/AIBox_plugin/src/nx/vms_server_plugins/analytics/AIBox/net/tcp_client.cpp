@@ -7,6 +7,14 @@
 
 #include <nx/kit/debug.h>
 
+#include "../AIBox/allocation_tracker.h"
+#include "../AIBox/ini.h"
+
+using nx::vms_server_plugins::analytics::AIBox::ini; //< For NX_PROFILE_ZONE.
+using nx::vms_server_plugins::analytics::AIBox::AllocationScope;
+using nx::vms_server_plugins::analytics::AIBox::ReactorHandlerScope;
+using nx::vms_server_plugins::analytics::AIBox::ReactorProbe;
+
 const std::string TcpClient::kBasicAuthPrefix =     "Basic ";
 const std::string TcpClient::kXmlVersion =          "1.7";
 const int TcpClient::kReconnectDelayMillisec =      50;
@@ -22,6 +30,7 @@ TcpClient::TcpClient():
     m_socket(nullptr),
     m_subscribeRetryCount(0)
 {
+    m_reactorProbe = std::make_unique<ReactorProbe>(m_ioContext, ini().reactorProbeIntervalMs);
     m_ioThread = std::thread([this]()
     {
         try
@@ -36,6 +45,11 @@ TcpClient::TcpClient():
 }
 
 TcpClient::~TcpClient()
+{
+    stop();
+}
+
+void TcpClient::stop()
 {
     disconnect();
     m_work_guard.reset();
@@ -49,12 +63,17 @@ TcpClient::~TcpClient()
 void TcpClient::connect(const std::string& host, unsigned short port, const std::string& subscribePath, 
                         const std::string& basicAuth, DataReceivedCallback callback)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
     if (m_connected)
     {
         NX_PRINT << "TcpClient already connected. No action taken.";
         return;
     }
+    if (m_state == State::Connecting)
+    {
+        NX_PRINT << "TcpClient already connecting. No action taken.";
+        return;
+    }
 
     m_host = host;
     m_port = port;
@@ -63,30 +82,45 @@ void TcpClient::connect(const std::string& host, unsigned short port, const std:
     m_dataReceivedCallback = callback;
     m_state = State::Connecting;
 
+    // The handlers do not keep the client alive, so that its last owner destroys it on its own
+    // thread, rather than the IO thread destroying itself.
+    auto self_weak = std::weak_ptr<TcpClient>(shared_from_this());
     m_resolver.async_resolve(
         host,
         std::to_string(port),
-        [this](const asio::error_code& ec, asio::ip::tcp::resolver::results_type results)
+        [self_weak](const asio::error_code& ec, asio::ip::tcp::resolver::results_type results)
         {
+            const ReactorHandlerScope handlerScope("TcpClient.resolve");
+            auto self = self_weak.lock();
+            if (!self)
+            {
+                return;
+            }
             if (!ec)
             {
                 NX_PRINT << "Async connect starting...";
-                m_socket = std::make_unique<asio::ip::tcp::socket>(m_ioContext);
-                auto self = shared_from_this();
+                self->m_socket = std::make_unique<asio::ip::tcp::socket>(self->m_ioContext);
                 asio::async_connect(
-                    *m_socket,
+                    *self->m_socket,
                     results,
-                    [self, results](const asio::error_code& ec, const asio::ip::tcp::endpoint& /*endpoint*/)
+                    [self_weak, results](const asio::error_code& ec, const asio::ip::tcp::endpoint& /*endpoint*/)
                     {
-                        self->onConnect(ec, results);
+                        const ReactorHandlerScope handlerScope("TcpClient.connect");
+                        if (auto self = self_weak.lock())
+                        {
+                            self->onConnect(ec, results);
+                        }
                     });
             }
             else
             {
                 NX_PRINT << "Resolve error: " << ec.message();
-                std::lock_guard<std::mutex> lock(m_mutex);
-                m_connected = false;
-                m_state = State::Failed;
+                {
+                    std::lock_guard<nx::kit::Mutex> lock(self->m_mutex);
+                    self->m_connected = false;
+                    self->m_state = State::Failed;
+                }
+                self->notifyConnectionStateChanged();
             }
         });
 
@@ -99,22 +133,24 @@ void TcpClient::onConnect(const asio::error_code& ec, const asio::ip::tcp::resol
     {
         NX_PRINT << "TcpClient connected.";
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            std::lock_guard<nx::kit::Mutex> lock(m_mutex);
             m_retryTimer.cancel();
             m_connected = true;
             m_subscribeRetryCount = 0;
             m_state = State::Subscribing;
         }
+        notifyConnectionStateChanged();
         sendSubscribeRequest(endpoints);
     }
     else
     {
         NX_PRINT << "Connect error: " << ec.message();
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            std::lock_guard<nx::kit::Mutex> lock(m_mutex);
             m_connected = false;
             m_state = State::Failed;
         }
+        notifyConnectionStateChanged();
     }
 }
 
@@ -157,23 +193,40 @@ void TcpClient::sendSubscribeRequest(const asio::ip::tcp::resolver::results_type
     request << "\r\n";
     request << body;
 
-    auto self = shared_from_this();
-    asio::async_write(*m_socket, asio::buffer(request.str()),
-                      std::bind(&TcpClient::onSubscribeSent, self, std::placeholders::_1, std::placeholders::_2));
+    // The buffer must stay valid until the write completes.
+    const auto requestData = std::make_shared<std::string>(request.str());
+    auto self_weak = std::weak_ptr<TcpClient>(shared_from_this());
+    asio::async_write(
+        *m_socket,
+        asio::buffer(*requestData),
+        [self_weak, requestData](const asio::error_code& ec, size_t bytesTransferred)
+        {
+            if (auto self = self_weak.lock())
+            {
+                self->onSubscribeSent(ec, bytesTransferred);
+            }
+        });
 }
 
 void TcpClient::onSubscribeSent(const asio::error_code& ec, size_t bytesTransferred)
 {
+    const ReactorHandlerScope handlerScope("TcpClient.subscribeSent");
     if (!ec)
     {
         NX_PRINT << "Subscribe request sent (" << bytesTransferred << " bytes).";
-        auto self = shared_from_this();
+        auto self_weak = std::weak_ptr<TcpClient>(shared_from_this());
         asio::async_read_until(
             *m_socket,
             m_responseBuffer,
             "\r\n\r\n",
-            [self](const asio::error_code& ec, size_t bytesTransferred)
+            [self_weak](const asio::error_code& ec, size_t bytesTransferred)
             {
+                const ReactorHandlerScope handlerScope("TcpClient.readResponseHeader");
+                auto self = self_weak.lock();
+                if (!self)
+                {
+                    return;
+                }
                 if (!ec)
                 {
                     self->handleHeader(bytesTransferred);
@@ -194,38 +247,25 @@ void TcpClient::onSubscribeSent(const asio::error_code& ec, size_t bytesTransfer
 
 void TcpClient::handleHeader(size_t bytesTransferred)
 {
-    std::istream responseStream(&m_responseBuffer);
-    std::getline(responseStream, m_firstLine);
-
-    size_t codeStart = m_firstLine.find(' ');
-    if (codeStart != std::string::npos)
-    {
-        codeStart++;
-    }
-    size_t codeEnd = m_firstLine.find(' ', codeStart);
-    m_statusCode = (codeStart != std::string::npos && codeEnd != std::string::npos && codeEnd > codeStart)
-        ? m_firstLine.substr(codeStart, codeEnd - codeStart)
-        : "";
-
-    std::string line;
-    std::string header;
-    while (std::getline(responseStream, line) && line != "\r")
-    {
-        header += line + "\n";
-    }
-
-    size_t contentLength = parseContentLength(header);
+    // Taken when the read completes: asio reads into the streambuf without the ancillary data, so
+    // the kernel receive timestamps (SO_TIMESTAMPNS) are not available here.
+    m_messageTiming = MessageTiming();
+    m_messageTiming.receivedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    m_messageTiming.receivedSystemUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    NX_PROFILE_ZONE("framing");
+    const AllocationScope allocationScope("framing");
+    m_header = readHttpMessageHeader(&m_responseBuffer);
+    const size_t contentLength = m_header.contentLength;
     size_t bodyAlready = m_responseBuffer.size();
 
     if (contentLength > 0)
     {
         if (bodyAlready >= contentLength)
         {
-            std::istream responseStream(&m_responseBuffer);
-            std::istreambuf_iterator<char> it(responseStream);
-            std::string body;
-            std::copy_n(it, contentLength, std::back_inserter(body));
-            processBody(body);
+            processBody(readHttpMessageBody(&m_responseBuffer, contentLength));
         }
         else
         {
@@ -237,6 +277,7 @@ void TcpClient::handleHeader(size_t bytesTransferred)
                 asio::transfer_exactly(toRead),
                 [self_weak, contentLength](const asio::error_code& ec, size_t /*bytesTransferred*/)
                 {
+                    const ReactorHandlerScope handlerScope("TcpClient.readBody");
                     if (ec == asio::error::operation_aborted)
                     {
                         return;
@@ -248,17 +289,16 @@ void TcpClient::handleHeader(size_t bytesTransferred)
                     }
                     if (!ec)
                     {
-                        std::istream responseStream(&self->m_responseBuffer);
-                        std::istreambuf_iterator<char> it(responseStream);
-                        std::string body;
-                        std::copy_n(it, contentLength, std::back_inserter(body));
-                        self->processBody(body);
+                        NX_PROFILE_ZONE("framing");
+                        const AllocationScope allocationScope("framing");
+                        self->processBody(
+                            readHttpMessageBody(&self->m_responseBuffer, contentLength));
                     }
                     else
                     {
                         NX_PRINT << "Body read error: " << ec.message();
                         {
-                            std::lock_guard<std::mutex> lock(self->m_mutex);
+                            std::lock_guard<nx::kit::Mutex> lock(self->m_mutex);
                             self->m_state = State::Failed;
                         }
                         self->disconnect();
@@ -302,12 +342,12 @@ void TcpClient::processBody(const std::string& body)
         }
         case State::Subscribing:
         {
-            handleResponse(m_statusCode, m_subscribeRetryCount, kReTryTimes,
+            handleResponse(m_header.statusCode, m_subscribeRetryCount, kReTryTimes,
                 [this]() { sendSubscribeRequest(m_resolver.resolve(m_host, std::to_string(m_port))); },
                 [this, body]() 
                 {
                     {
-                        std::lock_guard<std::mutex> lock(m_mutex);
+                        std::lock_guard<nx::kit::Mutex> lock(m_mutex);
                         m_state = State::Subscribed;
                     }
                     handleBody(body, true);
@@ -318,18 +358,18 @@ void TcpClient::processBody(const std::string& body)
         case State::Unsubscribing:
         {
             NX_PRINT << "Handling unsubscribe response...";
-            if (m_firstLine.find("POST") != std::string::npos)
+            if (m_header.firstLine.find("POST") != std::string::npos)
             {
                 readNextHeader();
                 break;
             }
-            handleResponse(m_statusCode, m_unsubscribeRetryCount, kReTryTimes,
+            handleResponse(m_header.statusCode, m_unsubscribeRetryCount, kReTryTimes,
                 [this]() { sendUnsubscribeRequest(); },
                 [this]()
                 {
                     NX_PRINT << "Unsubscribe successful.";
                     {
-                        std::lock_guard<std::mutex> lock(m_mutex);
+                        std::lock_guard<nx::kit::Mutex> lock(m_mutex);
                         m_state = State::Disconnected;
                     }
                     disconnect();
@@ -340,7 +380,7 @@ void TcpClient::processBody(const std::string& body)
         {    
             NX_PRINT << "Unknown state.";
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
+                std::lock_guard<nx::kit::Mutex> lock(m_mutex);
                 m_state = State::Failed;
             }
             disconnect();
@@ -355,7 +395,7 @@ void TcpClient::handleBody(const std::string& body, bool isSubscriptionResponse)
     {
         if (m_dataReceivedCallback)
         {
-            m_dataReceivedCallback(body);
+            m_dataReceivedCallback(body, m_messageTiming);
         }
     }
     else
@@ -385,7 +425,7 @@ void TcpClient::handleBody(const std::string& body, bool isSubscriptionResponse)
             {
                 std::string addr = body.substr(start, end - start);
                 {
-                    std::lock_guard<std::mutex> lock(m_mutex);
+                    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
                     m_subscriptionServerAddress = addr;
                 }
                 NX_PRINT << "Extracted subscription server address: " << m_subscriptionServerAddress;
@@ -396,13 +436,19 @@ void TcpClient::handleBody(const std::string& body, bool isSubscriptionResponse)
 
 void TcpClient::readNextHeader()
 {
-    auto self = shared_from_this();
+    auto self_weak = std::weak_ptr<TcpClient>(shared_from_this());
     asio::async_read_until(
         *m_socket,
         m_responseBuffer,
         "\r\n\r\n",
-        [self](const asio::error_code& ec, size_t bytesTransferred)
+        [self_weak](const asio::error_code& ec, size_t bytesTransferred)
         {
+            const ReactorHandlerScope handlerScope("TcpClient.readHeader");
+            auto self = self_weak.lock();
+            if (!self)
+            {
+                return;
+            }
             if (!ec)
             {
                 self->handleHeader(bytesTransferred);
@@ -411,7 +457,7 @@ void TcpClient::readNextHeader()
             {
                 NX_PRINT << "Header read error: " << ec.message();
                 {
-                    std::lock_guard<std::mutex> lock(self->m_mutex);
+                    std::lock_guard<nx::kit::Mutex> lock(self->m_mutex);
                     self->m_state = State::Failed;
                 }
                 self->disconnect();
@@ -421,7 +467,7 @@ void TcpClient::readNextHeader()
 
 void TcpClient::unsubscribe()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
     if (!m_connected || !m_socket || m_subscriptionServerAddress.empty())
     {
         NX_PRINT << "Unsubscribe failed: not connected or no server address";
@@ -458,12 +504,19 @@ void TcpClient::sendUnsubscribeRequest()
     request << "\r\n";
     request << body;
 
-    auto self = shared_from_this();
+    const auto requestData = std::make_shared<std::string>(request.str());
+    auto self_weak = std::weak_ptr<TcpClient>(shared_from_this());
     asio::async_write(
         *m_socket,
-        asio::buffer(request.str()),
-        [self](const asio::error_code& ec, size_t /*bytesTransferred*/)
+        asio::buffer(*requestData),
+        [self_weak, requestData](const asio::error_code& ec, size_t /*bytesTransferred*/)
         {
+            const ReactorHandlerScope handlerScope("TcpClient.unsubscribeSent");
+            auto self = self_weak.lock();
+            if (!self)
+            {
+                return;
+            }
             if (!ec)
             {
                 NX_PRINT << "Unsubscribe request sent...";
@@ -478,61 +531,53 @@ void TcpClient::sendUnsubscribeRequest()
 
 void TcpClient::disconnect()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    try { m_retryTimer.cancel(); } catch(...) {}
-    try { m_resolver.cancel(); } catch(...) {}
-    if (m_socket)
     {
-        asio::error_code ec;
-        try { m_socket->cancel(ec); } catch(...) {}
-        try { m_socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec); } catch(...) {}
-        try { m_socket->close(ec); } catch(...) {}
-        m_socket.reset();
+        std::lock_guard<nx::kit::Mutex> lock(m_mutex);
+        try { m_retryTimer.cancel(); } catch(...) {}
+        try { m_resolver.cancel(); } catch(...) {}
+        if (m_socket)
+        {
+            asio::error_code ec;
+            try { m_socket->cancel(ec); } catch(...) {}
+            try { m_socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec); } catch(...) {}
+            try { m_socket->close(ec); } catch(...) {}
+            m_socket.reset();
+        }
+        m_connected = false;
+        m_state = State::Disconnected;
     }
-    m_connected = false;
-    m_state = State::Disconnected;
     NX_PRINT << "TcpClient disconnected!";
+    notifyConnectionStateChanged();
 }
 
 bool TcpClient::isConnected() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
     return m_connected && 
            (m_state != State::Disconnected && m_state != State::Failed);
 }
 
-void TcpClient::setRetryIntervalMs(int milliseconds)
+void TcpClient::setConnectionStateChangedCallback(std::function<void()> callback)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (milliseconds > 0)
+    m_connectionStateChangedCallback = std::move(callback);
+}
+
+void TcpClient::notifyConnectionStateChanged()
+{
+    // Not called under m_mutex: the callback may check isConnected().
+    if (m_connectionStateChangedCallback)
     {
-        m_retryIntervalMillisec = milliseconds;
+        m_connectionStateChangedCallback();
     }
 }
 
-size_t TcpClient::parseContentLength(const std::string& header)
+void TcpClient::setRetryIntervalMs(int milliseconds)
 {
-    size_t contentLength = 0;
-    std::istringstream hs(header);
-    std::string line;
-    while (std::getline(hs, line))
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
+    if (milliseconds > 0)
     {
-        const std::string key = "Content-Length:";
-        auto pos = line.find(key);
-        if (pos != std::string::npos)
-        {
-            std::string val = line.substr(pos + key.size());
-            size_t start = val.find_first_not_of(" \t");
-            size_t end = val.find_last_not_of(" \t\r");
-            if (start != std::string::npos && end != std::string::npos && end >= start)
-            {
-                val = val.substr(start, end - start + 1);
-            }
-            try { contentLength = static_cast<size_t>(std::stoul(val)); } catch (...) { contentLength = 0; }
-            break;
-        }
+        m_retryIntervalMillisec = milliseconds;
     }
-    return contentLength;
 }
 
 void TcpClient::handleResponse(const std::string& statusCode, int& retryCount, int maxRetries, 
@@ -545,7 +590,7 @@ void TcpClient::handleResponse(const std::string& statusCode, int& retryCount, i
     else
     {
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            std::lock_guard<nx::kit::Mutex> lock(m_mutex);
             retryCount = 0;
             m_retryTimer.cancel();
         }
@@ -567,13 +612,13 @@ void TcpClient::retryRequest(int& retryCount, int maxRetries, const std::functio
 {
     int rc = 0;
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<nx::kit::Mutex> lock(m_mutex);
         rc = retryCount;
     }
     if (rc < maxRetries)
     {
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            std::lock_guard<nx::kit::Mutex> lock(m_mutex);
             rc++;
             retryCount = rc;
             NX_PRINT << "Retrying request, attempt (" << retryCount << "/" << maxRetries << ")";
@@ -583,6 +628,7 @@ void TcpClient::retryRequest(int& retryCount, int maxRetries, const std::functio
         m_retryTimer.async_wait(
             [self_weak, requestFunction](const asio::error_code& ec)
             {
+                const ReactorHandlerScope handlerScope("TcpClient.retry");
                 if (ec == asio::error::operation_aborted)   
                 {
                     return;
@@ -609,7 +655,7 @@ void TcpClient::retryRequest(int& retryCount, int maxRetries, const std::functio
     {
         NX_PRINT << "Max retries reached. Disconnecting...";
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            std::lock_guard<nx::kit::Mutex> lock(m_mutex);
             m_state = State::Failed;
         }
         disconnect();
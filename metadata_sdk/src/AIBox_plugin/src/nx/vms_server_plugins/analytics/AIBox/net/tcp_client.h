@@ -12,8 +12,15 @@
 #include <asio/ts/internet.hpp>
 #include <asio/executor_work_guard.hpp>
 
+#include <nx/kit/mutex.h>
 
-using DataReceivedCallback = std::function<void(const std::string&)>;
+#include "http_framing.h"
+#include "net_utils.h"
+#include "../AIBox/reactor_monitor.h"
+
+/** Called for each message the camera pushes, with the moment its header has been received. */
+using DataReceivedCallback =
+    std::function<void(const std::string& body, const MessageTiming& timing)>;
 
 class TcpClient : public std::enable_shared_from_this<TcpClient>
 {
@@ -28,7 +35,19 @@ public:
 
     void disconnect();
 
+    /**
+     * Disconnects, and stops the IO thread: no handler runs after the call returns. Must not be
+     * called on the IO thread, i.e. from the callback. Called by the destructor as well.
+     */
+    void stop();
+
     bool isConnected() const;
+
+    /**
+     * Called after isConnected() may have changed, on the IO thread or on the thread calling
+     * disconnect(), without the lock of the client held. Must be set before connect().
+     */
+    void setConnectionStateChangedCallback(std::function<void()> callback);
     
     void setRetryIntervalMs(int milliseconds);
 
@@ -55,9 +74,9 @@ private:
     
     void doDisconnect();
 
-private:
-    size_t parseContentLength(const std::string& header);
+    void notifyConnectionStateChanged();
 
+private:
     void handleResponse(const std::string& statusCode, int& retryCount, int maxRetries, 
                         const std::function<void()>& requestFunction, const std::function<void()>& onSuccess);
 
@@ -74,18 +93,20 @@ private:
     asio::steady_timer                                          m_retryTimer;
     std::unique_ptr<asio::ip::tcp::socket>                      m_socket;
     asio::streambuf                                             m_responseBuffer;
+    std::unique_ptr<nx::vms_server_plugins::analytics::AIBox::ReactorProbe> m_reactorProbe;
 
 private:
     std::thread             m_ioThread;
-    mutable std::mutex      m_mutex;
+    mutable nx::kit::Mutex  m_mutex{"TcpClient::m_mutex"};
     bool                    m_connected = false;
     std::string             m_host;
     unsigned short          m_port = 0;
     std::string             m_subscribePath;
     std::string             m_basicAuth;
     DataReceivedCallback    m_dataReceivedCallback;
-    std::string             m_firstLine;
-    std::string             m_statusCode;
+    std::function<void()>   m_connectionStateChangedCallback;
+    HttpMessageHeader       m_header;
+    MessageTiming           m_messageTiming;
     int                     m_subscribeRetryCount = 0; 
     int                     m_unsubscribeRetryCount = 0;
     std::string             m_subscriptionServerAddress;
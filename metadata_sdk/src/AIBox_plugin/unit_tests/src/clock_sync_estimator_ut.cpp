@@ -0,0 +1,92 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/clock_sync_estimator.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static constexpr int64_t kWindowUs = 10'000'000;
+static constexpr int64_t kMaxJumpUs = 2'000'000;
+
+TEST(clockSyncEstimator, minimumOffset)
+{
+    ClockSyncEstimator estimator(kWindowUs, kMaxJumpUs);
+    static constexpr int64_t kOffsetUs = 1'000'000'000;
+    static const int64_t kDelaysUs[] = {30'000, 5'000, 80'000, 12'000, 5'500, 200'000};
+
+    ASSERT_EQ(100 + kOffsetUs + 30'000, estimator.toServerTimeUs(100, 100 + kOffsetUs + 30'000));
+
+    int64_t cameraTimeUs = 100;
+    for (const int64_t delayUs: kDelaysUs)
+    {
+        cameraTimeUs += 40'000;
+        estimator.toServerTimeUs(cameraTimeUs, cameraTimeUs + kOffsetUs + delayUs);
+    }
+
+    // The smallest delay is the closest to the true offset; a delayed message does not move it.
+    ASSERT_EQ(kOffsetUs + 5'000, estimator.offsetUs());
+    ASSERT_EQ(
+        cameraTimeUs + 40'000 + kOffsetUs + 5'000,
+        estimator.toServerTimeUs(cameraTimeUs + 40'000, cameraTimeUs + 40'000 + kOffsetUs + 300'000));
+}
+
+TEST(clockSyncEstimator, window)
+{
+    ClockSyncEstimator estimator(kWindowUs, kMaxJumpUs);
+
+    estimator.toServerTimeUs(0, 1000);
+    estimator.toServerTimeUs(1'000'000, 1'000'000 + 5000);
+    ASSERT_EQ(1000, estimator.offsetUs());
+
+    // The camera clock drifts; the old minimum is forgotten when it leaves the window.
+    estimator.toServerTimeUs(kWindowUs - 500'000, kWindowUs - 500'000 + 4000);
+    ASSERT_EQ(1000, estimator.offsetUs());
+    estimator.toServerTimeUs(kWindowUs + 500'000, kWindowUs + 500'000 + 6000);
+    ASSERT_EQ(4000, estimator.offsetUs());
+    estimator.toServerTimeUs(2 * kWindowUs + 1'000'000, 2 * kWindowUs + 1'000'000 + 7000);
+    ASSERT_EQ(7000, estimator.offsetUs());
+}
+
+TEST(clockSyncEstimator, cameraClockSet)
+{
+    ClockSyncEstimator estimator(kWindowUs, kMaxJumpUs);
+    estimator.toServerTimeUs(50'000'000, 50'001'000);
+    estimator.toServerTimeUs(50'040'000, 50'045'000);
+    ASSERT_EQ(1000, estimator.offsetUs());
+
+    // The camera clock is set back by a minute: the estimation restarts at once.
+    ASSERT_EQ(50'080'000 + 3000, estimator.toServerTimeUs(-9'920'000, 50'083'000));
+    ASSERT_EQ(60'003'000, estimator.offsetUs());
+
+    // A jump within the limit is considered a delay.
+    ASSERT_EQ(50'120'000 + 3000, estimator.toServerTimeUs(-9'880'000, 50'120'000 + 1'500'000));
+
+    // The camera clock is set forward: the smaller offset is the new minimum at once.
+    ASSERT_EQ(50'160'000 + 2000, estimator.toServerTimeUs(90'000'000, 50'160'000 + 2000));
+    ASSERT_EQ(-39'838'000, estimator.offsetUs());
+}
+
+TEST(clockSyncEstimator, maxSamples)
+{
+    ClockSyncEstimator estimator(/*windowUs*/ 1'000'000'000, /*maxJumpUs*/ 1'000'000);
+
+    // Growing offsets all stay in the queue, until it overflows and forgets the oldest ones.
+    for (int i = 0; i < 300; ++i)
+        estimator.toServerTimeUs(i * 1000, i * 1000 + i);
+    ASSERT_EQ(300 - 128, estimator.offsetUs());
+
+    estimator.reset();
+    estimator.toServerTimeUs(400'000, 400'000 + 77);
+    ASSERT_EQ(77, estimator.offsetUs());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
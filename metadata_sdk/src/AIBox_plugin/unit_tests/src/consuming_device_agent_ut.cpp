@@ -0,0 +1,134 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nx/kit/test.h>
+#include <nx/sdk/analytics/helpers/consuming_device_agent.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
+#include <nx/sdk/helpers/device_info.h>
+#include <nx/sdk/ptr.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace nx::sdk;
+using namespace nx::sdk::analytics;
+
+static std::atomic<int> liveReleaseCountedPacketCount{0};
+
+class ReleaseCountedPacket: public ObjectMetadataPacket
+{
+public:
+    explicit ReleaseCountedPacket(int64_t timestampUs)
+    {
+        setTimestampUs(timestampUs);
+        ++liveReleaseCountedPacketCount;
+    }
+
+    virtual ~ReleaseCountedPacket() override { --liveReleaseCountedPacketCount; }
+};
+
+/** Records the timestamps of the delivered packets, as the Server would receive them. */
+class RecordingHandler: public RefCountable<IDeviceAgent::IHandler>
+{
+public:
+    virtual void handleMetadata(IMetadataPacket* metadataPacket) override
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_timestamps.push_back(metadataPacket->timestampUs());
+        m_condition.notify_all();
+    }
+
+    virtual void handlePluginDiagnosticEvent(IPluginDiagnosticEvent* /*event*/) override {}
+    virtual void pushManifest(const IString* /*manifest*/) override {}
+
+    std::vector<int64_t> waitForPackets(int packetCount)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]() { return (int) m_timestamps.size() >= packetCount; });
+        return m_timestamps;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<int64_t> m_timestamps;
+};
+
+class TestDeviceAgent: public ConsumingDeviceAgent
+{
+public:
+    explicit TestDeviceAgent(const IDeviceInfo* deviceInfo):
+        ConsumingDeviceAgent(deviceInfo, /*enableOutput*/ false)
+    {
+    }
+
+    using ConsumingDeviceAgent::enableAsyncMetadataDispatch;
+    using ConsumingDeviceAgent::pushMetadataPackets;
+
+protected:
+    virtual std::string manifestString() const override { return "{}"; }
+
+    virtual void doSetNeededMetadataTypes(
+        Result<void>* /*outResult*/, const IMetadataTypes* /*neededMetadataTypes*/) override
+    {
+    }
+};
+
+static std::vector<IMetadataPacket*> makePackets(int count)
+{
+    std::vector<IMetadataPacket*> packets;
+    for (int i = 0; i < count; ++i)
+        packets.push_back(new ReleaseCountedPacket(/*timestampUs*/ 1000 + i));
+    return packets;
+}
+
+static void pushAndCheckDelivery(bool isAsync)
+{
+    const auto deviceInfo = makePtr<DeviceInfo>();
+    const auto handler = makePtr<RecordingHandler>();
+    {
+        const auto deviceAgent = makePtr<TestDeviceAgent>(deviceInfo.get());
+        if (isAsync)
+            deviceAgent->enableAsyncMetadataDispatch(/*queueCapacity*/ 64, /*maxBatchSize*/ 4);
+        deviceAgent->setHandler(handler.get());
+
+        deviceAgent->pushMetadataPackets(makePackets(10));
+        deviceAgent->pushMetadataPackets({});
+        deviceAgent->pushMetadataPackets(makePackets(5));
+
+        const std::vector<int64_t> timestamps = handler->waitForPackets(15);
+        ASSERT_EQ(15, (int) timestamps.size());
+        for (int i = 0; i < 10; ++i)
+            ASSERT_EQ(1000 + i, timestamps[i]);
+        for (int i = 0; i < 5; ++i)
+            ASSERT_EQ(1000 + i, timestamps[10 + i]);
+
+        if (!isAsync) //< Otherwise, released by the dispatcher thread after the delivery.
+            ASSERT_EQ(0, liveReleaseCountedPacketCount.load());
+    }
+    ASSERT_EQ(0, liveReleaseCountedPacketCount.load());
+}
+
+TEST(consumingDeviceAgent, pushMetadataPackets)
+{
+    pushAndCheckDelivery(/*isAsync*/ false);
+}
+
+TEST(consumingDeviceAgent, pushMetadataPacketsAsync)
+{
+    pushAndCheckDelivery(/*isAsync*/ true);
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,116 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/device_agent_manifest.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/device_agent_settings.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+/** All the fields of the snapshot are set to the same value, so a torn read is visible. */
+static DeviceAgentSettings uniformSettings(int value)
+{
+    DeviceAgentSettings settings;
+    settings.generatedObjectClasses = (uint32_t) value;
+    settings.values.fill(value);
+    return settings;
+}
+
+static bool isUniform(const DeviceAgentSettings& settings)
+{
+    for (const int value: settings.values)
+    {
+        if (value != (int) settings.generatedObjectClasses)
+            return false;
+    }
+    return true;
+}
+
+TEST(deviceAgentSettings, parse)
+{
+    std::map<std::string, std::string> errors;
+    DeviceAgentSettings settings = DeviceAgentSettings::parse({
+        {"timestampShiftMs", " -250 "},
+        {"interpolateBoxes", "TRUE"},
+        {"maxPacketsPerSecond", "500"},
+        {"minBoxChange", "12abc"},
+        {"connectFirst", "maybe"},
+        {kObjectTypeGenerationSettingPrefix + kStringHuman, "True"},
+        {kObjectTypeGenerationSettingPrefix + kStringMotorVehicle, "false"},
+    }, &errors);
+
+    ASSERT_EQ(-250, settings.value(Setting::timestampShiftMs));
+    ASSERT_TRUE(settings.isEnabled(Setting::interpolateBoxes));
+    ASSERT_EQ(100, settings.value(Setting::maxPacketsPerSecond)); //< Clamped.
+    ASSERT_EQ(0, settings.value(Setting::minBoxChange)); //< Default.
+    ASSERT_FALSE(settings.isEnabled(Setting::connectFirst));
+    ASSERT_TRUE(settings.isGenerated(ObjectClass::human));
+    ASSERT_FALSE(settings.isGenerated(ObjectClass::motorVehicle));
+    ASSERT_FALSE(settings.isGenerated(ObjectClass::motorcycleBicycle));
+
+    ASSERT_EQ(3, (int) errors.size());
+    ASSERT_EQ(1, (int) errors.count("maxPacketsPerSecond"));
+    ASSERT_EQ(1, (int) errors.count("minBoxChange"));
+    ASSERT_EQ(1, (int) errors.count("connectFirst"));
+
+    errors.clear();
+    settings = DeviceAgentSettings::parse({}, &errors);
+    ASSERT_TRUE(errors.empty());
+    ASSERT_EQ(settingDescriptor(Setting::minBoxChange).defaultValue,
+        settings.value(Setting::minBoxChange));
+    ASSERT_EQ(0, (int) settings.generatedObjectClasses);
+}
+
+TEST(publishedDeviceAgentSettings, defaults)
+{
+    const PublishedDeviceAgentSettings publishedSettings;
+    const DeviceAgentSettings defaults;
+    ASSERT_TRUE(publishedSettings.load().values == defaults.values);
+    ASSERT_EQ(defaults.generatedObjectClasses, publishedSettings.load().generatedObjectClasses);
+
+    PublishedDeviceAgentSettings otherPublishedSettings;
+    otherPublishedSettings.publish(uniformSettings(7));
+    ASSERT_TRUE(isUniform(otherPublishedSettings.load()));
+    ASSERT_EQ(7, otherPublishedSettings.load().value(Setting::maxPacketsPerSecond));
+}
+
+TEST(publishedDeviceAgentSettings, noTornReads)
+{
+    PublishedDeviceAgentSettings publishedSettings;
+    publishedSettings.publish(uniformSettings(0));
+
+    std::atomic<bool> isStopped{false};
+    std::atomic<int> tornReadCount{0};
+    std::thread reader(
+        [&]()
+        {
+            while (!isStopped)
+            {
+                if (!isUniform(publishedSettings.load()))
+                    ++tornReadCount;
+            }
+        });
+
+    for (int i = 1; i <= 100'000; ++i)
+        publishedSettings.publish(uniformSettings(i));
+    isStopped = true;
+    reader.join();
+
+    ASSERT_EQ(0, tornReadCount.load());
+    ASSERT_EQ(100'000, publishedSettings.load().value(Setting::timestampShiftMs));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,57 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/duplicate_message_filter.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static PEAResult makeResult(int64_t currentTime, int x1)
+{
+    PEAResult result;
+    result.currentTime = currentTime;
+    result.deviceMac = "58:5b:69:00:00:01";
+    result.trajects.push_back(TrajectoryResult{"person", 1001, x1, 200, x1 + 800, 1200});
+    return result;
+}
+
+TEST(duplicateMessageFilter, resentMessage)
+{
+    DuplicateMessageFilter filter;
+    ASSERT_FALSE(filter.isDuplicate(makeResult(1000, 100)));
+    ASSERT_FALSE(filter.isDuplicate(makeResult(1000, 150))); //< Another box, same time.
+    ASSERT_FALSE(filter.isDuplicate(makeResult(1040, 100)));
+    ASSERT_TRUE(filter.isDuplicate(makeResult(1000, 100)));
+    ASSERT_TRUE(filter.isDuplicate(makeResult(1040, 100)));
+
+    filter.clear();
+    ASSERT_FALSE(filter.isDuplicate(makeResult(1000, 100)));
+}
+
+TEST(duplicateMessageFilter, noCameraTime)
+{
+    DuplicateMessageFilter filter;
+    ASSERT_FALSE(filter.isDuplicate(makeResult(0, 100)));
+    ASSERT_FALSE(filter.isDuplicate(makeResult(0, 100)));
+}
+
+TEST(duplicateMessageFilter, historyLimit)
+{
+    DuplicateMessageFilter filter;
+    for (int i = 0; i < 100; ++i)
+        ASSERT_FALSE(filter.isDuplicate(makeResult(1000 + i, 100)));
+
+    // Only the recent messages are remembered.
+    ASSERT_TRUE(filter.isDuplicate(makeResult(1099, 100)));
+    ASSERT_FALSE(filter.isDuplicate(makeResult(1000, 100)));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
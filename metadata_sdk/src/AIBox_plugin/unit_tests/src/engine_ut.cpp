@@ -0,0 +1,135 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/json.h>
+#include <nx/kit/test.h>
+#include <nx/sdk/helpers/device_info.h>
+#include <nx/sdk/ptr.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/engine.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace nx::sdk;
+
+static std::string manifest(const Engine* engine)
+{
+    const auto result = engine->manifest();
+    if (!result.isOk() || !result.value())
+        return "";
+    return Ptr<const IString>(result.value())->str();
+}
+
+static std::string writeManifestFile(const std::string& name, const std::string& contents)
+{
+    const std::string path = std::string(nx::kit::test::tempDir()) + name;
+    std::ofstream(path) << contents;
+    return path;
+}
+
+TEST(engine, manifestCache)
+{
+    const auto engine = makePtr<Engine>();
+
+    const std::string engineManifest = manifest(engine.get());
+    std::string error;
+    const nx::kit::Json json = nx::kit::Json::parse(engineManifest, error);
+    ASSERT_TRUE(error.empty());
+    ASSERT_TRUE(json["deviceAgentSettingsModel"]["items"].array_items().size() > 1);
+
+    // Served from the cache.
+    ASSERT_EQ(engineManifest, manifest(engine.get()));
+
+    // Rebuilt after a reload, to the same contents.
+    ASSERT_TRUE(EngineManifestHelper::loadManifests({writeManifestFile("cameras.json",
+        R"json({"supportedCameraVendors": ["Hanwha"], "supportedCameraModels": ["XNV-8080R"]})json")}));
+    ASSERT_EQ(engineManifest, manifest(engine.get()));
+}
+
+TEST(engine, manifestCacheConcurrentReload)
+{
+    const auto engine = makePtr<Engine>();
+    const std::string engineManifest = manifest(engine.get());
+    const std::string manifestPath = writeManifestFile("cameras.json",
+        R"json({"supportedCameraVendors": ["Hanwha"], "supportedCameraModels": ["XNV-8080R"]})json");
+
+    // The Server asks for the manifest on its threads while the manifests are being reloaded.
+    std::vector<std::thread> threads;
+    std::vector<int> mismatchCounts(4, 0);
+    for (int i = 0; i < (int) mismatchCounts.size(); ++i)
+    {
+        threads.emplace_back(
+            [&, i]()
+            {
+                for (int j = 0; j < 200; ++j)
+                {
+                    if (manifest(engine.get()) != engineManifest)
+                        ++mismatchCounts[i];
+                }
+            });
+    }
+    for (int i = 0; i < 50; ++i)
+        EngineManifestHelper::loadManifests({manifestPath});
+    for (auto& thread: threads)
+        thread.join();
+
+    for (const int mismatchCount: mismatchCounts)
+        ASSERT_EQ(0, mismatchCount);
+}
+
+static bool isCompatible(const Engine* engine, const std::string& vendor, const std::string& model)
+{
+    const auto deviceInfo = makePtr<DeviceInfo>();
+    deviceInfo->setVendor(vendor);
+    deviceInfo->setModel(model);
+    return engine->isCompatible(deviceInfo.get());
+}
+
+TEST(engine, isCompatible)
+{
+    const auto engine = makePtr<Engine>();
+    const std::string manifestPath = writeManifestFile("cameras.json",
+        R"json({"supportedCameraVendors": ["Hanwha"], "supportedCameraModels": ["XNV-8080R"]})json");
+    ASSERT_TRUE(EngineManifestHelper::loadManifests({manifestPath}));
+
+    ASSERT_TRUE(isCompatible(engine.get(), "Hanwha Vision", "XNV-8080R"));
+    ASSERT_TRUE(isCompatible(engine.get(), "Hanwha Vision", "XNV-8080R")); //< Cached.
+    ASSERT_FALSE(isCompatible(engine.get(), "Hanwha Vision", "XNV-6080R"));
+    ASSERT_FALSE(isCompatible(engine.get(), "Axis", "XNV-8080R"));
+
+    // The cached answers are dropped with the reloaded index.
+    writeManifestFile("cameras.json",
+        R"json({"supportedCameraVendors": ["Axis"], "supportedCameraModels": ["XNV-6080R"]})json");
+    ASSERT_TRUE(EngineManifestHelper::loadManifests({manifestPath}));
+    ASSERT_FALSE(isCompatible(engine.get(), "Hanwha Vision", "XNV-8080R"));
+    ASSERT_FALSE(isCompatible(engine.get(), "Hanwha Vision", "XNV-6080R"));
+    ASSERT_TRUE(isCompatible(engine.get(), "Axis", "XNV-6080R"));
+
+    EngineManifestHelper::clearManifest();
+    ASSERT_FALSE(isCompatible(engine.get(), "Axis", "XNV-6080R"));
+}
+
+TEST(engine, destroyingEngineKeepsManifests)
+{
+    const auto engine = makePtr<Engine>();
+    ASSERT_TRUE(EngineManifestHelper::loadManifests({writeManifestFile("cameras.json",
+        R"json({"supportedCameraVendors": ["Hanwha"], "supportedCameraModels": ["XNV-8080R"]})json")}));
+
+    // The Server may create the next Engine before destroying the previous one.
+    makePtr<Engine>().reset();
+    ASSERT_TRUE(isCompatible(engine.get(), "Hanwha Vision", "XNV-8080R"));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
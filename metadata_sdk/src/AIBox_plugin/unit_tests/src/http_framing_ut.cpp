@@ -0,0 +1,73 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <ostream>
+#include <string>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/net/http_framing.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static void write(asio::streambuf* buffer, const std::string& data)
+{
+    std::ostream(buffer) << data;
+}
+
+TEST(httpFraming, response)
+{
+    asio::streambuf buffer;
+    write(&buffer,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/xml\r\n"
+        "Content-Length:  5 \r\n"
+        "\r\n"
+        "<a/>\nPOST /next");
+
+    const HttpMessageHeader header = readHttpMessageHeader(&buffer);
+    ASSERT_EQ("HTTP/1.1 200 OK", header.firstLine);
+    ASSERT_EQ("200", header.statusCode);
+    ASSERT_EQ(5, (int) header.contentLength);
+
+    // Only the body is consumed; the next message stays in the buffer.
+    ASSERT_EQ("<a/>\n", readHttpMessageBody(&buffer, header.contentLength));
+    ASSERT_EQ(10, (int) buffer.size());
+}
+
+TEST(httpFraming, request)
+{
+    asio::streambuf buffer;
+    write(&buffer,
+        "POST /SendAlarmData HTTP/1.1\r\n"
+        "Content-Length: 3\r\n"
+        "Content-Length: 7\r\n"
+        "\r\n"
+        "abc");
+
+    const HttpMessageHeader header = readHttpMessageHeader(&buffer);
+    ASSERT_EQ("POST /SendAlarmData HTTP/1.1", header.firstLine);
+    ASSERT_EQ(3, (int) header.contentLength); //< The first field is taken.
+    ASSERT_EQ("abc", readHttpMessageBody(&buffer, header.contentLength));
+    ASSERT_EQ(0, (int) buffer.size());
+}
+
+TEST(httpFraming, noContentLength)
+{
+    asio::streambuf buffer;
+    write(&buffer, "HTTP/1.1 401\r\nContent-Length: abc\r\n\r\n");
+
+    const HttpMessageHeader header = readHttpMessageHeader(&buffer);
+    ASSERT_EQ("", header.statusCode); //< No reason phrase after the code.
+    ASSERT_EQ(0, (int) header.contentLength);
+    ASSERT_EQ(0, (int) buffer.size());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
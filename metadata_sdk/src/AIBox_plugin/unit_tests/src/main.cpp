@@ -0,0 +1,8 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+
+int main()
+{
+    return nx::kit::test::runAllTests("AIBox_ut");
+}
@@ -0,0 +1,99 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#if defined(__GNUC__) && __GNUC__ < 9
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#else
+#include <filesystem>
+namespace fs = std::filesystem;
+#endif
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/manifest_dir_watcher.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static constexpr int kPollIntervalMs = 100;
+static constexpr int kTimeoutMs = 5000;
+
+static void writeFile(const fs::path& path)
+{
+    std::ofstream(path.string()) << "{}";
+}
+
+/** @return Whether the change count has exceeded the given one within the timeout. */
+static bool waitForChange(const std::atomic<int>& changeCount, int previousChangeCount)
+{
+    using namespace std::chrono;
+    const auto deadline = steady_clock::now() + milliseconds(kTimeoutMs);
+    while (changeCount <= previousChangeCount && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(10));
+    return changeCount > previousChangeCount;
+}
+
+TEST(manifestDirWatcher, changes)
+{
+    const fs::path dir = fs::path(nx::kit::test::tempDir()) / "manifests";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    std::atomic<int> changeCount{0};
+    ManifestDirWatcher watcher(dir.string(), kPollIntervalMs, [&]() { ++changeCount; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs * 2));
+
+    int previousChangeCount = changeCount;
+    writeFile(dir / "camera.json");
+    ASSERT_TRUE(waitForChange(changeCount, previousChangeCount));
+
+    previousChangeCount = changeCount;
+    fs::remove(dir / "camera.json");
+    ASSERT_TRUE(waitForChange(changeCount, previousChangeCount));
+
+    // The dir is removed, and then re-created, e.g. on a plugin update.
+    previousChangeCount = changeCount;
+    fs::remove_all(dir);
+    ASSERT_TRUE(waitForChange(changeCount, previousChangeCount));
+
+    fs::create_directories(dir);
+    previousChangeCount = changeCount;
+    writeFile(dir / "camera.json");
+    ASSERT_TRUE(waitForChange(changeCount, previousChangeCount));
+
+    // The dir is replaced by another one at once.
+    const fs::path newDir = fs::path(nx::kit::test::tempDir()) / "newManifests";
+    fs::remove_all(newDir);
+    fs::create_directories(newDir);
+    writeFile(newDir / "camera.json");
+    previousChangeCount = changeCount;
+    fs::remove_all(dir);
+    fs::rename(newDir, dir);
+    ASSERT_TRUE(waitForChange(changeCount, previousChangeCount));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs * 5));
+    previousChangeCount = changeCount;
+    writeFile(dir / "other.json");
+    ASSERT_TRUE(waitForChange(changeCount, previousChangeCount));
+
+    // Other files are ignored.
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs * 5));
+    previousChangeCount = changeCount;
+    writeFile(dir / "notes.txt");
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs * 10));
+    ASSERT_EQ(previousChangeCount, changeCount.load());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,82 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/engine_manifest.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/manifest_index.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static ManifestIndex makeIndex()
+{
+    return ManifestIndex(
+        /*vendors*/ {"hanwha", "axis", "ax", "dahuatech"},
+        /*models*/ {"xnv-8080r", "p3245-lve"},
+        /*peaEvents*/ {EventType{"pea.line", "PEA", "Line crossing", false, 1}});
+}
+
+TEST(manifestIndex, vendorPrefixes)
+{
+    const ManifestIndex index = makeIndex();
+
+    ASSERT_TRUE(index.isVendorSupported("hanwha"));
+    ASSERT_TRUE(index.isVendorSupported("hanwhavision")); //< Starts with a supported vendor.
+    ASSERT_TRUE(index.isVendorSupported("axiscommunications"));
+    ASSERT_TRUE(index.isVendorSupported("ax"));
+    ASSERT_TRUE(index.isVendorSupported("axe")); //< The shorter of the nested vendors matches.
+    ASSERT_TRUE(index.isVendorSupported("dahuatech"));
+
+    ASSERT_FALSE(index.isVendorSupported("dahua")); //< A prefix of a vendor is not enough.
+    ASSERT_FALSE(index.isVendorSupported("a"));
+    ASSERT_FALSE(index.isVendorSupported("hikvision"));
+    ASSERT_FALSE(index.isVendorSupported("xhanwha"));
+    ASSERT_FALSE(index.isVendorSupported(""));
+}
+
+TEST(manifestIndex, models)
+{
+    const ManifestIndex index = makeIndex();
+
+    ASSERT_TRUE(index.isModelSupported("xnv-8080r"));
+    ASSERT_TRUE(index.isModelSupported("p3245-lve"));
+
+    // Models match exactly.
+    ASSERT_FALSE(index.isModelSupported("xnv-8080"));
+    ASSERT_FALSE(index.isModelSupported("xnv-8080r2"));
+    ASSERT_FALSE(index.isModelSupported(""));
+
+    ASSERT_EQ(1, (int) index.peaEvents().size());
+    ASSERT_EQ("pea.line", index.peaEvents()[0].id);
+}
+
+TEST(manifestIndex, empty)
+{
+    const ManifestIndex index;
+    ASSERT_FALSE(index.isVendorSupported(""));
+    ASSERT_FALSE(index.isVendorSupported("hanwha"));
+    ASSERT_FALSE(index.isModelSupported("xnv-8080r"));
+    ASSERT_TRUE(index.peaEvents().empty());
+
+    // The vendors are the empty set, not the empty prefix matching everything.
+    const ManifestIndex noVendorsIndex({}, {}, {});
+    ASSERT_FALSE(noVendorsIndex.isVendorSupported("hanwha"));
+}
+
+TEST(manifestIndex, normalization)
+{
+    // The queries are to be normalized the same way as the manifest entries.
+    const ManifestIndex index = makeIndex();
+    ASSERT_EQ("hanwhavision", EngineManifestHelper::toLowerSpaceless(" Hanwha \"Vision\"\t"));
+    ASSERT_TRUE(index.isVendorSupported(EngineManifestHelper::toLowerSpaceless("Hanwha Vision")));
+    ASSERT_TRUE(index.isModelSupported(EngineManifestHelper::toLowerSpaceless("XNV-8080R")));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,73 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <chrono>
+#include <cmath>
+
+#include <nx/kit/test.h>
+#include <nx/sdk/helpers/media_stream_statistics.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using nx::sdk::MediaStreamStatistics;
+
+TEST(mediaStreamStatistics, slidingWindow)
+{
+    using namespace std::chrono;
+
+    // 25 fps, a key frame every second, 1000 bytes per frame.
+    MediaStreamStatistics statistics(seconds(2));
+    ASSERT_FALSE(statistics.hasMediaData());
+    int64_t timestampUs = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        statistics.onData(microseconds(timestampUs), 1000, i % 25 == 0);
+        timestampUs += 40000;
+    }
+    ASSERT_TRUE(statistics.hasMediaData());
+
+    // The window holds 51 frames over 2 s; the newest frame is not in the bitrate.
+    ASSERT_EQ(25, (int) std::lround(statistics.getFrameRate()));
+    ASSERT_EQ(50 * 1000 * 8 / 2, (int) statistics.bitrateBitsPerSecond());
+    ASSERT_EQ(51 / 2.0F, statistics.getAverageGopSize()); //< Key frames 50 and 75.
+
+    // A step back in the stream time restarts the statistics.
+    statistics.onData(microseconds(0), 1000, true);
+    ASSERT_EQ(0, (int) statistics.getFrameRate());
+    ASSERT_EQ(1, (int) statistics.getAverageGopSize());
+
+    statistics.setMaxDurationInFrames(3);
+    for (int i = 1; i <= 10; ++i)
+        statistics.onData(microseconds(i * 40000), 1000, false);
+    ASSERT_EQ(25, (int) std::lround(statistics.getFrameRate()));
+    ASSERT_EQ(2 * 1000 * 8 * 1'000'000LL / 80000, statistics.bitrateBitsPerSecond());
+}
+
+TEST(mediaStreamStatistics, staleness)
+{
+    using namespace std::chrono;
+
+    MediaStreamStatistics statistics(seconds(1));
+    ASSERT_EQ(1'000'000, statistics.windowSize().count());
+    const microseconds now = duration_cast<microseconds>(steady_clock::now().time_since_epoch());
+    ASSERT_TRUE(statistics.isStale(now)); //< No data yet.
+
+    statistics.onData(microseconds(0), 1000, true);
+    const microseconds dataTime =
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch());
+    ASSERT_FALSE(statistics.isStale(dataTime));
+    ASSERT_FALSE(statistics.isStale(dataTime + seconds(1) - milliseconds(100)));
+    ASSERT_TRUE(statistics.isStale(dataTime + seconds(1) + milliseconds(100)));
+
+    statistics.reset();
+    ASSERT_TRUE(statistics.isStale(dataTime));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,211 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/message_latency_tracker.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metrics.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static const std::string kPrefix = "test.latency.";
+
+TEST(latencyHistogram, percentiles)
+{
+    LatencyHistogram histogram;
+    ASSERT_EQ(0, histogram.percentileUs(50));
+    ASSERT_EQ(0, histogram.count());
+
+    for (int64_t value = 1; value <= 100; ++value)
+        histogram.record(value * 1000);
+    ASSERT_EQ(100, histogram.count());
+    ASSERT_EQ(100'000, histogram.maxUs());
+
+    // The bucket math is tested in nx_kit; here, it is only checked to be used as documented:
+    // the nearest rank, rounded down to the bucket bound, within 1/8 below the exact value.
+    const auto isNear =
+        [](int64_t actual, int64_t exact) { return actual <= exact && actual * 8 >= exact * 7; };
+    ASSERT_TRUE(isNear(histogram.percentileUs(50), 50'000));
+    ASSERT_TRUE(isNear(histogram.percentileUs(90), 90'000));
+    ASSERT_TRUE(isNear(histogram.percentileUs(99), 99'000));
+    ASSERT_TRUE(isNear(histogram.percentileUs(100), 100'000));
+    ASSERT_EQ(960, histogram.percentileUs(0)); //< The rank is at least 1: the bucket of 1000.
+
+    LatencyHistogram negative;
+    negative.record(-5);
+    ASSERT_EQ(0, negative.percentileUs(50));
+    ASSERT_EQ(0, negative.maxUs());
+}
+
+TEST(latencyHistogram, concurrentRecording)
+{
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back(
+            [&histogram, i]()
+            {
+                for (int j = 0; j < 10'000; ++j)
+                    histogram.record(i * 1000 + j % 100);
+            });
+    }
+    for (auto& thread: threads)
+        thread.join();
+
+    ASSERT_EQ(40'000, histogram.count());
+    ASSERT_EQ(3099, histogram.maxUs());
+    ASSERT_EQ(0, histogram.percentileUs(0));
+}
+
+static MessageTiming timing(int64_t receivedUs, int64_t receivedSystemUs, int64_t parsedUs)
+{
+    MessageTiming result;
+    result.receivedUs = receivedUs;
+    result.receivedSystemUs = receivedSystemUs;
+    result.parsedUs = parsedUs;
+    return result;
+}
+
+static LatencyHistogram& histogram(const std::string& stage)
+{
+    return Metrics::instance().histogram(kPrefix + "latency." + stage + "Us");
+}
+
+static int64_t metric(const std::string& name)
+{
+    return Metrics::instance().value(kPrefix + "latency." + name).load();
+}
+
+TEST(messageLatencyTracker, stages)
+{
+    MessageLatencyTracker tracker("test", kPrefix, /*maxClockOffsetUs*/ 0, /*maxNetworkDelayUs*/ 0);
+
+    // Camera clock 1'000'000 behind; the message arrives 3000 after its camera time.
+    tracker.record(timing(/*receivedUs*/ 10'000, /*receivedSystemUs*/ 5'004'000, 10'500),
+        /*cameraTimeUs*/ 4'001'000, /*clockOffsetUs*/ 1'000'000,
+        /*builtUs*/ 10'700, /*pushedUs*/ 11'000);
+    ASSERT_EQ(1, histogram("network").count());
+    ASSERT_EQ(3000, histogram("network").maxUs());
+    ASSERT_EQ(1'000'000, metric("clockOffsetUs"));
+    ASSERT_EQ(500, histogram("parse").maxUs());
+    ASSERT_EQ(200, histogram("build").maxUs());
+    ASSERT_EQ(300, histogram("push").maxUs());
+    ASSERT_EQ(1000, histogram("plugin").maxUs());
+
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(messageLatencyTracker, skippedStages)
+{
+    MessageLatencyTracker tracker("test", kPrefix, /*maxClockOffsetUs*/ 0, /*maxNetworkDelayUs*/ 0);
+
+    // Not received from a socket: nothing to account.
+    tracker.record(timing(0, 5'000'000, 10'500), 4'000'000, 0, 10'700, 11'000);
+    ASSERT_EQ(0, histogram("network").count());
+    ASSERT_EQ(0, histogram("parse").count());
+
+    // No camera time: no network stage.
+    tracker.record(timing(10'000, 5'000'000, 10'500), /*cameraTimeUs*/ 0, 0, 10'700, 11'000);
+    ASSERT_EQ(0, histogram("network").count());
+    ASSERT_EQ(1, histogram("parse").count());
+
+    // No packet made of the message: only the parsing is accounted.
+    tracker.record(timing(10'000, 5'000'000, 10'500), 4'999'000, 0,
+        /*builtUs*/ 0, /*pushedUs*/ 0);
+    ASSERT_EQ(1, histogram("network").count());
+    ASSERT_EQ(2, histogram("parse").count());
+    ASSERT_EQ(1, histogram("build").count());
+    ASSERT_EQ(1, histogram("push").count());
+    ASSERT_EQ(1, histogram("plugin").count());
+
+    // Built, but not pushed.
+    tracker.record(timing(10'000, 5'000'000, 10'500), 4'999'000, 0,
+        /*builtUs*/ 10'700, /*pushedUs*/ 0);
+    ASSERT_EQ(3, histogram("parse").count());
+    ASSERT_EQ(2, histogram("build").count());
+    ASSERT_EQ(1, histogram("push").count());
+    ASSERT_EQ(1, histogram("plugin").count());
+
+    // Not parsed: neither parse nor build stage.
+    tracker.record(timing(10'000, 5'000'000, /*parsedUs*/ 0), 4'999'000, 0, 10'700, 11'000);
+    ASSERT_EQ(3, histogram("parse").count());
+    ASSERT_EQ(2, histogram("build").count());
+    ASSERT_EQ(2, histogram("push").count());
+
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(messageLatencyTracker, flags)
+{
+    MessageLatencyTracker tracker("test", kPrefix,
+        /*maxClockOffsetUs*/ 2'000'000, /*maxNetworkDelayUs*/ 500'000);
+    const auto record =
+        [&tracker](int64_t clockOffsetUs, int64_t networkUs)
+        {
+            const int64_t cameraTimeUs = 4'000'000;
+            tracker.record(
+                timing(10'000, cameraTimeUs + clockOffsetUs + networkUs, 10'500),
+                cameraTimeUs, clockOffsetUs, 10'700, 11'000);
+        };
+
+    record(0, 0);
+    ASSERT_EQ(0, metric("clockOffsetExceeded"));
+    ASSERT_EQ(0, metric("networkDelayExceeded"));
+
+    // At the threshold is not above it.
+    record(2'000'000, 500'000);
+    ASSERT_EQ(0, metric("clockOffsetExceeded"));
+    ASSERT_EQ(0, metric("networkDelayExceeded"));
+
+    // Raised independently, by the magnitude of the offset.
+    record(-2'000'001, 0);
+    ASSERT_EQ(1, metric("clockOffsetExceeded"));
+    ASSERT_EQ(0, metric("networkDelayExceeded"));
+    record(-2'000'001, 500'001);
+    ASSERT_EQ(1, metric("clockOffsetExceeded"));
+    ASSERT_EQ(1, metric("networkDelayExceeded"));
+
+    // Kept while exceeded, cleared once back within.
+    record(3'000'000, 600'000);
+    ASSERT_EQ(1, metric("clockOffsetExceeded"));
+    ASSERT_EQ(1, metric("networkDelayExceeded"));
+    record(1'000'000, 600'000);
+    ASSERT_EQ(0, metric("clockOffsetExceeded"));
+    ASSERT_EQ(1, metric("networkDelayExceeded"));
+    record(1'000'000, 100'000);
+    ASSERT_EQ(0, metric("clockOffsetExceeded"));
+    ASSERT_EQ(0, metric("networkDelayExceeded"));
+
+    // The messages without the camera time do not touch the flags.
+    record(3'000'000, 600'000);
+    tracker.record(timing(10'000, 5'000'000, 10'500), /*cameraTimeUs*/ 0, 0, 10'700, 11'000);
+    ASSERT_EQ(1, metric("clockOffsetExceeded"));
+    ASSERT_EQ(1, metric("networkDelayExceeded"));
+
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(messageLatencyTracker, noThresholds)
+{
+    MessageLatencyTracker tracker("test", kPrefix, /*maxClockOffsetUs*/ 0, /*maxNetworkDelayUs*/ 0);
+    tracker.record(timing(10'000, 100'000'000, 10'500), 4'000'000, 50'000'000, 10'700, 11'000);
+    ASSERT_EQ(0, metric("clockOffsetExceeded"));
+    ASSERT_EQ(0, metric("networkDelayExceeded"));
+
+    Metrics::instance().removeAll(kPrefix);
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,226 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/sdk/analytics/helpers/metadata_dispatcher.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace nx::sdk::analytics;
+
+static std::atomic<int> livePacketCount{0};
+
+class CountedPacket: public ObjectMetadataPacket
+{
+public:
+    explicit CountedPacket(int64_t timestampUs)
+    {
+        setTimestampUs(timestampUs);
+        ++livePacketCount;
+    }
+
+    virtual ~CountedPacket() override { --livePacketCount; }
+};
+
+/** Records the delivered timestamps; can hold the dispatcher thread in the handler. */
+class Receiver
+{
+public:
+    MetadataDispatcher::BatchHandler handler()
+    {
+        return
+            [this](const std::vector<IMetadataPacket*>& packets)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_maxBatchSize = std::max(m_maxBatchSize, (int) packets.size());
+                for (const IMetadataPacket* packet: packets)
+                    m_timestamps.push_back(packet->timestampUs());
+                ++m_batchCount;
+                m_condition.notify_all();
+                m_condition.wait(lock, [this]() { return !m_isHeld; });
+            };
+    }
+
+    void hold(bool isHeld)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_isHeld = isHeld;
+        m_condition.notify_all();
+    }
+
+    void waitForBatches(int batchCount)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]() { return m_batchCount >= batchCount; });
+    }
+
+    void waitForPackets(int packetCount)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]() { return (int) m_timestamps.size() >= packetCount; });
+    }
+
+    std::vector<int64_t> timestamps()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_timestamps;
+    }
+
+    int maxBatchSize()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_maxBatchSize;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<int64_t> m_timestamps;
+    int m_batchCount = 0;
+    int m_maxBatchSize = 0;
+    bool m_isHeld = false;
+};
+
+TEST(metadataDispatcher, deliveryOrder)
+{
+    Receiver receiver;
+    {
+        MetadataDispatcher dispatcher(/*capacity*/ 64, /*maxBatchSize*/ 4, receiver.handler());
+        for (int i = 0; i < 1000; ++i)
+        {
+            // Keep the queue from overflowing: no more than 60 packets are undelivered.
+            while (receiver.timestamps().size() + 60 < (size_t) i)
+                std::this_thread::yield();
+            ASSERT_TRUE(dispatcher.push(new CountedPacket(i)));
+        }
+        receiver.waitForPackets(1000);
+        ASSERT_EQ(0, dispatcher.droppedCount());
+    }
+
+    const std::vector<int64_t> timestamps = receiver.timestamps();
+    ASSERT_EQ(1000, (int) timestamps.size());
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(i, timestamps[i]);
+    ASSERT_TRUE(receiver.maxBatchSize() <= 4);
+    ASSERT_EQ(0, livePacketCount.load());
+}
+
+TEST(metadataDispatcher, multipleProducers)
+{
+    static constexpr int kProducerCount = 4;
+    static constexpr int kPacketsPerProducer = 2000;
+
+    Receiver receiver;
+    int64_t droppedCount = 0;
+    {
+        MetadataDispatcher dispatcher(/*capacity*/ 256, /*maxBatchSize*/ 16, receiver.handler());
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < kProducerCount; ++producer)
+        {
+            producers.emplace_back(
+                [&dispatcher, producer]()
+                {
+                    for (int i = 0; i < kPacketsPerProducer; ++i)
+                        dispatcher.push(new CountedPacket(producer * kPacketsPerProducer + i));
+                });
+        }
+        for (auto& producer: producers)
+            producer.join();
+
+        droppedCount = dispatcher.droppedCount();
+        receiver.waitForPackets(kProducerCount * kPacketsPerProducer - (int) droppedCount);
+    }
+
+    // Each delivered packet is delivered once, and in the order of its producer.
+    const std::vector<int64_t> timestamps = receiver.timestamps();
+    ASSERT_EQ(kProducerCount * kPacketsPerProducer, (int) (timestamps.size() + droppedCount));
+    std::vector<int64_t> lastTimestamps(kProducerCount, -1);
+    for (const int64_t timestamp: timestamps)
+    {
+        const int producer = (int) (timestamp / kPacketsPerProducer);
+        ASSERT_TRUE(timestamp > lastTimestamps[producer]);
+        lastTimestamps[producer] = timestamp;
+    }
+    ASSERT_EQ(0, livePacketCount.load());
+}
+
+TEST(metadataDispatcher, queueFull)
+{
+    Receiver receiver;
+    receiver.hold(true);
+    {
+        MetadataDispatcher dispatcher(/*capacity*/ 8, /*maxBatchSize*/ 8, receiver.handler());
+
+        // The dispatcher thread takes the first packet and is held in the handler.
+        ASSERT_TRUE(dispatcher.push(new CountedPacket(0)));
+        receiver.waitForBatches(1);
+
+        for (int i = 1; i <= 8; ++i)
+            ASSERT_TRUE(dispatcher.push(new CountedPacket(i)));
+        ASSERT_EQ(9, livePacketCount.load());
+
+        // The dropped packet is released at once.
+        ASSERT_FALSE(dispatcher.push(new CountedPacket(9)));
+        ASSERT_FALSE(dispatcher.push(new CountedPacket(10)));
+        ASSERT_EQ(2, dispatcher.droppedCount());
+        ASSERT_EQ(9, livePacketCount.load());
+
+        receiver.hold(false);
+        receiver.waitForPackets(9);
+
+        // There is room again.
+        ASSERT_TRUE(dispatcher.push(new CountedPacket(11)));
+        receiver.waitForPackets(10);
+    }
+
+    const std::vector<int64_t> timestamps = receiver.timestamps();
+    ASSERT_EQ(10, (int) timestamps.size());
+    ASSERT_EQ(11, timestamps.back());
+    ASSERT_EQ(0, livePacketCount.load());
+}
+
+TEST(metadataDispatcher, undeliveredPacketsReleased)
+{
+    Receiver receiver;
+    receiver.hold(true);
+    std::thread releasingThread;
+    {
+        MetadataDispatcher dispatcher(/*capacity*/ 16, /*maxBatchSize*/ 1, receiver.handler());
+        ASSERT_TRUE(dispatcher.push(new CountedPacket(0)));
+        receiver.waitForBatches(1);
+        for (int i = 1; i < 16; ++i)
+            ASSERT_TRUE(dispatcher.push(new CountedPacket(i)));
+
+        // Let the dispatcher thread go while the destructor is already waiting for it.
+        releasingThread = std::thread(
+            [&receiver]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                receiver.hold(false);
+            });
+    }
+    releasingThread.join();
+
+    ASSERT_TRUE(receiver.timestamps().size() < 16);
+    ASSERT_EQ(0, livePacketCount.load());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,131 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <string>
+#include <vector>
+
+#include <nx/kit/test.h>
+#include <nx/sdk/helpers/uuid_helper.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metadata_packet_builder.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using nx::sdk::Ptr;
+using nx::sdk::analytics::IObjectMetadata;
+using nx::sdk::analytics::IObjectMetadataPacket;
+using nx::sdk::analytics::ObjectBox;
+using nx::sdk::analytics::ObjectMetadataPool;
+using nx::sdk::analytics::Rect;
+namespace UuidHelper = nx::sdk::UuidHelper;
+
+static const std::string kTypeId = "nx.base.Person";
+static const std::string kOtherTypeId = "nx.base.Car";
+
+static int itemCount(const Ptr<nx::sdk::analytics::IMetadataPacket>& metadataPacket)
+{
+    if (!metadataPacket)
+        return 0;
+    const auto objectMetadataPacket = metadataPacket->queryInterface<IObjectMetadataPacket>();
+    return objectMetadataPacket ? objectMetadataPacket->count() : -1;
+}
+
+TEST(objectMetadataPacket, addItems)
+{
+    std::vector<ObjectBox> objectBoxes(3);
+    for (int i = 0; i < (int) objectBoxes.size(); ++i)
+    {
+        objectBoxes[i].typeId = i % 2 == 0 ? kTypeId.c_str() : kOtherTypeId.c_str();
+        objectBoxes[i].trackId = UuidHelper::randomUuid();
+        objectBoxes[i].boundingBox = Rect(0.1F * i, 0.2F, 0.3F, 0.4F);
+        objectBoxes[i].confidence = 0.5F;
+    }
+
+    ObjectMetadataPool pool;
+    const auto metadataPacket = pool.makeObjectMetadataPacket();
+    metadataPacket->addItem(pool.makeObjectMetadata().get());
+    metadataPacket->addItems(objectBoxes.data(), (int) objectBoxes.size(), &pool);
+    ASSERT_EQ(4, metadataPacket->count());
+
+    for (int i = 0; i < (int) objectBoxes.size(); ++i)
+    {
+        const Ptr<const IObjectMetadata> objectMetadata = metadataPacket->at(i + 1);
+        ASSERT_TRUE(objectMetadata);
+        ASSERT_STREQ(objectBoxes[i].typeId, objectMetadata->typeId());
+        ASSERT_TRUE(objectBoxes[i].trackId == objectMetadata->trackId());
+        ASSERT_EQ(objectBoxes[i].boundingBox.x, objectMetadata->boundingBox().x);
+        ASSERT_EQ(0.5F, objectMetadata->confidence());
+    }
+
+    // The null array is accepted when empty; without a pool, the items are allocated.
+    metadataPacket->addItems(nullptr, 0, &pool);
+    metadataPacket->addItems(objectBoxes.data(), 1, /*pool*/ nullptr);
+    ASSERT_EQ(5, metadataPacket->count());
+    ASSERT_STREQ(objectBoxes[0].typeId, metadataPacket->at(4)->typeId());
+}
+
+TEST(metadataPacketBuilder, pendingTracks)
+{
+    TrackTable trackTable;
+    TrackChangeDetector changeDetector; //< Disabled: every updated track is sent.
+    MetadataPacketBuilder packetBuilder;
+
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 1000, Rect(0.1F, 0.1F, 0.2F, 0.2F));
+    trackTable.update(2, &kTypeId, UuidHelper::randomUuid(), 1000, Rect(0.5F, 0.1F, 0.2F, 0.2F));
+    const auto metadataPacket = packetBuilder.buildPendingPacket(
+        &trackTable, &changeDetector, 1000, /*durationUs*/ 40000);
+    ASSERT_EQ(2, itemCount(metadataPacket));
+    ASSERT_EQ(1000, metadataPacket->timestampUs());
+    ASSERT_FALSE(trackTable.hasPendingTracks());
+
+    // Only the updated track; no packet if none is.
+    trackTable.update(2, &kTypeId, UuidHelper::randomUuid(), 2000, Rect(0.6F, 0.1F, 0.2F, 0.2F));
+    ASSERT_EQ(1, itemCount(packetBuilder.buildPendingPacket(
+        &trackTable, &changeDetector, 2000, 40000)));
+    ASSERT_TRUE(!packetBuilder.buildPendingPacket(&trackTable, &changeDetector, 3000, 40000));
+}
+
+TEST(metadataPacketBuilder, suppressedAndFullRefresh)
+{
+    TrackTable trackTable;
+    TrackChangeDetector changeDetector;
+    changeDetector.setMinBoxChange(0.125F);
+    changeDetector.setFullRefreshIntervalUs(10'000);
+    MetadataPacketBuilder packetBuilder;
+
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 1000, Rect(0.25F, 0.25F, 0.5F, 0.5F));
+    ASSERT_EQ(1, itemCount(packetBuilder.buildPendingPacket(
+        &trackTable, &changeDetector, 1000, 40000)));
+
+    // A change below the threshold is skipped, until the full refresh.
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 2000, Rect(0.26F, 0.25F, 0.5F, 0.5F));
+    ASSERT_TRUE(!packetBuilder.buildPendingPacket(&trackTable, &changeDetector, 2000, 40000));
+    ASSERT_FALSE(trackTable.hasPendingTracks());
+    ASSERT_EQ(1, itemCount(packetBuilder.buildPendingPacket(
+        &trackTable, &changeDetector, 11'000, 40000)));
+}
+
+TEST(metadataPacketBuilder, interpolated)
+{
+    TrackTable trackTable;
+    TrackChangeDetector changeDetector;
+    MetadataPacketBuilder packetBuilder;
+
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 1000, Rect(0.1F, 0.1F, 0.2F, 0.2F));
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 2000, Rect(0.3F, 0.1F, 0.2F, 0.2F));
+    ASSERT_EQ(1, itemCount(packetBuilder.buildInterpolatedPacket(
+        &trackTable, &changeDetector, 2500, 40000, /*maxExtrapolationUs*/ 1000)));
+
+    // Not predicted too far after the last camera update.
+    ASSERT_TRUE(!packetBuilder.buildInterpolatedPacket(
+        &trackTable, &changeDetector, 5000, 40000, /*maxExtrapolationUs*/ 1000));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,46 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metadata_rate_governor.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+TEST(metadataRateGovernor, unlimited)
+{
+    MetadataRateGovernor governor;
+    ASSERT_FALSE(governor.isLimited());
+    ASSERT_EQ(-1, governor.packetDurationUs());
+    for (int i = 0; i < 10; ++i)
+        ASSERT_TRUE(governor.tryAcquire(1000 + i));
+}
+
+TEST(metadataRateGovernor, limited)
+{
+    MetadataRateGovernor governor;
+    governor.setMaxPacketsPerSecond(10);
+    ASSERT_TRUE(governor.isLimited());
+    ASSERT_EQ(100'000, governor.packetDurationUs());
+
+    ASSERT_TRUE(governor.tryAcquire(1'000'000));
+    ASSERT_FALSE(governor.tryAcquire(1'050'000));
+    ASSERT_FALSE(governor.tryAcquire(1'099'999));
+    ASSERT_TRUE(governor.tryAcquire(1'100'000));
+
+    // The refused attempts do not postpone the next allowed packet.
+    ASSERT_FALSE(governor.tryAcquire(1'150'000));
+    ASSERT_TRUE(governor.tryAcquire(1'200'000));
+
+    governor.setMaxPacketsPerSecond(0);
+    ASSERT_TRUE(governor.tryAcquire(1'200'001));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
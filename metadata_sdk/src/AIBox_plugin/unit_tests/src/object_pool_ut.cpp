@@ -0,0 +1,223 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/sdk/analytics/helpers/object_pool.h>
+#include <nx/sdk/analytics/helpers/pooled_object_metadata.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace nx::sdk;
+using namespace nx::sdk::analytics;
+
+static std::atomic<int> liveObjectCount{0};
+
+class CountedObjectMetadata: public ObjectMetadata
+{
+public:
+    CountedObjectMetadata() { ++liveObjectCount; }
+    virtual ~CountedObjectMetadata() override { --liveObjectCount; }
+};
+
+using PooledObject = Pooled<CountedObjectMetadata>;
+
+TEST(objectPool, reuse)
+{
+    const auto pool = std::make_shared<PooledObject::Pool>();
+    {
+        PooledObject* const object = PooledObject::acquire(pool);
+        object->setTypeId("person");
+        object->setConfidence(0.5F);
+        object->releaseRef();
+        ASSERT_EQ(1, pool->freeObjectCount());
+
+        PooledObject* const reused = PooledObject::acquire(pool);
+        ASSERT_EQ(object, reused);
+        ASSERT_EQ(0, pool->freeObjectCount());
+        ASSERT_STREQ("", reused->typeId()); //< Cleared before getting to the pool.
+
+        // Only the last reference returns the object.
+        reused->addRef();
+        ASSERT_EQ(1, reused->releaseRef());
+        ASSERT_EQ(0, pool->freeObjectCount());
+        ASSERT_EQ(0, reused->releaseRef());
+        ASSERT_EQ(1, pool->freeObjectCount());
+    }
+    pool->drain();
+    ASSERT_EQ(0, liveObjectCount.load());
+}
+
+TEST(objectPool, maxFreeObjects)
+{
+    const auto pool = std::make_shared<PooledObject::Pool>(/*maxFreeObjects*/ 1);
+    PooledObject* const object1 = PooledObject::acquire(pool);
+    PooledObject* const object2 = PooledObject::acquire(pool);
+    ASSERT_EQ(2, liveObjectCount.load());
+
+    object1->releaseRef();
+    object2->releaseRef(); //< Deleted, the pool being full.
+    ASSERT_EQ(1, pool->freeObjectCount());
+    ASSERT_EQ(1, liveObjectCount.load());
+
+    pool->drain();
+    ASSERT_EQ(0, liveObjectCount.load());
+}
+
+TEST(objectPool, crossThreadRelease)
+{
+    const auto pool = std::make_shared<PooledObject::Pool>();
+    PooledObject* const object = PooledObject::acquire(pool);
+
+    std::thread([object]() { object->releaseRef(); }).join();
+    ASSERT_EQ(1, pool->freeObjectCount());
+    ASSERT_EQ(object, PooledObject::acquire(pool));
+
+    // Many objects acquired and released on different threads.
+    static constexpr int kObjectCount = 1000;
+    std::vector<PooledObject*> objects{object};
+    while ((int) objects.size() < kObjectCount)
+        objects.push_back(PooledObject::acquire(pool));
+
+    std::thread releasingThread(
+        [&objects]()
+        {
+            for (int i = 0; i < kObjectCount; i += 2)
+                objects[i]->releaseRef();
+        });
+    for (int i = 1; i < kObjectCount; i += 2)
+        objects[i]->releaseRef();
+    releasingThread.join();
+
+    ASSERT_EQ(kObjectCount, pool->freeObjectCount());
+    ASSERT_EQ(kObjectCount, liveObjectCount.load());
+    pool->drain();
+    ASSERT_EQ(0, liveObjectCount.load());
+}
+
+TEST(objectPool, concurrentAcquireAndRelease)
+{
+    const auto pool = std::make_shared<PooledObject::Pool>();
+    static constexpr int kBatchCount = 2000;
+    static constexpr int kBatchSize = 10;
+
+    // The producer hands the objects over to the releasing thread, as to the Server.
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<PooledObject*> handedObjects;
+    bool isProducerDone = false;
+    std::thread releasingThread(
+        [&]()
+        {
+            for (;;)
+            {
+                std::vector<PooledObject*> objects;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(
+                        lock, [&]() { return isProducerDone || !handedObjects.empty(); });
+                    if (handedObjects.empty())
+                        return;
+                    objects.swap(handedObjects);
+                }
+                for (PooledObject* const object: objects)
+                    object->releaseRef();
+            }
+        });
+
+    for (int i = 0; i < kBatchCount; ++i)
+    {
+        std::vector<PooledObject*> objects;
+        for (int j = 0; j < kBatchSize; ++j)
+            objects.push_back(PooledObject::acquire(pool));
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            handedObjects.insert(handedObjects.end(), objects.begin(), objects.end());
+        }
+        condition.notify_one();
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        isProducerDone = true;
+    }
+    condition.notify_one();
+    releasingThread.join();
+
+    // Every object has got back to the pool, and the objects have been reused.
+    ASSERT_EQ(liveObjectCount.load(), pool->freeObjectCount());
+    ASSERT_TRUE(liveObjectCount.load() < kBatchCount * kBatchSize);
+    pool->drain();
+    ASSERT_EQ(0, liveObjectCount.load());
+}
+
+TEST(objectPool, drain)
+{
+    std::weak_ptr<PooledObject::Pool> weakPool;
+    PooledObject* outstandingObject = nullptr;
+    {
+        const auto pool = std::make_shared<PooledObject::Pool>();
+        weakPool = pool;
+        PooledObject::acquire(pool)->releaseRef();
+        outstandingObject = PooledObject::acquire(pool);
+        PooledObject::acquire(pool)->releaseRef();
+        ASSERT_EQ(1, pool->freeObjectCount());
+        ASSERT_EQ(2, liveObjectCount.load());
+
+        pool->drain(); //< As done by the owner on its destruction.
+        ASSERT_EQ(0, pool->freeObjectCount());
+        ASSERT_EQ(1, liveObjectCount.load());
+    }
+
+    // The object in use keeps the pool alive, and is deleted instead of being returned to it.
+    ASSERT_FALSE(weakPool.expired());
+    outstandingObject->releaseRef();
+    ASSERT_TRUE(weakPool.expired());
+    ASSERT_EQ(0, liveObjectCount.load());
+}
+
+TEST(objectPool, objectMetadataPool)
+{
+    Ptr<ObjectMetadataPacket> outstandingPacket;
+    {
+        ObjectMetadataPool pool;
+
+        auto packet = pool.makeObjectMetadataPacket();
+        packet->setTimestampUs(1000);
+        packet->setDurationUs(40000);
+        packet->setFlags(ObjectMetadataPacket::Flags::cameraClockTimestamp);
+        const auto objectMetadata = pool.makeObjectMetadata();
+        packet->addItem(objectMetadata.get());
+        IObjectMetadataPacket* const packetAddress = packet.get();
+        packet.reset();
+
+        packet = pool.makeObjectMetadataPacket();
+        ASSERT_EQ(packetAddress, packet.get());
+        ASSERT_EQ(0, packet->count());
+        ASSERT_EQ(-1, packet->timestampUs());
+        ASSERT_EQ(-1, packet->durationUs());
+        ASSERT_TRUE(packet->flags() == ObjectMetadataPacket::Flags::none);
+
+        packet->addItem(pool.makeObjectMetadata().get());
+        outstandingPacket = packet;
+    }
+
+    // Released after the pool owner is gone, e.g. by the Server.
+    ASSERT_EQ(1, outstandingPacket->count());
+    outstandingPacket.reset();
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
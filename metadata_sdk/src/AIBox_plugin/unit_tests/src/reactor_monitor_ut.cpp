@@ -0,0 +1,128 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <string>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metrics.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/reactor_monitor.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static const std::string kPrefix = "test.reactor.";
+static constexpr int64_t kThresholdUs = 100'000;
+static constexpr int64_t kStartUs = 1'000'000'000;
+
+static int64_t metric(const std::string& name)
+{
+    return Metrics::instance().value(kPrefix + name).load();
+}
+
+TEST(reactorMonitor, thresholds)
+{
+    ReactorMonitor monitor(kThresholdUs, kPrefix);
+    std::vector<std::string> reports;
+    monitor.addStallHandler([&](const std::string& report) { reports.push_back(report); });
+
+    // Exactly at the threshold is not a stall yet.
+    monitor.reportProbeLag(kThresholdUs, kStartUs);
+    monitor.reportHandler("test.handler", kThresholdUs, kStartUs);
+    ASSERT_EQ(0, metric("stalls"));
+    ASSERT_EQ(0, metric("slowHandlers"));
+    ASSERT_TRUE(reports.empty());
+    ASSERT_EQ(1, Metrics::instance().histogram(kPrefix + "probeLagUs").count());
+
+    monitor.reportProbeLag(kThresholdUs + 1, kStartUs);
+    ASSERT_EQ(1, metric("stalls"));
+    ASSERT_EQ(1, (int) reports.size());
+    ASSERT_EQ("Camera I/O thread was blocked for 100 ms", reports.back());
+
+    // Counted, but not reported within the rate limit period.
+    monitor.reportHandler("test.handler", 250'000, kStartUs + 1);
+    ASSERT_EQ(1, metric("slowHandlers"));
+    ASSERT_EQ(1, metric("slowHandler.test.handler"));
+    ASSERT_EQ(1, (int) reports.size());
+
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(reactorMonitor, rateLimitWithSuppressedCount)
+{
+    ReactorMonitor monitor(kThresholdUs, kPrefix);
+    std::vector<std::string> reports;
+    monitor.addStallHandler([&](const std::string& report) { reports.push_back(report); });
+
+    monitor.reportProbeLag(200'000, kStartUs);
+    ASSERT_EQ(1, (int) reports.size());
+
+    // Three more stalls within the period.
+    monitor.reportProbeLag(300'000, kStartUs + 1'000'000);
+    monitor.reportHandler("test.handler", 400'000, kStartUs + 2'000'000);
+    monitor.reportProbeLag(500'000, kStartUs + ReactorMonitor::kMinReportIntervalUs - 1);
+    ASSERT_EQ(1, (int) reports.size());
+
+    // The next report mentions them.
+    monitor.reportProbeLag(600'000, kStartUs + ReactorMonitor::kMinReportIntervalUs);
+    ASSERT_EQ(2, (int) reports.size());
+    ASSERT_EQ(
+        "Camera I/O thread was blocked for 600 ms; 3 more stall(s) since the previous report",
+        reports.back());
+
+    // The period starts over from the last report; the suppressed count is reset by it.
+    monitor.reportHandler(
+        "test.handler", 700'000, kStartUs + 2 * ReactorMonitor::kMinReportIntervalUs);
+    ASSERT_EQ(3, (int) reports.size());
+    ASSERT_EQ("Camera I/O handler test.handler has run for 700 ms", reports.back());
+
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(reactorMonitor, stallHandlers)
+{
+    ReactorMonitor monitor(kThresholdUs, kPrefix);
+    int firstCount = 0;
+    int secondCount = 0;
+    const int firstId = monitor.addStallHandler([&](const std::string&) { ++firstCount; });
+    const int secondId = monitor.addStallHandler([&](const std::string&) { ++secondCount; });
+    ASSERT_TRUE(firstId != secondId);
+
+    monitor.reportProbeLag(200'000, kStartUs);
+    ASSERT_EQ(1, firstCount);
+    ASSERT_EQ(1, secondCount);
+
+    // Removing one handler, as on destroying one of two Engines, keeps the other one.
+    monitor.removeStallHandler(firstId);
+    monitor.reportProbeLag(200'000, kStartUs + ReactorMonitor::kMinReportIntervalUs);
+    ASSERT_EQ(1, firstCount);
+    ASSERT_EQ(2, secondCount);
+
+    monitor.removeStallHandler(secondId);
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(reactorMonitor, disabled)
+{
+    ReactorMonitor monitor(/*stallThresholdUs*/ 0, kPrefix);
+    int reportCount = 0;
+    monitor.addStallHandler([&](const std::string&) { ++reportCount; });
+
+    monitor.reportProbeLag(10'000'000, kStartUs);
+    monitor.reportHandler("test.handler", 10'000'000, kStartUs);
+    ASSERT_EQ(0, reportCount);
+    ASSERT_EQ(0, metric("stalls"));
+
+    // The lag is still measured.
+    ASSERT_EQ(1, Metrics::instance().histogram(kPrefix + "probeLagUs").count());
+    Metrics::instance().removeAll(kPrefix);
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
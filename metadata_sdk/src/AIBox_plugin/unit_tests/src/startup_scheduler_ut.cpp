@@ -0,0 +1,152 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/startup_scheduler.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace std::chrono;
+
+static const auto notCancelled = []() { return false; };
+
+/** Long enough for a thread to get to waiting in admit(). */
+static void letThreadsWait()
+{
+    std::this_thread::sleep_for(milliseconds(100));
+}
+
+TEST(startupScheduler, rateLimit)
+{
+    StartupScheduler scheduler(/*maxStartsPerSecond*/ 20, /*maxConcurrentStarts*/ 0);
+
+    const auto startTime = steady_clock::now();
+    ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+    scheduler.finish();
+    ASSERT_TRUE(steady_clock::now() - startTime < milliseconds(40)); //< The first one at once.
+
+    // The next ones are spaced by 50 ms, with no burst allowance.
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+        scheduler.finish();
+    }
+    ASSERT_TRUE(steady_clock::now() - startTime >= milliseconds(4 * 50));
+
+    // Unused admissions do not accumulate.
+    std::this_thread::sleep_for(milliseconds(200));
+    const auto restartTime = steady_clock::now();
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+        scheduler.finish();
+    }
+    ASSERT_TRUE(steady_clock::now() - restartTime >= milliseconds(2 * 50));
+}
+
+TEST(startupScheduler, concurrencyLimit)
+{
+    StartupScheduler scheduler(/*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 2);
+    ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+    ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+
+    std::atomic<bool> isAdmitted{false};
+    std::thread thread(
+        [&]()
+        {
+            isAdmitted = scheduler.admit(/*priority*/ 0, notCancelled);
+        });
+
+    letThreadsWait();
+    ASSERT_FALSE(isAdmitted.load());
+
+    scheduler.finish();
+    thread.join();
+    ASSERT_TRUE(isAdmitted.load());
+
+    scheduler.finish();
+    scheduler.finish();
+}
+
+TEST(startupScheduler, priority)
+{
+    StartupScheduler scheduler(/*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 1);
+    ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+
+    std::mutex mutex;
+    std::vector<int> admissionOrder;
+    const auto startWaiter =
+        [&](int id, int priority)
+        {
+            return std::thread(
+                [&, id, priority]()
+                {
+                    if (!scheduler.admit(priority, notCancelled))
+                        return;
+                    {
+                        const std::lock_guard<std::mutex> lock(mutex);
+                        admissionOrder.push_back(id);
+                    }
+                    scheduler.finish();
+                });
+        };
+
+    // Higher priority first, then in the order of arrival.
+    std::vector<std::thread> threads;
+    threads.push_back(startWaiter(/*id*/ 1, /*priority*/ 0));
+    letThreadsWait();
+    threads.push_back(startWaiter(/*id*/ 2, /*priority*/ 0));
+    letThreadsWait();
+    threads.push_back(startWaiter(/*id*/ 3, /*priority*/ 10));
+    letThreadsWait();
+
+    scheduler.finish();
+    for (auto& thread: threads)
+        thread.join();
+
+    ASSERT_EQ(3, (int) admissionOrder.size());
+    ASSERT_EQ(3, admissionOrder[0]);
+    ASSERT_EQ(1, admissionOrder[1]);
+    ASSERT_EQ(2, admissionOrder[2]);
+}
+
+TEST(startupScheduler, cancellation)
+{
+    StartupScheduler scheduler(/*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 1);
+    ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+
+    std::atomic<bool> isCancelled{false};
+    std::atomic<bool> isAdmitted{true};
+    std::thread thread(
+        [&]()
+        {
+            isAdmitted = scheduler.admit(/*priority*/ 0, [&]() { return isCancelled.load(); });
+        });
+
+    letThreadsWait();
+    isCancelled = true;
+    scheduler.wakeUpAll();
+    thread.join();
+    ASSERT_FALSE(isAdmitted.load());
+
+    // The cancelled caller has not taken the slot.
+    scheduler.finish();
+    ASSERT_TRUE(scheduler.admit(/*priority*/ 0, notCancelled));
+    scheduler.finish();
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
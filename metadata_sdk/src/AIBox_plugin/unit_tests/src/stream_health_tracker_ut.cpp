@@ -0,0 +1,78 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metrics.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/stream_health_tracker.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+static const std::string kPrefix = "test.streamHealth.";
+
+static int64_t steadyClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t metric(const std::string& name)
+{
+    return Metrics::instance().value(kPrefix + name).load();
+}
+
+TEST(streamHealthTracker, publishedWhenRead)
+{
+    {
+        StreamHealthTracker tracker(kPrefix);
+
+        // 25 fps of 1000-byte frames, with a key frame every 10 frames.
+        for (int i = 0; i < 30; ++i)
+            tracker.onData(/*timestampUs*/ i * 40'000, /*sizeBytes*/ 1000, i % 10 == 0);
+        ASSERT_EQ(0, metric("fps")); //< Not published by onData().
+
+        Metrics::instance().toJson();
+        ASSERT_EQ(25, metric("fps"));
+        ASSERT_EQ(200'000, metric("bitrateBps"));
+        ASSERT_EQ(10, metric("gopFrames"));
+
+        // The stream has stopped: the metrics go to 0 rather than keep the last values.
+        const int64_t windowUs = tracker.statistics().windowSize().count();
+        tracker.publish(steadyClockUs() + windowUs + 1);
+        ASSERT_EQ(0, metric("fps"));
+        ASSERT_EQ(0, metric("bitrateBps"));
+        ASSERT_EQ(0, metric("gopFrames"));
+
+        tracker.publish(steadyClockUs());
+        ASSERT_EQ(25, metric("fps"));
+    }
+
+    // The destroyed tracker is not published anymore.
+    Metrics::instance().value(kPrefix + "fps") = -1;
+    Metrics::instance().toJson();
+    ASSERT_EQ(-1, metric("fps"));
+    Metrics::instance().removeAll(kPrefix);
+}
+
+TEST(streamHealthTracker, noData)
+{
+    StreamHealthTracker tracker(kPrefix);
+    Metrics::instance().value(kPrefix + "fps") = -1;
+    tracker.publish(steadyClockUs());
+    ASSERT_EQ(0, metric("fps"));
+    ASSERT_EQ(0, metric("bitrateBps"));
+    ASSERT_EQ(0, metric("gopFrames"));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,199 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/subscription_controller.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace std::chrono;
+using State = SubscriptionController::State;
+
+static constexpr int kTimeoutMs = 5000;
+
+static bool waitFor(const std::function<bool()>& condition)
+{
+    const auto deadline = steady_clock::now() + milliseconds(kTimeoutMs);
+    while (!condition() && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(1));
+    return condition();
+}
+
+TEST(subscriptionController, gracePeriod)
+{
+    std::atomic<int> startCount{0};
+    std::atomic<int> stopCount{0};
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    SubscriptionController controller(
+        &timerQueue,
+        [&]() { ++startCount; return true; },
+        [&]() { ++stopCount; },
+        /*gracePeriodMs*/ 200,
+        /*minRetryDelayMs*/ 20,
+        /*maxRetryDelayMs*/ 80);
+    ASSERT_TRUE(controller.state() == State::idle);
+
+    controller.setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::active; }));
+    ASSERT_EQ(1, startCount.load());
+
+    // A short gap in the demand does not re-subscribe.
+    controller.setNeeded(false);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::gracePeriod; }));
+    controller.setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::active; }));
+    ASSERT_EQ(1, startCount.load());
+    ASSERT_EQ(0, stopCount.load());
+
+    controller.setNeeded(false);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::idle; }));
+    ASSERT_EQ(1, stopCount.load());
+}
+
+TEST(subscriptionController, retryFailedStart)
+{
+    std::atomic<int> startCount{0};
+    std::atomic<int> stopCount{0};
+    std::mutex mutex;
+    std::vector<steady_clock::time_point> startTimes;
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    SubscriptionController controller(
+        &timerQueue,
+        [&]()
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            startTimes.push_back(steady_clock::now());
+            return ++startCount > 4;
+        },
+        [&]() { ++stopCount; },
+        /*gracePeriodMs*/ 10000,
+        /*minRetryDelayMs*/ 20,
+        /*maxRetryDelayMs*/ 50);
+
+    std::atomic<bool> hasFailed{false};
+    controller.setStateChangedHandler(
+        [&](State state) { if (state == State::failed) hasFailed = true; });
+
+    controller.setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::active; }));
+    ASSERT_TRUE(hasFailed.load());
+    ASSERT_EQ(5, startCount.load());
+    ASSERT_EQ(0, stopCount.load()); //< The failed starts are retried without stopping.
+
+    // The delays double from the minimum, up to the maximum: 20, 40, 50, 50 ms.
+    const std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(5, (int) startTimes.size());
+    ASSERT_TRUE(startTimes[1] - startTimes[0] >= milliseconds(20));
+    ASSERT_TRUE(startTimes[2] - startTimes[1] >= milliseconds(40));
+    ASSERT_TRUE(startTimes[3] - startTimes[2] >= milliseconds(50));
+    ASSERT_TRUE(startTimes[4] - startTimes[3] >= milliseconds(50));
+    ASSERT_TRUE(startTimes[4] - startTimes[0] < milliseconds(kTimeoutMs));
+}
+
+TEST(subscriptionController, failedStartNotNeededAnymore)
+{
+    std::atomic<int> startCount{0};
+    std::atomic<int> stopCount{0};
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    SubscriptionController controller(
+        &timerQueue,
+        [&]() { ++startCount; return false; },
+        [&]() { ++stopCount; },
+        /*gracePeriodMs*/ 10000,
+        /*minRetryDelayMs*/ 10000,
+        /*maxRetryDelayMs*/ 10000);
+
+    controller.setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::failed; }));
+
+    // Stopped at once, without waiting for the retry delay or the grace period.
+    const auto startTime = steady_clock::now();
+    controller.setNeeded(false);
+    ASSERT_TRUE(waitFor([&]() { return controller.state() == State::idle; }));
+    ASSERT_TRUE(steady_clock::now() - startTime < milliseconds(kTimeoutMs));
+    ASSERT_EQ(1, startCount.load());
+    ASSERT_EQ(1, stopCount.load());
+
+    // Needed again: started at once.
+    controller.setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return startCount == 2; }));
+}
+
+TEST(subscriptionController, destructionStopsFailedStart)
+{
+    std::atomic<int> stopCount{0};
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    {
+        SubscriptionController controller(
+            &timerQueue,
+            []() { return false; },
+            [&]() { ++stopCount; },
+            /*gracePeriodMs*/ 10000,
+            /*minRetryDelayMs*/ 10000,
+            /*maxRetryDelayMs*/ 10000);
+        controller.setNeeded(true);
+        ASSERT_TRUE(waitFor([&]() { return controller.state() == State::failed; }));
+    }
+    ASSERT_EQ(1, stopCount.load());
+}
+
+TEST(subscriptionController, sharedTimerQueue)
+{
+    // More controllers than threads, with the starts which block for a while.
+    static constexpr int kControllerCount = 10;
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    std::atomic<int> startCount{0};
+    std::atomic<int> stopCount{0};
+    std::vector<std::unique_ptr<SubscriptionController>> controllers;
+    for (int i = 0; i < kControllerCount; ++i)
+    {
+        controllers.push_back(std::make_unique<SubscriptionController>(
+            &timerQueue,
+            [&]()
+            {
+                std::this_thread::sleep_for(milliseconds(10));
+                ++startCount;
+                return true;
+            },
+            [&]() { ++stopCount; },
+            /*gracePeriodMs*/ 50,
+            /*minRetryDelayMs*/ 20,
+            /*maxRetryDelayMs*/ 80));
+    }
+
+    for (const auto& controller: controllers)
+        controller->setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return startCount == kControllerCount; }));
+    for (const auto& controller: controllers)
+        ASSERT_TRUE(waitFor([&]() { return controller->state() == State::active; }));
+
+    for (const auto& controller: controllers)
+        controller->setNeeded(false);
+    ASSERT_TRUE(waitFor([&]() { return stopCount == kControllerCount; }));
+    for (const auto& controller: controllers)
+        ASSERT_TRUE(waitFor([&]() { return controller->state() == State::idle; }));
+
+    // Destroyed while needed: stopped by the destructor, on this thread.
+    controllers.front()->setNeeded(true);
+    ASSERT_TRUE(waitFor([&]() { return controllers.front()->state() == State::active; }));
+    controllers.clear();
+    ASSERT_EQ(kControllerCount + 1, stopCount.load());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,336 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <asio.hpp>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/metrics.h>
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/subscription_registry.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+// Nothing listens on this port: the sessions keep failing to connect, which is irrelevant here.
+static const std::string kHost = "127.0.0.1";
+static constexpr unsigned short kPort = 1;
+static const std::string kPath = "/SetSubscribe";
+
+static constexpr int64_t kLingerMs = 300;
+
+static std::shared_ptr<CameraSession> acquire(
+    SubscriptionRegistry* registry, unsigned short port, const std::string& basicAuth = "")
+{
+    return registry->acquire(
+        kHost, port, kPath, basicAuth, /*priority*/ 0, /*isCancelled*/ []() { return false; });
+}
+
+/** @return Whether the session has been dropped by the registry within the timeout. */
+static bool waitUntilExpired(const std::weak_ptr<CameraSession>& session, int timeoutMs)
+{
+    using namespace std::chrono;
+    const auto deadline = steady_clock::now() + milliseconds(timeoutMs);
+    while (!session.expired() && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(10));
+    return session.expired();
+}
+
+static bool waitFor(const std::function<bool()>& condition)
+{
+    using namespace std::chrono;
+    const auto deadline = steady_clock::now() + milliseconds(5000);
+    while (!condition() && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(10));
+    return condition();
+}
+
+/**
+ * Accepts a single subscription on a loopback port, and then keeps sending a PEA message every
+ * few milliseconds, with the MAC address given by setMac().
+ */
+class FakeCamera
+{
+public:
+    FakeCamera():
+        m_acceptor(m_ioContext, asio::ip::tcp::endpoint(asio::ip::make_address(kHost), 0))
+    {
+        m_acceptor.non_blocking(true);
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~FakeCamera()
+    {
+        m_isStopped = true;
+        m_thread.join();
+    }
+
+    unsigned short port() const { return m_acceptor.local_endpoint().port(); }
+
+    /** @param mac If empty, the messages have no MAC address. */
+    void setMac(const std::string& mac)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_mac = mac;
+    }
+
+private:
+    void run()
+    {
+        asio::ip::tcp::socket socket(m_ioContext);
+        asio::error_code error;
+        while (!m_isStopped && m_acceptor.accept(socket, error))
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (m_isStopped)
+            return;
+
+        // The subscription request; its body is not needed.
+        asio::streambuf buffer;
+        asio::read_until(socket, buffer, "\r\n\r\n", error);
+        send(&socket, "HTTP/1.1 200 OK", "<config status=\"success\"/>");
+
+        while (!m_isStopped && !error)
+        {
+            error = send(&socket, "POST /SendAlarmData HTTP/1.1", message());
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    static asio::error_code send(
+        asio::ip::tcp::socket* socket, const std::string& firstLine, const std::string& body)
+    {
+        const std::string data = firstLine + "\r\n"
+            "Content-Type: application/xml\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "\r\n" + body;
+        asio::error_code error;
+        asio::write(*socket, asio::buffer(data), error);
+        return error;
+    }
+
+    std::string message()
+    {
+        std::string mac;
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            mac = m_mac;
+        }
+        return
+            "<config>\n"
+            "    <smartType>PEA</smartType>\n"
+            + (mac.empty() ? "" : "    <mac>" + mac + "</mac>\n") +
+            "    <traject type=\"list\" count=\"1\">\n"
+            "        <item>\n"
+            "            <targetId>1</targetId>\n"
+            "            <targetType>person</targetType>\n"
+            "            <rect><x1>0</x1><y1>0</y1><x2>100</x2><y2>100</y2></rect>\n"
+            "        </item>\n"
+            "    </traject>\n"
+            "</config>\n";
+    }
+
+private:
+    asio::io_context m_ioContext;
+    asio::ip::tcp::acceptor m_acceptor;
+    std::atomic<bool> m_isStopped{false};
+    std::mutex m_mutex;
+    std::string m_mac;
+    std::thread m_thread;
+};
+
+TEST(subscriptionRegistry, sharing)
+{
+    std::atomic<int64_t>& sharedCount = Metrics::instance().value("subscription.shared");
+    const int64_t initialSharedCount = sharedCount.load();
+
+    SubscriptionRegistry registry(
+        kLingerMs, /*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 0, /*connectTimeoutMs*/ 0);
+
+    const auto session1 = acquire(&registry, kPort);
+    const auto session2 = acquire(&registry, kPort);
+    ASSERT_TRUE(session1 != nullptr);
+    ASSERT_EQ(session1, session2);
+    ASSERT_EQ(initialSharedCount + 1, sharedCount.load());
+
+    // Another port or other credentials make another endpoint.
+    const auto otherPortSession = acquire(&registry, kPort + 1);
+    const auto otherCredentialsSession = acquire(&registry, kPort, "Basic YWRtaW46YWRtaW4=");
+    ASSERT_TRUE(otherPortSession != session1);
+    ASSERT_TRUE(otherCredentialsSession != session1);
+    ASSERT_TRUE(otherCredentialsSession != otherPortSession);
+
+    // The session stays in the registry while any of its users holds it.
+    registry.release(session1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * kLingerMs));
+    ASSERT_EQ(session2, acquire(&registry, kPort));
+
+    registry.release(session2);
+    registry.release(session2);
+    registry.release(otherPortSession);
+    registry.release(otherCredentialsSession);
+}
+
+TEST(subscriptionRegistry, lingerAndReuse)
+{
+    std::atomic<int64_t>& reusedCount = Metrics::instance().value("subscription.reused");
+    const int64_t initialReusedCount = reusedCount.load();
+
+    SubscriptionRegistry registry(
+        kLingerMs, /*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 0, /*connectTimeoutMs*/ 0);
+
+    std::shared_ptr<CameraSession> session = acquire(&registry, kPort);
+    const std::weak_ptr<CameraSession> weakSession = session;
+
+    // Released, and acquired again within the linger period: the same session is handed out.
+    registry.release(session);
+    session.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(kLingerMs / 3));
+    session = acquire(&registry, kPort);
+    ASSERT_EQ(weakSession.lock(), session);
+    ASSERT_EQ(initialReusedCount + 1, reusedCount.load());
+
+    // The reuse has cancelled the linger deadline.
+    std::this_thread::sleep_for(std::chrono::milliseconds(kLingerMs));
+    ASSERT_FALSE(weakSession.expired());
+
+    // Not acquired within the linger period: stopped and dropped.
+    registry.release(session);
+    session.reset();
+    ASSERT_TRUE(waitUntilExpired(weakSession, 10 * kLingerMs));
+
+    session = acquire(&registry, kPort);
+    ASSERT_TRUE(session != nullptr);
+    ASSERT_EQ(initialReusedCount + 1, reusedCount.load());
+    registry.release(session);
+}
+
+TEST(subscriptionRegistry, cancelledAcquisition)
+{
+    SubscriptionRegistry registry(
+        kLingerMs, /*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 0, /*connectTimeoutMs*/ 0);
+    const auto isCancelled = []() { return true; };
+
+    // A new session needs the admission, which the cancelled caller does not get.
+    ASSERT_TRUE(registry.acquire(kHost, kPort, kPath, "", /*priority*/ 0, isCancelled) == nullptr);
+
+    // The existing session is handed out without the admission.
+    const auto session = acquire(&registry, kPort);
+    ASSERT_EQ(session, registry.acquire(kHost, kPort, kPath, "", /*priority*/ 0, isCancelled));
+    registry.release(session);
+    registry.release(session);
+}
+
+TEST(subscriptionRegistry, cancelledConnectWait)
+{
+    static constexpr int kConnectTimeoutMs = 30'000;
+    SubscriptionRegistry registry(
+        kLingerMs, /*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 1, kConnectTimeoutMs);
+
+    // Admitted at once, and then waiting for the connection which is never established.
+    std::atomic<bool> isCancelled{false};
+    std::atomic<bool> isFinished{false};
+    std::shared_ptr<CameraSession> cancelledSession;
+    std::thread thread(
+        [&]()
+        {
+            cancelledSession = registry.acquire(kHost, kPort, kPath, "", /*priority*/ 0,
+                [&]() { return isCancelled.load(); });
+            isFinished = true;
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const bool wasFinishedBeforeCancellation = isFinished;
+
+    // Ends well before the connect timeout.
+    isCancelled = true;
+    registry.wakeUpPendingAcquisitions();
+    const bool isFinishedAfterCancellation = waitFor([&]() { return isFinished.load(); });
+    thread.join();
+    ASSERT_FALSE(wasFinishedBeforeCancellation);
+    ASSERT_TRUE(isFinishedAfterCancellation);
+    ASSERT_TRUE(cancelledSession == nullptr);
+
+    // The startup slot has been freed: the next endpoint is admitted, and connects.
+    FakeCamera camera;
+    const auto session = acquire(&registry, camera.port());
+    ASSERT_TRUE(session->isConnected());
+    registry.release(session);
+}
+
+TEST(subscriptionRegistry, singleChannelWithoutMac)
+{
+    FakeCamera camera;
+    SubscriptionRegistry registry(
+        kLingerMs, /*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 0, /*connectTimeoutMs*/ 5000);
+    const auto session = acquire(&registry, camera.port());
+    ASSERT_TRUE(session->isConnected());
+
+    std::atomic<int> messageCount{0};
+    const int channelId = session->addChannel(
+        "00:11:22:33:44:55", [&](const PEAResult& /*result*/) { ++messageCount; });
+
+    // The only channel receives the messages without a MAC, or with the one of another NIC.
+    ASSERT_TRUE(waitFor([&]() { return messageCount > 0; }));
+    camera.setMac("00:11:22:33:44:66");
+    const int previousMessageCount = messageCount;
+    ASSERT_TRUE(waitFor([&]() { return messageCount > previousMessageCount + 1; }));
+
+    session->removeChannel(channelId);
+    registry.release(session);
+}
+
+TEST(subscriptionRegistry, channelsByMac)
+{
+    FakeCamera camera;
+    camera.setMac("00-11-22-33-44-55");
+    SubscriptionRegistry registry(
+        kLingerMs, /*maxStartsPerSecond*/ 0, /*maxConcurrentStarts*/ 0, /*connectTimeoutMs*/ 5000);
+    const auto session = acquire(&registry, camera.port());
+    ASSERT_TRUE(session->isConnected());
+
+    std::atomic<int> messageCount1{0};
+    std::atomic<int> messageCount2{0};
+    const int channelId1 = session->addChannel(
+        "00:11:22:33:44:55", [&](const PEAResult& /*result*/) { ++messageCount1; });
+    const int channelId2 = session->addChannel(
+        "00:11:22:33:44:66", [&](const PEAResult& /*result*/) { ++messageCount2; });
+
+    ASSERT_TRUE(waitFor([&]() { return messageCount1 > 2; }));
+    ASSERT_EQ(0, messageCount2.load());
+
+    // The messages which cannot be attributed to a channel are dropped and counted.
+    std::atomic<int64_t>& unroutedCount = Metrics::instance().value("session.unroutedMessages");
+    for (const std::string mac: {"", "00:11:22:33:44:77"})
+    {
+        camera.setMac(mac);
+        const int64_t initialUnroutedCount = unroutedCount.load();
+        ASSERT_TRUE(waitFor([&]() { return unroutedCount > initialUnroutedCount; }));
+
+        // The camera sends the messages in order: no more messages with the previous MAC.
+        const int previousMessageCount1 = messageCount1;
+        const int previousMessageCount2 = messageCount2;
+        const int64_t previousUnroutedCount = unroutedCount.load();
+        ASSERT_TRUE(waitFor([&]() { return unroutedCount > previousUnroutedCount + 1; }));
+        ASSERT_EQ(previousMessageCount1, messageCount1.load());
+        ASSERT_EQ(previousMessageCount2, messageCount2.load());
+    }
+
+    session->removeChannel(channelId1);
+    session->removeChannel(channelId2);
+    registry.release(session);
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
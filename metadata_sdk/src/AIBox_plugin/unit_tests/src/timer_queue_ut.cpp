@@ -0,0 +1,132 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/timer_queue.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using namespace std::chrono;
+
+static bool waitFor(const std::function<bool()>& condition)
+{
+    const auto deadline = steady_clock::now() + milliseconds(5000);
+    while (!condition() && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(1));
+    return condition();
+}
+
+TEST(timerQueue, orderOfDueTasks)
+{
+    TimerQueue timerQueue(/*threadCount*/ 1);
+    const int owner = 0;
+    std::mutex mutex;
+    std::vector<int> order;
+    const auto record =
+        [&](int value)
+        {
+            return
+                [&, value]()
+                {
+                    const std::lock_guard<std::mutex> lock(mutex);
+                    order.push_back(value);
+                };
+        };
+
+    // Keeps the only thread busy while the next tasks become due.
+    std::atomic<bool> isReleased{false};
+    timerQueue.post(&owner, milliseconds(0), /*priority*/ 0,
+        [&]() { while (!isReleased) std::this_thread::sleep_for(milliseconds(1)); });
+    timerQueue.post(&owner, milliseconds(0), /*priority*/ 0, record(1));
+    timerQueue.post(&owner, milliseconds(0), /*priority*/ 1, record(2));
+    timerQueue.post(&owner, milliseconds(0), /*priority*/ 0, record(3));
+    timerQueue.post(&owner, milliseconds(0), /*priority*/ 1, record(4));
+    timerQueue.post(&owner, milliseconds(200), /*priority*/ 2, record(5)); //< Not due yet.
+    isReleased = true;
+
+    ASSERT_TRUE(waitFor(
+        [&]()
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            return order.size() == 5;
+        }));
+    const std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_TRUE((order == std::vector<int>{2, 4, 1, 3, 5}));
+}
+
+TEST(timerQueue, delay)
+{
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    const int owner = 0;
+    const auto startTime = steady_clock::now();
+    std::atomic<int64_t> delayMs{-1};
+    timerQueue.post(&owner, milliseconds(100), /*priority*/ 0,
+        [&]() { delayMs = duration_cast<milliseconds>(steady_clock::now() - startTime).count(); });
+    ASSERT_TRUE(waitFor([&]() { return delayMs >= 0; }));
+    ASSERT_TRUE(delayMs >= 100);
+}
+
+TEST(timerQueue, blockingTask)
+{
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    const int blockingOwner = 1;
+    const int owner = 2;
+    std::atomic<bool> isReleased{false};
+    std::atomic<bool> isDone{false};
+    timerQueue.post(&blockingOwner, milliseconds(0), /*priority*/ 0,
+        [&]() { while (!isReleased) std::this_thread::sleep_for(milliseconds(1)); });
+
+    // Run by the other thread meanwhile.
+    timerQueue.post(&owner, milliseconds(10), /*priority*/ 0, [&]() { isDone = true; });
+    ASSERT_TRUE(waitFor([&]() { return isDone.load(); }));
+    isReleased = true;
+}
+
+TEST(timerQueue, cancel)
+{
+    TimerQueue timerQueue(/*threadCount*/ 2);
+    const int owner = 1;
+    const int otherOwner = 2;
+    std::atomic<bool> isStarted{false};
+    std::atomic<bool> isFinished{false};
+    std::atomic<int> runCount{0};
+    timerQueue.post(&owner, milliseconds(0), /*priority*/ 0,
+        [&]()
+        {
+            isStarted = true;
+            std::this_thread::sleep_for(milliseconds(100));
+            isFinished = true;
+
+            // Posted while being cancelled: dropped as well.
+            timerQueue.post(&owner, milliseconds(0), /*priority*/ 0, [&]() { ++runCount; });
+        });
+    timerQueue.post(&owner, milliseconds(50), /*priority*/ 0, [&]() { ++runCount; });
+    timerQueue.post(&otherOwner, milliseconds(50), /*priority*/ 0, [&]() { ++runCount; });
+    ASSERT_TRUE(waitFor([&]() { return isStarted.load(); }));
+
+    // Waits for the running task of the owner.
+    timerQueue.cancel(&owner);
+    ASSERT_TRUE(isFinished);
+
+    // Only the task of the other owner runs.
+    ASSERT_TRUE(waitFor([&]() { return runCount == 1; }));
+    std::this_thread::sleep_for(milliseconds(100));
+    ASSERT_EQ(1, runCount.load());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
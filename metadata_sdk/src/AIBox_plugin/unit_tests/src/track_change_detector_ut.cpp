@@ -0,0 +1,122 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/track_change_detector.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using nx::sdk::analytics::Rect;
+
+// Binary fractions, so that the differences of the coordinates are exact.
+static constexpr float kMinBoxChange = 0.125F;
+static constexpr int64_t kKeepAliveUs = 1'000'000;
+static constexpr int64_t kFullRefreshUs = 10'000'000;
+static const Rect kEmittedBox(0.25F, 0.25F, 0.5F, 0.5F);
+
+static TrackTable::Track emittedTrack(int64_t emittedTimestampUs)
+{
+    TrackTable::Track track;
+    track.emitted = true;
+    track.emittedTimestampUs = emittedTimestampUs;
+    track.emittedBox = kEmittedBox;
+    return track;
+}
+
+static TrackChangeDetector makeDetector()
+{
+    TrackChangeDetector detector;
+    detector.setMinBoxChange(kMinBoxChange);
+    detector.setKeepAliveIntervalUs(kKeepAliveUs);
+    detector.setFullRefreshIntervalUs(kFullRefreshUs);
+    return detector;
+}
+
+TEST(trackChangeDetector, disabled)
+{
+    TrackChangeDetector detector;
+    detector.setKeepAliveIntervalUs(kKeepAliveUs);
+    detector.setFullRefreshIntervalUs(kFullRefreshUs);
+    ASSERT_FALSE(detector.isEnabled());
+
+    // Every track is sent, and no full refresh is needed.
+    ASSERT_TRUE(detector.hasChanged(emittedTrack(1000), kEmittedBox, 1000));
+    ASSERT_FALSE(detector.isFullRefreshDue(1000));
+    ASSERT_FALSE(detector.startPacket(1000));
+}
+
+TEST(trackChangeDetector, threshold)
+{
+    const TrackChangeDetector detector = makeDetector();
+    const TrackTable::Track track = emittedTrack(1000);
+
+    ASSERT_FALSE(detector.hasChanged(track, kEmittedBox, 2000));
+
+    // A change by exactly the threshold is a change.
+    ASSERT_TRUE(detector.hasChanged(track, Rect(0.375F, 0.25F, 0.5F, 0.5F), 2000));
+    ASSERT_TRUE(detector.hasChanged(track, Rect(0.25F, 0.125F, 0.5F, 0.5F), 2000));
+    ASSERT_TRUE(detector.hasChanged(track, Rect(0.25F, 0.25F, 0.625F, 0.5F), 2000));
+    ASSERT_TRUE(detector.hasChanged(track, Rect(0.25F, 0.25F, 0.5F, 0.375F), 2000));
+
+    // Below the threshold in every coordinate.
+    ASSERT_FALSE(detector.hasChanged(track, Rect(0.3125F, 0.1875F, 0.5625F, 0.4375F), 2000));
+
+    // A track which has never been sent is always sent.
+    TrackTable::Track newTrack = track;
+    newTrack.emitted = false;
+    ASSERT_TRUE(detector.hasChanged(newTrack, kEmittedBox, 2000));
+}
+
+TEST(trackChangeDetector, keepAlive)
+{
+    TrackChangeDetector detector = makeDetector();
+    const TrackTable::Track track = emittedTrack(1'000'000);
+
+    ASSERT_FALSE(detector.hasChanged(track, kEmittedBox, 1'000'000 + kKeepAliveUs - 1));
+    ASSERT_TRUE(detector.hasChanged(track, kEmittedBox, 1'000'000 + kKeepAliveUs));
+
+    // A timestamp before the one sent, e.g. after the video stream restart, re-sends the track.
+    ASSERT_TRUE(detector.hasChanged(track, kEmittedBox, 999'999));
+
+    // Without the keep-alive, an unchanged track is never re-sent on its own.
+    detector.setKeepAliveIntervalUs(0);
+    ASSERT_FALSE(detector.hasChanged(track, kEmittedBox, 1'000'000 + 100 * kKeepAliveUs));
+    ASSERT_FALSE(detector.hasChanged(track, kEmittedBox, 999'999));
+}
+
+TEST(trackChangeDetector, fullRefresh)
+{
+    TrackChangeDetector detector = makeDetector();
+    const int64_t startUs = 5'000'000;
+
+    // The first packet is a full refresh.
+    ASSERT_TRUE(detector.isFullRefreshDue(startUs));
+    ASSERT_TRUE(detector.startPacket(startUs));
+
+    ASSERT_FALSE(detector.isFullRefreshDue(startUs + kFullRefreshUs - 1));
+    ASSERT_FALSE(detector.startPacket(startUs + kFullRefreshUs - 1));
+    ASSERT_TRUE(detector.isFullRefreshDue(startUs + kFullRefreshUs));
+
+    // Checking does not schedule; starting a packet does, from its own timestamp.
+    ASSERT_TRUE(detector.isFullRefreshDue(startUs + kFullRefreshUs));
+    ASSERT_TRUE(detector.startPacket(startUs + kFullRefreshUs + 500));
+    ASSERT_FALSE(detector.isFullRefreshDue(startUs + 2 * kFullRefreshUs));
+    ASSERT_TRUE(detector.isFullRefreshDue(startUs + 2 * kFullRefreshUs + 500));
+
+    // The timestamps going backwards cause a refresh.
+    ASSERT_TRUE(detector.startPacket(startUs));
+    ASSERT_FALSE(detector.startPacket(startUs + 1));
+
+    detector.setFullRefreshIntervalUs(0);
+    ASSERT_FALSE(detector.isFullRefreshDue(startUs + 100 * kFullRefreshUs));
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
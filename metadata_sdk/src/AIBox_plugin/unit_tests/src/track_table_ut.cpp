@@ -0,0 +1,121 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <cmath>
+#include <string>
+
+#include <nx/kit/test.h>
+#include <nx/sdk/helpers/uuid_helper.h>
+
+#include <nx/vms_server_plugins/analytics/AIBox/AIBox/track_table.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using nx::sdk::analytics::Rect;
+namespace UuidHelper = nx::sdk::UuidHelper;
+
+static const std::string kTypeId = "nx.base.Person";
+
+static bool isNear(float expected, float actual)
+{
+    return std::abs(expected - actual) < 1e-5F;
+}
+
+TEST(trackTable, update)
+{
+    TrackTable trackTable;
+    const nx::sdk::Uuid trackId = UuidHelper::randomUuid();
+    trackTable.update(7, &kTypeId, trackId, 1000, Rect(0.1F, 0.1F, 0.2F, 0.2F));
+    ASSERT_EQ(1, trackTable.size());
+    ASSERT_TRUE(trackTable.hasPendingTracks());
+
+    // The track id is assigned only on creation; an older sample is ignored.
+    trackTable.update(7, &kTypeId, UuidHelper::randomUuid(), 2000, Rect(0.3F, 0.1F, 0.2F, 0.2F));
+    trackTable.update(7, &kTypeId, trackId, 1500, Rect(0.9F, 0.1F, 0.05F, 0.2F));
+    const TrackTable::Track* track = trackTable.find(7);
+    ASSERT_TRUE(track != nullptr);
+    ASSERT_TRUE(track->trackId == trackId);
+    ASSERT_EQ(2, track->historyCount);
+    ASSERT_EQ(2000, track->newestSample().timestampUs);
+    ASSERT_TRUE(isNear(0.3F, track->newestSample().box.x));
+
+    // The updates with the same timestamp replace the newest sample.
+    trackTable.update(7, &kTypeId, trackId, 2000, Rect(0.4F, 0.1F, 0.2F, 0.2F));
+    ASSERT_EQ(2, trackTable.find(7)->historyCount);
+    ASSERT_TRUE(isNear(0.4F, trackTable.find(7)->newestSample().box.x));
+
+    trackTable.forEach([&](TrackTable::Track* anyTrack) { trackTable.setSkipped(anyTrack); });
+    ASSERT_FALSE(trackTable.hasPendingTracks());
+    ASSERT_TRUE(trackTable.find(8) == nullptr);
+}
+
+TEST(trackTable, predict)
+{
+    TrackTable trackTable;
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 1000, Rect(0.1F, 0.2F, 0.2F, 0.2F));
+    trackTable.update(1, &kTypeId, UuidHelper::randomUuid(), 2000, Rect(0.3F, 0.2F, 0.2F, 0.2F));
+    const TrackTable::Track& track = *trackTable.find(1);
+
+    Rect box;
+    ASSERT_TRUE(TrackTable::predict(track, 1500, /*maxExtrapolationUs*/ 1000, &box));
+    ASSERT_TRUE(isNear(0.2F, box.x)); //< Interpolated.
+
+    ASSERT_TRUE(TrackTable::predict(track, 2500, /*maxExtrapolationUs*/ 1000, &box));
+    ASSERT_TRUE(isNear(0.4F, box.x)); //< Extrapolated.
+
+    ASSERT_TRUE(TrackTable::predict(track, 12000, /*maxExtrapolationUs*/ 20000, &box));
+    ASSERT_TRUE(isNear(0.8F, box.x)); //< Clamped to the frame.
+
+    ASSERT_FALSE(TrackTable::predict(track, 3500, /*maxExtrapolationUs*/ 1000, &box));
+    ASSERT_FALSE(TrackTable::predict(track, 500, /*maxExtrapolationUs*/ 1000, &box));
+}
+
+/**
+ * Many tracks make long probe sequences, including the ones wrapping around the end of the table;
+ * removing every third of them exercises the backward-shift deletion of each kind of a cluster.
+ */
+TEST(trackTable, backwardShiftDeletion)
+{
+    static constexpr int kTrackCount = 1000;
+
+    TrackTable trackTable(/*initialCapacity*/ 8);
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < kTrackCount; ++i)
+        {
+            const int64_t timestampUs = (i % 3 == round) ? 1000 : 2000;
+            trackTable.update(
+                i * 7919, &kTypeId, UuidHelper::randomUuid(), timestampUs, Rect());
+        }
+        ASSERT_EQ(kTrackCount, trackTable.size());
+
+        ASSERT_EQ(
+            (kTrackCount - round + 2) / 3,
+            trackTable.expire(/*nowUs*/ 2000, /*timeoutUs*/ 500));
+        int remainingCount = 0;
+        for (int i = 0; i < kTrackCount; ++i)
+        {
+            const TrackTable::Track* track = trackTable.find(i * 7919);
+            ASSERT_EQ(i % 3 != round, track != nullptr);
+            if (track)
+                ++remainingCount;
+        }
+        ASSERT_EQ(remainingCount, trackTable.size());
+
+        // The pending count is kept with the removals: only the remaining tracks are pending.
+        trackTable.forEach([&](TrackTable::Track* track) { trackTable.setSkipped(track); });
+        ASSERT_FALSE(trackTable.hasPendingTracks());
+
+        trackTable.clear();
+        ASSERT_EQ(0, trackTable.size());
+    }
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,49 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include <nx/kit/test.h>
+#include <nx/sdk/helpers/uuid_helper.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace AIBox {
+namespace test {
+
+using nx::sdk::Uuid;
+namespace UuidHelper = nx::sdk::UuidHelper;
+
+TEST(uuid, formatAndParse)
+{
+    const Uuid uuid(
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+        0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10);
+    ASSERT_STREQ("{01234567-89AB-CDEF-FEDC-BA9876543210}", UuidHelper::toStdString(uuid));
+    ASSERT_STREQ("0123456789abcdeffedcba9876543210",
+        UuidHelper::toStdString(uuid, UuidHelper::FormatOptions::none));
+    ASSERT_STREQ("01234567-89ab-cdef-fedc-ba9876543210",
+        UuidHelper::toStdString(uuid, UuidHelper::FormatOptions::hyphens));
+
+    ASSERT_TRUE(uuid == UuidHelper::fromStdString("{01234567-89AB-CDEF-FEDC-BA9876543210}"));
+    ASSERT_TRUE(uuid == UuidHelper::fromStdString("0123456789abcdeffedcba9876543210"));
+    ASSERT_TRUE(uuid == UuidHelper::fromStdString(" 01234567-89ab-cdef-fedc-ba9876543210\r\n"));
+
+    Uuid parsed;
+    ASSERT_FALSE(UuidHelper::fromString("0123456789abcdeffedcba987654321", 31, &parsed));
+    ASSERT_FALSE(UuidHelper::fromString("0123456789abcdeffedcba98765432100", 33, &parsed));
+    ASSERT_FALSE(UuidHelper::fromString("0123456789abcdefgedcba9876543210", 32, &parsed));
+    ASSERT_FALSE(UuidHelper::fromString("0x23456789abcdeffedcba9876543210", 32, &parsed));
+    ASSERT_TRUE(parsed.isNull());
+    ASSERT_TRUE(UuidHelper::fromStdString("r0123456789abcdeffedcba9876543210").isNull());
+
+    const Uuid random = UuidHelper::randomUuid();
+    ASSERT_EQ(0x40, random[6] & 0xF0);
+    ASSERT_EQ(0x80, random[8] & 0xC0);
+    ASSERT_TRUE(random == UuidHelper::fromStdString(UuidHelper::toStdString(random)));
+    ASSERT_FALSE(random == UuidHelper::randomUuid());
+}
+
+} // namespace test
+} // namespace AIBox
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -44,6 +44,7 @@ ConsumingDeviceAgent::ConsumingDeviceAgent(
 
 ConsumingDeviceAgent::~ConsumingDeviceAgent()
 {
+    m_metadataDispatcher.reset();
     NX_PRINT << "Destroyed " << this;
 }
 
@@ -70,7 +71,7 @@ bool ConsumingDeviceAgent::pullMetadataPackets(
 
 void ConsumingDeviceAgent::setHandler(IDeviceAgent::IHandler* handler)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
     m_handler = shareToPtr(handler);
 }
 
@@ -124,7 +125,7 @@ void ConsumingDeviceAgent::doPushDataPacket(
     if (!pullMetadataPackets(&metadataPackets))
         return logError(ErrorCode::otherError, "pullMetadataPackets() failed.");
 
-    processMetadataPackets(metadataPackets);
+    pushMetadataPackets(metadataPackets);
 
     NX_OUTPUT << __func__ << "() END";
 }
@@ -138,13 +139,22 @@ void ConsumingDeviceAgent::processMetadataPackets(
             << " metadata packet(s).";
     }
 
+    deliverMetadataPackets(metadataPackets);
+    for (IMetadataPacket* const metadataPacket: metadataPackets)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        for (int i = 0; i < (int) metadataPackets.size(); ++i)
-            processMetadataPacket(Ptr(metadataPackets.at(i)).get(), i);
+        if (metadataPacket)
+            metadataPacket->releaseRef();
     }
 }
 
+void ConsumingDeviceAgent::deliverMetadataPackets(
+    const std::vector<IMetadataPacket*>& metadataPackets)
+{
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
+    for (int i = 0; i < (int) metadataPackets.size(); ++i)
+        processMetadataPacket(metadataPackets[i], i);
+}
+
 static std::string packetIndexName(int packetIndex)
 {
     return packetIndex == -1 ? "" : (std::string(" #") + nx::kit::utils::toString(packetIndex));
@@ -207,17 +217,60 @@ void ConsumingDeviceAgent::doGetSettingsOnActiveSettingChange(
 void ConsumingDeviceAgent::pushMetadataPacket(
     IMetadataPacket* metadataPacket)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_metadataDispatcher)
+        return dispatchMetadataPacket(metadataPacket);
+
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
     processMetadataPacket(metadataPacket);
     metadataPacket->releaseRef();
 }
 
+void ConsumingDeviceAgent::pushMetadataPackets(
+    const std::vector<IMetadataPacket*>& metadataPackets)
+{
+    if (!m_metadataDispatcher)
+        return processMetadataPackets(metadataPackets);
+
+    for (IMetadataPacket* const metadataPacket: metadataPackets)
+        dispatchMetadataPacket(metadataPacket);
+}
+
+void ConsumingDeviceAgent::enableAsyncMetadataDispatch(int queueCapacity, int maxBatchSize)
+{
+    if (!NX_KIT_ASSERT(!m_metadataDispatcher))
+        return;
+
+    m_metadataDispatcher = std::make_unique<MetadataDispatcher>(
+        queueCapacity,
+        maxBatchSize,
+        // The dispatcher releases the packets after the delivery.
+        [this](const std::vector<IMetadataPacket*>& metadataPackets)
+        {
+            deliverMetadataPackets(metadataPackets);
+        });
+}
+
+void ConsumingDeviceAgent::dispatchMetadataPacket(IMetadataPacket* metadataPacket)
+{
+    if (!metadataPacket)
+    {
+        NX_OUTPUT << __func__ << "(): WARNING: Null metadata packet found; discarded.";
+        return;
+    }
+
+    if (!m_metadataDispatcher->push(metadataPacket))
+    {
+        NX_OUTPUT << __func__ << "(): WARNING: Metadata queue is full; packet dropped, "
+            << m_metadataDispatcher->droppedCount() << " dropped so far.";
+    }
+}
+
 void ConsumingDeviceAgent::pushPluginDiagnosticEvent(
     IPluginDiagnosticEvent::Level level,
     std::string caption,
     std::string description) const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<nx::kit::Mutex> lock(m_mutex);
     if (!m_handler)
     {
         NX_PRINT << __func__ << "(): "
@@ -245,7 +298,7 @@ std::string ConsumingDeviceAgent::settingValue(const std::string& settingName) c
     return "";
 }
 
-std::map<std::string, std::string> ConsumingDeviceAgent::currentSettings() const
+const std::map<std::string, std::string>& ConsumingDeviceAgent::currentSettings() const
 {
     return m_settings;
 }
@@ -3,10 +3,13 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include <nx/kit/mutex.h>
+
 #include <nx/sdk/analytics/i_compound_metadata_packet.h>
 #include <nx/sdk/analytics/i_compressed_video_packet.h>
 #include <nx/sdk/analytics/i_consuming_device_agent.h>
@@ -14,6 +17,7 @@
 #include <nx/sdk/analytics/i_engine.h>
 #include <nx/sdk/analytics/i_metadata_types.h>
 #include <nx/sdk/analytics/i_uncompressed_video_frame.h>
+#include <nx/sdk/analytics/helpers/metadata_dispatcher.h>
 #include <nx/sdk/helpers/log_utils.h>
 #include <nx/sdk/helpers/ref_countable.h>
 #include <nx/sdk/ptr.h>
@@ -86,6 +90,25 @@ protected:
      */
     void pushMetadataPacket(IMetadataPacket* metadataPacket);
 
+    /**
+     * Sends several newly constructed metadata packets to Server at once, taking the ownership of
+     * them like pushMetadataPacket(): the packets are delivered under a single acquisition of the
+     * handler lock, or are queued for the dispatcher thread. Can be called at any time, from any
+     * thread.
+     */
+    void pushMetadataPackets(const std::vector<IMetadataPacket*>& metadataPackets);
+
+    /**
+     * Makes the metadata packets, both pushed and pulled, to be delivered to the Server by a
+     * dedicated dispatcher thread instead of the calling thread, so that the caller never waits
+     * for the Server to process them. If the queue of undelivered packets is full, the new
+     * packets are dropped.
+     *
+     * Should be called from the constructor of the derived class, before any packets are
+     * produced.
+     */
+    void enableAsyncMetadataDispatch(int queueCapacity = 256, int maxBatchSize = 16);
+
     /**
      * Sends a PluginDiagnosticEvent to the Server. Can be called from any thread, but if called
      * before settingsReceived() was called, will be ignored in case setHandler() was not called
@@ -117,7 +140,11 @@ protected:
      */
     std::string settingValue(const std::string& settingName) const;
 
-    std::map<std::string, std::string> currentSettings() const;
+    /**
+     * @return All the settings received from the Server, without copying; the reference stays
+     *     valid, and the contents unchanged, until the next settingsReceived() call returns.
+     */
+    const std::map<std::string, std::string>& currentSettings() const;
 
     void pushManifest(const std::string& pushManifest);
 
@@ -147,13 +174,21 @@ private:
     void logMetadataPacketIfNeeded(
         const IMetadataPacket* metadataPacket,
         int packetIndex) const;
+
+    /** Delivers the packets, and then releases them. */
     void processMetadataPackets(const std::vector<IMetadataPacket*>& metadataPackets);
+
+    /** Delivers the packets under a single acquisition of the handler lock; does not release. */
+    void deliverMetadataPackets(const std::vector<IMetadataPacket*>& metadataPackets);
+
     void processMetadataPacket(IMetadataPacket* metadataPacket, int packetIndex /*= -1*/);
+    void dispatchMetadataPacket(IMetadataPacket* metadataPacket);
 
 private:
-    mutable std::mutex m_mutex;
+    mutable nx::kit::Mutex m_mutex{"nx::sdk::analytics::ConsumingDeviceAgent::m_mutex"};
     Ptr<IDeviceAgent::IHandler> m_handler;
     std::map<std::string, std::string> m_settings;
+    std::unique_ptr<MetadataDispatcher> m_metadataDispatcher;
 };
 
 } // namespace nx::sdk::analytics
@@ -0,0 +1,149 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "metadata_dispatcher.h"
+
+#include <algorithm>
+
+#include <nx/kit/debug.h>
+
+namespace nx::sdk::analytics {
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+MetadataDispatcher::MetadataDispatcher(
+    int capacity, int maxBatchSize, BatchHandler batchHandler)
+    :
+    m_cells(roundUpToPowerOfTwo((size_t) std::max(capacity, 2))),
+    m_mask(m_cells.size() - 1),
+    m_maxBatchSize(std::max(maxBatchSize, 1)),
+    m_batchHandler(std::move(batchHandler))
+{
+    for (size_t i = 0; i < m_cells.size(); ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+MetadataDispatcher::~MetadataDispatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopped = true;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+
+    IMetadataPacket* packet = nullptr;
+    while (tryPop(&packet))
+        packet->releaseRef();
+}
+
+bool MetadataDispatcher::push(IMetadataPacket* packet)
+{
+    if (!NX_KIT_ASSERT(packet))
+        return false;
+
+    // Bounded MPMC queue by D. Vyukov, used with a single consumer: each cell carries a sequence
+    // number telling whether it is free for the producer of the given position, or filled.
+    size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;)
+    {
+        cell = &m_cells[position & m_mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) position;
+        if (difference == 0)
+        {
+            if (m_enqueuePosition.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            packet->releaseRef();
+            return false;
+        }
+        else
+        {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    cell->packet = packet;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    // Pairs with the fence in run(): either the dispatcher sees the packet before falling asleep,
+    // or this thread sees it sleeping and wakes it up.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_isSleeping.load(std::memory_order_relaxed))
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isSleeping = false;
+        }
+        m_wakeUp.notify_one();
+    }
+    return true;
+}
+
+bool MetadataDispatcher::tryPop(IMetadataPacket** outPacket)
+{
+    Cell& cell = m_cells[m_dequeuePosition & m_mask];
+    if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1)
+        return false;
+
+    *outPacket = cell.packet;
+    cell.packet = nullptr;
+    cell.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+    ++m_dequeuePosition;
+    return true;
+}
+
+bool MetadataDispatcher::isEmpty() const
+{
+    const Cell& cell = m_cells[m_dequeuePosition & m_mask];
+    return cell.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1;
+}
+
+void MetadataDispatcher::run()
+{
+    std::vector<IMetadataPacket*> batch;
+    batch.reserve((size_t) m_maxBatchSize);
+
+    while (!m_isStopped)
+    {
+        IMetadataPacket* packet = nullptr;
+        while ((int) batch.size() < m_maxBatchSize && tryPop(&packet))
+            batch.push_back(packet);
+
+        if (!batch.empty())
+        {
+            m_batchHandler(batch);
+            for (IMetadataPacket* deliveredPacket: batch)
+                deliveredPacket->releaseRef();
+            batch.clear();
+            continue;
+        }
+
+        m_isSleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!isEmpty())
+        {
+            m_isSleeping = false;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeUp.wait(lock, [this]() { return !m_isSleeping || m_isStopped; });
+    }
+}
+
+} // namespace nx::sdk::analytics
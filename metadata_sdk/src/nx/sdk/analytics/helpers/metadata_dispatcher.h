@@ -0,0 +1,82 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nx/sdk/analytics/i_metadata_packet.h>
+
+namespace nx::sdk::analytics {
+
+/**
+ * Delivers metadata packets to a handler on a dedicated thread, so that the threads producing
+ * the packets never wait for the Server to process them.
+ *
+ * The packets are passed via a bounded lock-free multi-producer single-consumer queue; the
+ * dispatcher thread drains it and hands the packets over to the handler in batches. If the queue
+ * is full, the pushed packet is dropped rather than blocking the producer.
+ */
+class MetadataDispatcher
+{
+public:
+    using BatchHandler = std::function<void(const std::vector<IMetadataPacket*>& packets)>;
+
+    /**
+     * @param capacity Rounded up to a power of two.
+     * @param batchHandler Called on the dispatcher thread; must not keep the packet pointers
+     *     without adding a reference.
+     */
+    MetadataDispatcher(int capacity, int maxBatchSize, BatchHandler batchHandler);
+
+    /** Stops the dispatcher thread; the packets not delivered yet are released. */
+    ~MetadataDispatcher();
+
+    MetadataDispatcher(const MetadataDispatcher&) = delete;
+    MetadataDispatcher& operator=(const MetadataDispatcher&) = delete;
+
+    /**
+     * Can be called from any thread. Takes ownership of the packet.
+     * @return False if the queue is full; the packet is released in this case.
+     */
+    bool push(IMetadataPacket* packet);
+
+    /** @return Number of the packets dropped because the queue was full. */
+    int64_t droppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        IMetadataPacket* packet = nullptr;
+    };
+
+    bool tryPop(IMetadataPacket** outPacket);
+    bool isEmpty() const;
+    void run();
+
+private:
+    std::vector<Cell> m_cells;
+    const size_t m_mask;
+    const int m_maxBatchSize;
+    const BatchHandler m_batchHandler;
+
+    // Separate cache lines for the producers' and the consumer's positions.
+    alignas(64) std::atomic<size_t> m_enqueuePosition{0};
+    alignas(64) size_t m_dequeuePosition = 0; /**< Accessed only by the dispatcher thread. */
+
+    std::atomic<int64_t> m_droppedCount{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<bool> m_isSleeping{false};
+    std::atomic<bool> m_isStopped{false};
+    std::thread m_thread;
+};
+
+} // namespace nx::sdk::analytics
@@ -51,6 +51,11 @@ void ObjectMetadata::setTypeId(std::string typeId)
     m_typeId = std::move(typeId);
 }
 
+void ObjectMetadata::setTypeId(const char* typeId)
+{
+    m_typeId.assign(typeId);
+}
+
 void ObjectMetadata::setConfidence(float confidence)
 {
     m_confidence = confidence;
@@ -91,4 +96,14 @@ void ObjectMetadata::setBoundingBox(const Rect& rect)
     m_rect = rect;
 }
 
+void ObjectMetadata::clear()
+{
+    m_typeId.clear();
+    m_confidence = 1.0;
+    m_trackId = Uuid();
+    m_subtype.clear();
+    m_attributes.clear();
+    m_rect = Rect();
+}
+
 } // namespace nx::sdk::analytics
@@ -22,6 +22,10 @@ public:
     virtual int attributeCount() const override;
 
     void setTypeId(std::string typeId);
+
+    /** Reuses the storage of the current type id, unlike setTypeId(std::string). */
+    void setTypeId(const char* typeId);
+
     void setConfidence(float confidence);
     void setTrackId(const Uuid& value);
     void setSubtype(const std::string& value);
@@ -30,6 +34,9 @@ public:
     void addAttributes(std::vector<nx::sdk::Ptr<Attribute>>&& value);
     void setBoundingBox(const Rect& rect);
 
+    /** Resets the object to the default state, keeping the allocated capacity. */
+    void clear();
+
 protected:
     virtual const IAttribute* getAttribute(int index) const override;
     virtual void getTrackId(Uuid* outValue) const override;
@@ -3,6 +3,7 @@
 #include "object_metadata_packet.h"
 
 #include <nx/kit/debug.h>
+#include <nx/sdk/analytics/helpers/pooled_object_metadata.h>
 
 namespace nx::sdk::analytics {
 
@@ -56,6 +57,30 @@ void ObjectMetadataPacket::addItem(const IObjectMetadata* objectMetadata)
     m_objects.push_back(shareToPtr(objectMetadata));
 }
 
+void ObjectMetadataPacket::addItems(
+    const ObjectBox* boxes, int count, ObjectMetadataPool* pool)
+{
+    if (!NX_KIT_ASSERT(boxes || count == 0))
+        return;
+    m_objects.reserve(m_objects.size() + count);
+    for (int i = 0; i < count; ++i)
+    {
+        const ObjectBox& box = boxes[i];
+        Ptr<ObjectMetadata> objectMetadata =
+            pool ? pool->makeObjectMetadata() : makePtr<ObjectMetadata>();
+        objectMetadata->setTypeId(box.typeId ? box.typeId : "");
+        objectMetadata->setTrackId(box.trackId);
+        objectMetadata->setBoundingBox(box.boundingBox);
+        objectMetadata->setConfidence(box.confidence);
+        m_objects.push_back(std::move(objectMetadata));
+    }
+}
+
+void ObjectMetadataPacket::reserve(int itemCount)
+{
+    m_objects.reserve(itemCount);
+}
+
 void ObjectMetadataPacket::clear()
 {
     m_objects.clear();
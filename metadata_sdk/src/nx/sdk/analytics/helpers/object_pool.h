@@ -0,0 +1,177 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace nx::sdk::analytics {
+
+/**
+ * Free list of recycled objects of the given type, so that the steady state of creating and
+ * releasing them does not touch the global allocator, and takes no lock.
+ *
+ * The objects are acquired by the producer - one thread at a time, e.g. under the lock the
+ * producer builds its metadata with - from a list private to it. They may be released on any
+ * thread, e.g. by the Server: such returns are pushed to a lock-free stack, which the producer
+ * takes over as a whole when its own list runs out. Taking the whole stack at once, rather than
+ * popping single objects, keeps the stack free of the ABA problem without tagged pointers.
+ *
+ * The pool is owned via shared_ptr by the component producing the objects, e.g. a DeviceAgent,
+ * and by each object taken from it, because the objects may be released after the owner is gone.
+ * The owner calls drain() on its destruction: the idle objects are deleted at once, and the ones
+ * still in use are deleted when released. Thus, no object is left in the pool to be deleted
+ * later by the code of an unloaded plugin library.
+ *
+ * The Object class must have the member `Object* m_nextFreeObject`, accessible to the pool.
+ */
+template<class Object>
+class ObjectPool
+{
+public:
+    static constexpr int kDefaultMaxFreeObjects = 1024;
+
+    /** @param maxFreeObjects Objects released to the full pool are deleted. */
+    explicit ObjectPool(int maxFreeObjects = kDefaultMaxFreeObjects):
+        m_maxFreeObjects(maxFreeObjects)
+    {
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    ~ObjectPool() { drain(); }
+
+    /**
+     * To be called by the producer, one thread at a time.
+     * @return Either a recycled or a newly created object.
+     */
+    Object* acquire()
+    {
+        if (!m_producerFreeObjects)
+            m_producerFreeObjects = m_returnedObjects.exchange(nullptr, std::memory_order_acquire);
+
+        Object* const object = m_producerFreeObjects;
+        if (!object)
+            return new Object();
+
+        m_producerFreeObjects = object->m_nextFreeObject;
+        object->m_nextFreeObject = nullptr;
+        m_freeObjectCount.fetch_sub(1, std::memory_order_relaxed);
+        return object;
+    }
+
+    /** The object is expected to be already cleared by the caller. Can be called on any thread. */
+    void recycle(Object* object)
+    {
+        if (m_isDrained.load())
+        {
+            delete object;
+            return;
+        }
+        if (m_freeObjectCount.fetch_add(1, std::memory_order_relaxed) >= m_maxFreeObjects)
+        {
+            m_freeObjectCount.fetch_sub(1, std::memory_order_relaxed);
+            delete object;
+            return;
+        }
+
+        object->m_nextFreeObject = m_returnedObjects.load(std::memory_order_relaxed);
+        while (!m_returnedObjects.compare_exchange_weak(object->m_nextFreeObject, object))
+        {
+        }
+
+        // Not to leave the object in the pool if drain() has taken the stack in the meantime.
+        if (m_isDrained.load())
+            deleteAll(m_returnedObjects.exchange(nullptr));
+    }
+
+    /**
+     * Deletes the idle objects, and makes the pool delete the objects released later. To be
+     * called by the producer, after it has stopped acquiring the objects.
+     */
+    void drain()
+    {
+        m_isDrained.store(true);
+        deleteAll(m_returnedObjects.exchange(nullptr));
+        deleteAll(m_producerFreeObjects);
+        m_producerFreeObjects = nullptr;
+        m_freeObjectCount.store(0, std::memory_order_relaxed);
+    }
+
+    /** Approximate while the objects are being acquired or released concurrently. */
+    int freeObjectCount() const { return m_freeObjectCount.load(std::memory_order_relaxed); }
+
+private:
+    static void deleteAll(Object* objects)
+    {
+        while (objects)
+        {
+            Object* const object = objects;
+            objects = object->m_nextFreeObject;
+            delete object;
+        }
+    }
+
+private:
+    const int m_maxFreeObjects;
+
+    /** Accessed only by the producer. */
+    Object* m_producerFreeObjects = nullptr;
+
+    /** Top of the stack of the objects released since the producer took it over last time. */
+    std::atomic<Object*> m_returnedObjects{nullptr};
+
+    std::atomic<int> m_freeObjectCount{0};
+    std::atomic<bool> m_isDrained{false};
+};
+
+/**
+ * Ref-countable object which is returned to its ObjectPool, instead of being deleted, when the
+ * last reference is released. The Base class must have a clear() method which drops the contents
+ * while keeping the allocated capacity; it is called before the object gets to the pool.
+ */
+template<class Base>
+class Pooled: public Base
+{
+public:
+    using Pool = ObjectPool<Pooled>;
+
+    /** @return Object with the reference counter of 1, in the state after Base::clear(). */
+    static Pooled* acquire(std::shared_ptr<Pool> pool)
+    {
+        Pooled* const object = pool->acquire();
+        object->m_pooledRefCount = 1;
+        object->m_pool = std::move(pool);
+        return object;
+    }
+
+    virtual int addRef() const override { return ++m_pooledRefCount; }
+
+    virtual int releaseRef() const override
+    {
+        const int newRefCount = --m_pooledRefCount;
+        if (newRefCount == 0)
+        {
+            auto* const object = const_cast<Pooled*>(this);
+            object->clear();
+
+            // An idle object does not keep its pool alive; the pool may delete the object.
+            const std::shared_ptr<Pool> pool = std::move(object->m_pool);
+            pool->recycle(object);
+        }
+        return newRefCount;
+    }
+
+private:
+    friend class ObjectPool<Pooled>;
+    Pooled() = default;
+
+private:
+    mutable std::atomic<int> m_pooledRefCount{1};
+    std::shared_ptr<Pool> m_pool;
+    Pooled* m_nextFreeObject = nullptr; //< Link in the free list of the pool.
+};
+
+} // namespace nx::sdk::analytics
@@ -0,0 +1,35 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "pooled_object_metadata.h"
+
+namespace nx::sdk::analytics {
+
+ObjectMetadataPool::ObjectMetadataPool():
+    m_objectMetadataPool(std::make_shared<ObjectPool<Pooled<ObjectMetadata>>>()),
+    m_objectMetadataPacketPool(std::make_shared<ObjectPool<Pooled<ObjectMetadataPacket>>>())
+{
+}
+
+ObjectMetadataPool::~ObjectMetadataPool()
+{
+    m_objectMetadataPool->drain();
+    m_objectMetadataPacketPool->drain();
+}
+
+Ptr<ObjectMetadata> ObjectMetadataPool::makeObjectMetadata()
+{
+    return Ptr<ObjectMetadata>(Pooled<ObjectMetadata>::acquire(m_objectMetadataPool));
+}
+
+Ptr<ObjectMetadataPacket> ObjectMetadataPool::makeObjectMetadataPacket()
+{
+    // ObjectMetadataPacket::clear() removes only the objects.
+    auto packet = Ptr<ObjectMetadataPacket>(
+        Pooled<ObjectMetadataPacket>::acquire(m_objectMetadataPacketPool));
+    packet->setFlags(ObjectMetadataPacket::Flags::none);
+    packet->setTimestampUs(-1);
+    packet->setDurationUs(-1);
+    return packet;
+}
+
+} // namespace nx::sdk::analytics
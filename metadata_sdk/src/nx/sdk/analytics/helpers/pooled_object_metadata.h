@@ -0,0 +1,43 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <memory>
+
+#include <nx/sdk/analytics/helpers/object_metadata.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
+#include <nx/sdk/analytics/helpers/object_pool.h>
+#include <nx/sdk/ptr.h>
+
+namespace nx::sdk::analytics {
+
+/**
+ * Replacement for makePtr<ObjectMetadata>() and makePtr<ObjectMetadataPacket>(): the released
+ * objects return to the pool, so that emitting metadata in the steady state does no allocations.
+ *
+ * Expected to be owned by the component producing the metadata, e.g. a DeviceAgent. Its
+ * destruction frees the idle objects, while the objects still referenced, e.g. by the Server, are
+ * freed when released. The objects are to be made by one thread at a time, e.g. under the lock
+ * of the producer; they may be released on any thread.
+ */
+class ObjectMetadataPool
+{
+public:
+    ObjectMetadataPool();
+    ~ObjectMetadataPool();
+
+    ObjectMetadataPool(const ObjectMetadataPool&) = delete;
+    ObjectMetadataPool& operator=(const ObjectMetadataPool&) = delete;
+
+    /** @return Object in the default state. */
+    Ptr<ObjectMetadata> makeObjectMetadata();
+
+    /** @return Packet in the default state. */
+    Ptr<ObjectMetadataPacket> makeObjectMetadataPacket();
+
+private:
+    const std::shared_ptr<ObjectPool<Pooled<ObjectMetadata>>> m_objectMetadataPool;
+    const std::shared_ptr<ObjectPool<Pooled<ObjectMetadataPacket>>> m_objectMetadataPacketPool;
+};
+
+} // namespace nx::sdk::analytics
@@ -8,11 +8,16 @@ namespace nx::sdk {
 
 using namespace std::chrono;
 
+static int64_t steadyClockUs()
+{
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 MediaStreamStatistics::MediaStreamStatistics(
     std::chrono::microseconds windowSize,
     int maxDurationInFrames)
     :
-    m_windowSize(windowSize),
+    m_windowSizeUs(windowSize.count()),
     m_maxDurationInFrames(maxDurationInFrames)
 {
     reset();
@@ -20,95 +25,166 @@ MediaStreamStatistics::MediaStreamStatistics(
 
 void MediaStreamStatistics::setWindowSize(std::chrono::microseconds windowSize)
 {
-    m_windowSize = windowSize;
+    m_windowSizeUs.store(windowSize.count(), std::memory_order_relaxed);
+}
+
+std::chrono::microseconds MediaStreamStatistics::windowSize() const
+{
+    return microseconds(m_windowSizeUs.load(std::memory_order_relaxed));
 }
 
 void MediaStreamStatistics::setMaxDurationInFrames(int maxDurationInFrames)
 {
-    m_maxDurationInFrames = maxDurationInFrames;
+    m_maxDurationInFrames.store(maxDurationInFrames, std::memory_order_relaxed);
 }
 
 void MediaStreamStatistics::reset()
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    m_data.clear();
-    m_totalSizeBytes = 0;
-    m_lastDataTimer = steady_clock::now();
+    clear();
+    publish(steadyClockUs());
 }
 
 void MediaStreamStatistics::onData(
     microseconds timestamp, size_t dataSize, bool isKeyFrame)
 {
-    auto toIterator =
-        [this](microseconds timestamp)
-        {
-            return std::lower_bound(m_data.begin(), m_data.end(), timestamp);
-        };
-
-    auto removeRange =
-        [this](auto left, auto right)
-        {
-            for (auto itr = left; itr != right; ++itr)
-                m_totalSizeBytes -= itr->size;
-            m_data.erase(left, right);
-        };
-
-    std::lock_guard<std::mutex> locker(m_mutex);
-    m_data.insert(toIterator(timestamp), Data(timestamp, dataSize, isKeyFrame));
-    m_totalSizeBytes += dataSize;
-
-    // Remove old and future data in case of media stream time has been changed.
-    removeRange(toIterator(timestamp + m_windowSize), m_data.end());
-    if (!m_data.empty())
-        removeRange(m_data.begin(), toIterator(m_data.back().timestamp - m_windowSize));
-    const int extraFrames = (int) m_data.size() - m_maxDurationInFrames;
-    if (extraFrames > 0 && m_maxDurationInFrames > 0)
-        removeRange(m_data.begin(), m_data.begin() + extraFrames);
-    m_lastDataTimer = steady_clock::now();
+    const int64_t windowSizeUs = m_windowSizeUs.load(std::memory_order_relaxed);
+    int64_t timestampUs = timestamp.count();
+
+    // Media stream time may have been changed.
+    if (m_frameCount > 0)
+    {
+        const int64_t newestTimestampUs =
+            m_data[(m_oldestIndex + m_frameCount - 1) % kCapacity].timestampUs;
+        if (timestampUs <= newestTimestampUs - windowSizeUs)
+            clear();
+        else
+            timestampUs = std::max(timestampUs, newestTimestampUs);
+    }
+
+    if (m_frameCount == kCapacity)
+        popOldest();
+    Data& data = m_data[(m_oldestIndex + m_frameCount) % kCapacity];
+    data.timestampUs = timestampUs;
+    data.size = (int64_t) dataSize;
+    data.isKeyFrame = isKeyFrame;
+    ++m_frameCount;
+    m_totalSizeBytes += data.size;
+    if (isKeyFrame)
+        ++m_keyFrameCount;
+
+    while (m_data[m_oldestIndex].timestampUs < timestampUs - windowSizeUs)
+        popOldest();
+    const int maxDurationInFrames = m_maxDurationInFrames.load(std::memory_order_relaxed);
+    if (maxDurationInFrames > 0)
+    {
+        while (m_frameCount > maxDurationInFrames)
+            popOldest();
+    }
+
+    publish(steadyClockUs());
 }
 
 int64_t MediaStreamStatistics::bitrateBitsPerSecond() const
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    const auto elapsed = steady_clock::now() - m_lastDataTimer;
-    if (m_data.empty() || elapsed > m_windowSize)
+    const Summary summary = this->summary();
+    if (isStale(summary, steadyClockUs()) || summary.intervalUs <= 0)
         return 0;
-
-    const auto interval = intervalUnsafe().count();
-    if (interval > 0)
-        return ((m_totalSizeBytes - m_data.rbegin()->size) * 8'000'000) / interval;
-    return 0;
+    return ((summary.totalSizeBytes - summary.newestSizeBytes) * 8'000'000) / summary.intervalUs;
 }
 
 bool MediaStreamStatistics::hasMediaData() const
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    return m_totalSizeBytes > 0;
+    return summary().totalSizeBytes > 0;
+}
+
+bool MediaStreamStatistics::isStale(microseconds now) const
+{
+    return isStale(summary(), now.count());
 }
 
 float MediaStreamStatistics::getFrameRate() const
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    const auto elapsed = steady_clock::now() - m_lastDataTimer;
-    if (m_data.empty() || elapsed > m_windowSize)
+    const Summary summary = this->summary();
+    if (isStale(summary, steadyClockUs()) || summary.intervalUs <= 0)
         return 0;
-    const auto interval = intervalUnsafe().count();
-    if (interval > 0)
-        return (m_data.size() - 1) * 1'000'000.0F / interval;
-    return 0;
+    return (summary.frameCount - 1) * 1'000'000.0F / summary.intervalUs;
 }
 
-microseconds MediaStreamStatistics::intervalUnsafe() const
+float MediaStreamStatistics::getAverageGopSize() const
 {
-    return m_data.rbegin()->timestamp - m_data.begin()->timestamp;
+    const Summary summary = this->summary();
+    return summary.keyFrameCount > 0 ? summary.frameCount / (float) summary.keyFrameCount : 0;
 }
 
-float MediaStreamStatistics::getAverageGopSize() const
+void MediaStreamStatistics::popOldest()
+{
+    const Data& data = m_data[m_oldestIndex];
+    m_totalSizeBytes -= data.size;
+    if (data.isKeyFrame)
+        --m_keyFrameCount;
+    m_oldestIndex = (m_oldestIndex + 1) % kCapacity;
+    --m_frameCount;
+}
+
+void MediaStreamStatistics::clear()
+{
+    m_oldestIndex = 0;
+    m_frameCount = 0;
+    m_totalSizeBytes = 0;
+    m_keyFrameCount = 0;
+}
+
+void MediaStreamStatistics::publish(int64_t lastDataTimeUs)
+{
+    int64_t newestSizeBytes = 0;
+    int64_t intervalUs = 0;
+    if (m_frameCount > 0)
+    {
+        const Data& newest = m_data[(m_oldestIndex + m_frameCount - 1) % kCapacity];
+        newestSizeBytes = newest.size;
+        intervalUs = newest.timestampUs - m_data[m_oldestIndex].timestampUs;
+    }
+
+    const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_publishedFrameCount.store(m_frameCount, std::memory_order_relaxed);
+    m_publishedTotalSizeBytes.store(m_totalSizeBytes, std::memory_order_relaxed);
+    m_publishedNewestSizeBytes.store(newestSizeBytes, std::memory_order_relaxed);
+    m_publishedKeyFrameCount.store(m_keyFrameCount, std::memory_order_relaxed);
+    m_publishedIntervalUs.store(intervalUs, std::memory_order_relaxed);
+    m_publishedLastDataTimeUs.store(lastDataTimeUs, std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+MediaStreamStatistics::Summary MediaStreamStatistics::summary() const
+{
+    Summary summary;
+    for (;;)
+    {
+        const uint64_t sequence = m_sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0)
+            continue; //< The producer is in the middle of an update, which is a few stores.
+
+        summary.frameCount = m_publishedFrameCount.load(std::memory_order_relaxed);
+        summary.totalSizeBytes = m_publishedTotalSizeBytes.load(std::memory_order_relaxed);
+        summary.newestSizeBytes = m_publishedNewestSizeBytes.load(std::memory_order_relaxed);
+        summary.keyFrameCount = m_publishedKeyFrameCount.load(std::memory_order_relaxed);
+        summary.intervalUs = m_publishedIntervalUs.load(std::memory_order_relaxed);
+        summary.lastDataTimeUs = m_publishedLastDataTimeUs.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == sequence)
+            return summary;
+    }
+}
+
+bool MediaStreamStatistics::isStale(const Summary& summary, int64_t nowUs) const
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    const size_t keyFrames = std::count_if(m_data.begin(), m_data.end(),
-        [](const auto& value) { return value.isKeyFrame; });
-    return keyFrames > 0 ? m_data.size() / (float) keyFrames : 0;
+    return summary.frameCount == 0
+        || nowUs - summary.lastDataTimeUs > m_windowSizeUs.load(std::memory_order_relaxed);
 }
 
 } // namespace nx::sdk
@@ -2,60 +2,106 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <deque>
-#include <limits>
-#include <mutex>
+#include <cstdint>
 
 namespace nx::sdk {
 
 /**
- * This class calculates media stream bitrate, average frame rate and GOP size.
+ * This class calculates media stream bitrate, average frame rate and GOP size over a sliding
+ * window.
+ *
+ * The frames of the window are kept in a fixed-capacity ring with running sums, so each call is
+ * O(1) and never allocates or locks. The stream is fed by a single producer thread - onData() and
+ * reset() must not be called concurrently - while the statistics can be read from any thread: the
+ * producer publishes a consistent summary of the window via a sequence lock.
+ *
+ * The frames are expected in the timestamp order; a frame older than the newest one is counted
+ * as if it had the newest timestamp, and a step back in time of the window size or more, e.g. on
+ * a stream time change, restarts the statistics.
  */
-
 class MediaStreamStatistics
 {
 public:
+    /** The window never holds more frames; the oldest ones are dropped. */
+    static constexpr int kCapacity = 512;
+
     MediaStreamStatistics(
         std::chrono::microseconds windowSize = std::chrono::seconds(2),
         int maxDurationInFrames = 0);
 
+    /** Takes effect on the next onData(). */
     void setWindowSize(std::chrono::microseconds windowSize);
+
+    std::chrono::microseconds windowSize() const;
+
+    /** Takes effect on the next onData(); values above kCapacity are limited to it. */
     void setMaxDurationInFrames(int maxDurationInFrames);
 
+    /** To be called by the producer thread. */
     void reset();
+
+    /** To be called by the producer thread. */
     void onData(std::chrono::microseconds timestamp, size_t dataSize, bool isKeyFrame);
+
     int64_t bitrateBitsPerSecond() const;
     float getFrameRate() const;
     float getAverageGopSize() const;
     bool hasMediaData() const;
 
-private:
-    std::chrono::microseconds m_windowSize {};
-    int m_maxDurationInFrames = 0;
+    /**
+     * @param now Steady clock.
+     * @return Whether the window is empty, or onData() has not been called for longer than the
+     *     window size; the bitrate and the frame rate of a stale stream are 0.
+     */
+    bool isStale(std::chrono::microseconds now) const;
 
+private:
     struct Data
     {
-        Data() = default;
-        Data(std::chrono::microseconds timestamp, size_t size, bool isKeyFrame):
-            timestamp(timestamp), size(size), isKeyFrame(isKeyFrame)
-        {
-        }
-
-        std::chrono::microseconds timestamp{};
-        size_t size = 0;
+        int64_t timestampUs = 0;
+        int64_t size = 0;
         bool isKeyFrame = false;
+    };
 
-        bool operator<(std::chrono::microseconds value) const { return timestamp < value; }
+    /** Consistent view of the window, as published by the producer. */
+    struct Summary
+    {
+        int64_t frameCount = 0;
+        int64_t totalSizeBytes = 0;
+        int64_t newestSizeBytes = 0;
+        int64_t keyFrameCount = 0;
+        int64_t intervalUs = 0; //< From the oldest frame to the newest one.
+        int64_t lastDataTimeUs = 0; //< Steady clock; when onData() was last called.
     };
 
-    std::chrono::microseconds intervalUnsafe() const;
+    void popOldest();
+    void clear();
+    void publish(int64_t lastDataTimeUs);
+    Summary summary() const;
+    bool isStale(const Summary& summary, int64_t nowUs) const;
 
-    mutable std::mutex m_mutex;
-    std::deque<Data> m_data;
+private:
+    std::atomic<int64_t> m_windowSizeUs{0};
+    std::atomic<int> m_maxDurationInFrames{0};
+
+    // Accessed only by the producer.
+    std::array<Data, kCapacity> m_data{};
+    int m_oldestIndex = 0;
+    int m_frameCount = 0;
     int64_t m_totalSizeBytes = 0;
-    //nx::utils::ElapsedTimer m_lastDataTimer;
-    std::chrono::steady_clock::time_point m_lastDataTimer;
+    int64_t m_keyFrameCount = 0;
+
+    // Sequence lock: odd while the producer is updating the published fields.
+    std::atomic<uint64_t> m_sequence{0};
+    std::atomic<int64_t> m_publishedFrameCount{0};
+    std::atomic<int64_t> m_publishedTotalSizeBytes{0};
+    std::atomic<int64_t> m_publishedNewestSizeBytes{0};
+    std::atomic<int64_t> m_publishedKeyFrameCount{0};
+    std::atomic<int64_t> m_publishedIntervalUs{0};
+    std::atomic<int64_t> m_publishedLastDataTimeUs{0};
 };
 
 } // namespace nx::sdk
@@ -2,122 +2,162 @@
 
 #include "uuid_helper.h"
 
-#include <limits>
-#include <sstream>
-#include <iomanip>
-#include <cstdlib>
-
-#include <nx/kit/debug.h>
+#include <array>
 #include <chrono>
 #include <random>
 #include <stdint.h>
-#include <mutex>
 
 namespace nx::sdk {
 
 namespace UuidHelper {
 
-Uuid fromStdString(const std::string& str)
+namespace {
+
+constexpr int8_t kInvalidChar = -1;
+constexpr int8_t kSkippedChar = -2;
+
+/** Value of each hex digit char; kSkippedChar for the separators, kInvalidChar for the rest. */
+constexpr std::array<int8_t, 256> makeHexDigitValues()
 {
-    static const int kMinUuidStrSize = 32;
+    std::array<int8_t, 256> values{};
+    for (int c = 0; c < 256; ++c)
+        values[c] = kInvalidChar;
+    for (int c = '0'; c <= '9'; ++c)
+        values[c] = (int8_t) (c - '0');
+    for (int c = 'a'; c <= 'f'; ++c)
+        values[c] = (int8_t) (c - 'a' + 10);
+    for (int c = 'A'; c <= 'F'; ++c)
+        values[c] = (int8_t) (c - 'A' + 10);
+    for (const char c: {'{', '}', '-', '\t', '\n', '\r', ' '})
+        values[(uint8_t) c] = kSkippedChar;
+    return values;
+}
 
-    if ((int) str.size() < kMinUuidStrSize)
-        return Uuid();
+constexpr std::array<int8_t, 256> kHexDigitValues = makeHexDigitValues();
 
-    Uuid uuid;
-    int currentByteIndex = 0;
-    std::string currentByteString;
-    for (const char c: str)
+constexpr char kLowercaseHexDigits[] = "0123456789abcdef";
+constexpr char kUppercaseHexDigits[] = "0123456789ABCDEF";
+
+/**
+ * Fast path for the strings as made by toStdString(), with all the hex digit pairs at the known
+ * offsets: checks the whole string for validity at once, without per-char branches.
+ */
+bool fromCanonicalString(const char* str, size_t size, Uuid* uuid)
+{
+    bool hasHyphens = false;
+    if (size == 38)
+    {
+        if (str[0] != '{' || str[37] != '}')
+            return false;
+        ++str;
+        hasHyphens = true;
+    }
+    else if (size == 36)
+    {
+        hasHyphens = true;
+    }
+    else if (size != 32)
+    {
+        return false;
+    }
+    if (hasHyphens && (str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-'))
+        return false;
+
+    Uuid result;
+    int8_t invalidBits = 0; //< Sign bit is set if any char is not a hex digit.
+    for (int i = 0; i < Uuid::kSize; ++i)
     {
-        switch (c)
-        {
-            case '{': case '}': case '-': case '\t': case '\n': case 'r': case ' ':
-                continue;
-        }
-
-        if (currentByteIndex >= (int) sizeof(Uuid))
-            return Uuid();
-
-        currentByteString += c;
-        if (currentByteString.size() == 2)
-        {
-            char* pEnd = nullptr;
-            errno = 0; //< Required before strtol().
-            const long v = std::strtol(currentByteString.c_str(), &pEnd, /*base*/ 16);
-            const bool hasError =
-                v > std::numeric_limits<uint8_t>::max()
-                || v < std::numeric_limits<uint8_t>::min()
-                || errno != 0
-                || *pEnd != '\0';
-
-            if (hasError)
-                return Uuid();
-
-            uuid[currentByteIndex] = (uint8_t) v;
-            ++currentByteIndex;
-            currentByteString.clear();
-        }
+        const int offset = hasHyphens
+            ? 2 * i + (i >= 4) + (i >= 6) + (i >= 8) + (i >= 10)
+            : 2 * i;
+        const int8_t high = kHexDigitValues[(uint8_t) str[offset]];
+        const int8_t low = kHexDigitValues[(uint8_t) str[offset + 1]];
+        invalidBits |= high | low;
+        result[i] = (uint8_t) ((high << 4) | (low & 0x0F));
     }
+    if (invalidBits < 0)
+        return false;
+
+    *uuid = result;
+    return true;
+}
 
-    if (currentByteIndex != sizeof(Uuid))
-        return Uuid();
+} // namespace
 
+bool fromString(const char* str, size_t size, Uuid* uuid)
+{
+    static constexpr int kDigitCount = 2 * Uuid::kSize;
+
+    if (fromCanonicalString(str, size, uuid))
+        return true;
+
+    Uuid result;
+    int digitCount = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        const int8_t value = kHexDigitValues[(uint8_t) str[i]];
+        if (value == kSkippedChar)
+            continue;
+        if (value == kInvalidChar || digitCount == kDigitCount)
+            return false;
+
+        if (digitCount % 2 == 0)
+            result[digitCount / 2] = (uint8_t) (value << 4);
+        else
+            result[digitCount / 2] |= (uint8_t) value;
+        ++digitCount;
+    }
+
+    if (digitCount != kDigitCount)
+        return false;
+
+    *uuid = result;
+    return true;
+}
+
+Uuid fromStdString(const std::string& str)
+{
+    Uuid uuid;
+    fromString(str.data(), str.size(), &uuid);
     return uuid;
 }
 
-std::string toStdString(const Uuid& uuid, FormatOptions formatOptions)
+int toChars(const Uuid& uuid, char* buffer, FormatOptions formatOptions)
 {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
+    const char* const digits = (formatOptions & FormatOptions::uppercase)
+        ? kUppercaseHexDigits
+        : kLowercaseHexDigits;
+    const bool hasHyphens = formatOptions & FormatOptions::hyphens;
 
+    char* p = buffer;
     if (formatOptions & FormatOptions::braces)
-        ss << '{';
-    if (formatOptions & FormatOptions::uppercase)
-        ss << std::uppercase;
-    for (int i = 0; i < 4; ++i)
-        ss << std::setw(2) << (int) uuid[i];
-    if (formatOptions & FormatOptions::hyphens)
-        ss << '-';
-    for (int i = 0; i < 2; ++i)
-        ss << std::setw(2) << (int) uuid[4 + i];
-    if (formatOptions & FormatOptions::hyphens)
-        ss << "-";
-    for (int i = 0; i < 2; ++i)
-        ss << std::setw(2) << (int) uuid[6 + i];
-    if (formatOptions & FormatOptions::hyphens)
-        ss << "-";
-    for (int i = 0; i < 2; ++i)
-        ss << std::setw(2) << (int) uuid[8 + i];
-    if (formatOptions & FormatOptions::hyphens)
-        ss << "-";
-    for (int i = 0; i < 6; ++i)
-        ss << std::setw(2) << (int) uuid[10 + i];
+        *p++ = '{';
+    for (int i = 0; i < Uuid::kSize; ++i)
+    {
+        // Groups of 4-2-2-2-6 bytes.
+        if (hasHyphens && (i == 4 || i == 6 || i == 8 || i == 10))
+            *p++ = '-';
+        *p++ = digits[uuid[i] >> 4];
+        *p++ = digits[uuid[i] & 0x0F];
+    }
     if (formatOptions & FormatOptions::braces)
-        ss << '}';
+        *p++ = '}';
 
-    return ss.str();
+    return (int) (p - buffer);
+}
+
+std::string toStdString(const Uuid& uuid, FormatOptions formatOptions)
+{
+    char buffer[kMaxStringSize];
+    return std::string(buffer, toChars(uuid, buffer, formatOptions));
 }
 
 class RandomGenerator64Bit
 {
 public:
-    RandomGenerator64Bit():
-        m_generator(getSeed()),
-        m_distibution(0, std::numeric_limits<uint64_t>::max())
-    {
-    }
+    RandomGenerator64Bit(): m_generator(getSeed()) {}
 
-    uint64_t value64()
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_distibution(m_generator);
-    }
-
-    std::array<uint64_t, 2> value128()
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return { m_distibution(m_generator), m_distibution(m_generator) };
-    }
+    std::array<uint64_t, 2> value128() { return {m_generator(), m_generator()}; }
 
 private:
     uint64_t getSeed()
@@ -128,19 +168,18 @@ private:
             return time.count() ^ (uintptr_t) this;
         #else
             std::random_device r;
-            return r();
+            return ((uint64_t) r() << 32) ^ r();
         #endif
     }
 
 private:
     std::mt19937_64 m_generator;
-    std::uniform_int_distribution<uint64_t> m_distibution;
-    std::mutex m_mutex;
 };
 
 Uuid randomUuid()
 {
-    static RandomGenerator64Bit generator;
+    // Per thread, so that the threads emitting objects do not contend for a lock.
+    thread_local RandomGenerator64Bit generator;
 
     Uuid uuid;
     memcpy(uuid.data(), generator.value128().data(), sizeof(Uuid));
@@ -22,7 +22,14 @@ namespace UuidHelper
         return result;
     }
 
-    /** @return Null uuid on error. */
+    /**
+     * Parses 32 hex digits, in any case, ignoring braces, hyphens and whitespace around and
+     * between them. Does not throw or allocate.
+     * @return Whether the string is a valid uuid; if not, the uuid is left intact.
+     */
+    bool fromString(const char* str, size_t size, Uuid* uuid);
+
+    /** @return Null uuid on error; see fromString(). */
     Uuid fromStdString(const std::string& str);
 
     enum FormatOptions
@@ -34,9 +41,21 @@ namespace UuidHelper
         all = 0xFF
     };
 
+    /** Length of the string representation with all the FormatOptions. */
+    constexpr int kMaxStringSize = 38;
+
+    /**
+     * Writes the string representation according to RFC-1422, without the terminating '\0'.
+     * Does not allocate.
+     * @param buffer At least kMaxStringSize chars.
+     * @return Number of chars written.
+     */
+    int toChars(const Uuid& uuid, char* buffer, FormatOptions formatOptions = FormatOptions::all);
+
     /** @return String representation according to RFC-1422. */
     std::string toStdString(const Uuid& uuid, FormatOptions formatOptions = FormatOptions::all);
 
+    /** Version 4 uuid. Thread-safe and lock-free: each thread has its own generator. */
     Uuid randomUuid();
 }
 
@@ -49,7 +68,8 @@ namespace std {
 
 inline std::ostream& operator<<(std::ostream& os, const nx::sdk::Uuid& uuid)
 {
-    return os << nx::sdk::UuidHelper::toStdString(uuid);
+    char buffer[nx::sdk::UuidHelper::kMaxStringSize];
+    return os.write(buffer, nx::sdk::UuidHelper::toChars(uuid, buffer));
 }
 
 template<>